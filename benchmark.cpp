@@ -0,0 +1,218 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    benchmark.cpp
+ * \author  Sean Phay
+ * \date    2023
+ * \brief   Small benchmark harness (command line and JSON output follow Google Benchmark).
+ */
+//----------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <regex>
+#include <thread>
+#include "benchmark.h"
+
+// one registered case with one of its arguments
+typedef struct _BenchmarkCase {
+  std::string       name;
+  BenchmarkFunction function;
+  long long         argument;
+} BenchmarkCase;
+
+// measured result of one case
+typedef struct _BenchmarkResult {
+  std::string name;
+  size_t      iterations;
+  double      realTime;        // nanoseconds per iteration
+  double      cpuTime;
+  double      itemsPerSecond;  // zero if the case does not count the items
+} BenchmarkResult;
+
+const size_t BENCHMARK_MAX_ITERATIONS = 1000000000;
+
+std::vector<BenchmarkCase>& registeredBenchmarks() {
+  static std::vector<BenchmarkCase> cases;
+  return cases;
+}
+
+// ----------------------------------------------------------------------------------------
+// START OF STATE FUNCTIONS
+
+BenchmarkState::BenchmarkState(size_t iterations, long long argument)
+  : iterations(iterations), done(0), value(argument), items(0), realSeconds(0.0), cpuSeconds(0.0), cpuStart(0.0) {
+}
+
+void BenchmarkState::startTimer() {
+  cpuStart = double(std::clock()) / CLOCKS_PER_SEC;
+  realStart = std::chrono::steady_clock::now();
+}
+
+void BenchmarkState::stopTimer() {
+  realSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - realStart).count();
+  cpuSeconds = double(std::clock()) / CLOCKS_PER_SEC - cpuStart;
+}
+
+// END OF STATE FUNCTIONS
+// ----------------------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------------------
+// START OF HARNESS FUNCTIONS
+
+void registerBenchmark(const std::string& name, BenchmarkFunction function, const std::vector<long long>& arguments) {
+  if (arguments.empty()) {
+    BenchmarkCase benchmarkCase = { name, function, 0 };
+    registeredBenchmarks().push_back(benchmarkCase);
+  }
+  for (size_t i = 0; i < arguments.size(); i++) {
+    BenchmarkCase benchmarkCase = { name + "/" + std::to_string(arguments[i]), function, arguments[i] };
+    registeredBenchmarks().push_back(benchmarkCase);
+  }
+}
+
+// iterations are increased until the case runs at least minTime (the same scheme as Google Benchmark)
+BenchmarkResult measureBenchmark(const BenchmarkCase& benchmarkCase, double minTime) {
+  size_t iterations = 1;
+
+  while (true) {
+    BenchmarkState state(iterations, benchmarkCase.argument);
+    benchmarkCase.function(state);
+
+    if (state.realSeconds >= minTime || iterations >= BENCHMARK_MAX_ITERATIONS) {
+      BenchmarkResult result;
+      result.name = benchmarkCase.name;
+      result.iterations = iterations;
+      result.realTime = 1e9 * state.realSeconds / iterations;
+      result.cpuTime = 1e9 * state.cpuSeconds / iterations;
+      result.itemsPerSecond = (state.items > 0 && state.realSeconds > 0.0) ? state.items / state.realSeconds : 0.0;
+      return result;
+    }
+
+    // aim 40 % over the minimum, grow at most ten times per step
+    double multiplier = (state.realSeconds > 0.0) ? 1.4 * minTime / state.realSeconds : 10.0;
+    multiplier = std::min(std::max(multiplier, 2.0), 10.0);
+    iterations = std::min(size_t(iterations * multiplier), BENCHMARK_MAX_ITERATIONS);
+  }
+}
+
+std::string escapeJson(const std::string& text) {
+  std::string escaped;
+  for (size_t i = 0; i < text.size(); i++) {
+    if (text[i] == '"' || text[i] == '\\')
+      escaped += '\\';
+    escaped += text[i];
+  }
+  return escaped;
+}
+
+void writeJson(std::ostream& out, const std::vector<BenchmarkResult>& results, const std::string& executable) {
+  char date[64];
+  std::time_t now = std::time(NULL);
+  std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+  out << "{\n";
+  out << "  \"context\": {\n";
+  out << "    \"date\": \"" << date << "\",\n";
+  out << "    \"executable\": \"" << escapeJson(executable) << "\",\n";
+  out << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n";
+#ifdef NDEBUG
+  out << "    \"library_build_type\": \"release\"\n";
+#else
+  out << "    \"library_build_type\": \"debug\"\n";
+#endif
+  out << "  },\n";
+  out << "  \"benchmarks\": [\n";
+  for (size_t i = 0; i < results.size(); i++) {
+    const BenchmarkResult& result = results[i];
+    out << "    {\n";
+    out << "      \"name\": \"" << escapeJson(result.name) << "\",\n";
+    out << "      \"run_name\": \"" << escapeJson(result.name) << "\",\n";
+    out << "      \"run_type\": \"iteration\",\n";
+    out << "      \"iterations\": " << result.iterations << ",\n";
+    out << "      \"real_time\": " << result.realTime << ",\n";
+    out << "      \"cpu_time\": " << result.cpuTime << ",\n";
+    if (result.itemsPerSecond > 0.0)
+      out << "      \"items_per_second\": " << result.itemsPerSecond << ",\n";
+    out << "      \"time_unit\": \"ns\"\n";
+    out << "    }" << (i + 1 < results.size() ? "," : "") << "\n";
+  }
+  out << "  ]\n";
+  out << "}\n";
+}
+
+int runBenchmarks(int argc, char** argv) {
+  std::string filter = ".*";
+  std::string outFile;
+  std::string format = "console";
+  double minTime = 0.5;
+
+  for (int i = 1; i < argc; i++) {
+    std::string option = argv[i];
+    std::string value = option.substr(option.find('=') + 1);
+
+    if (option.compare(0, 19, "--benchmark_filter=") == 0)
+      filter = value;
+    else if (option.compare(0, 21, "--benchmark_min_time=") == 0)
+      minTime = std::atof(value.c_str());
+    else if (option.compare(0, 19, "--benchmark_format=") == 0)
+      format = value;
+    else if (option.compare(0, 16, "--benchmark_out=") == 0)
+      outFile = value;
+    else {
+      std::cerr << "runBenchmarks(): Unknown option \"" << option << "\"." << std::endl;
+      return 1;
+    }
+  }
+
+  std::regex pattern;
+  try {
+    pattern = std::regex(filter);
+  }
+  catch (const std::regex_error&) {
+    std::cerr << "runBenchmarks(): Invalid filter \"" << filter << "\"." << std::endl;
+    return 1;
+  }
+
+  const std::vector<BenchmarkCase>& cases = registeredBenchmarks();
+  std::vector<BenchmarkResult> results;
+
+  if (format == "console")
+    printf("%-40s %15s %15s %12s\n", "Benchmark", "Time (ns)", "CPU (ns)", "Iterations");
+
+  for (size_t i = 0; i < cases.size(); i++) {
+    if (!std::regex_search(cases[i].name, pattern))
+      continue;
+
+    BenchmarkResult result = measureBenchmark(cases[i], minTime);
+    results.push_back(result);
+
+    if (format == "console") {
+      printf("%-40s %15.1f %15.1f %12zu", result.name.c_str(), result.realTime, result.cpuTime, result.iterations);
+      if (result.itemsPerSecond > 0.0)
+        printf("  items/s=%.4g", result.itemsPerSecond);
+      printf("\n");
+      fflush(stdout);
+    }
+  }
+
+  if (format == "json")
+    writeJson(std::cout, results, argv[0]);
+
+  if (!outFile.empty()) {
+    std::ofstream out(outFile.c_str());
+    if (!out) {
+      std::cerr << "runBenchmarks(): Cannot create file \"" << outFile << "\"." << std::endl;
+      return 1;
+    }
+    writeJson(out, results, argv[0]);
+  }
+
+  return 0;
+}
+
+// END OF HARNESS FUNCTIONS
+// ----------------------------------------------------------------------------------------
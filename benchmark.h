@@ -0,0 +1,91 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    benchmark.h
+ * \author  Sean Phay
+ * \date    2023
+ * \brief   Small benchmark harness (command line and JSON output follow Google Benchmark).
+ */
+//----------------------------------------------------------------------------------------
+
+#ifndef __BENCHMARK_H
+#define __BENCHMARK_H
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+// state of one run of a benchmark case
+class BenchmarkState {
+public:
+  BenchmarkState(size_t iterations, long long argument);
+
+  /// Runs the measured loop: while (state.keepRunning()) { ... }
+  /** The timer starts with the first call, code before the loop (setup) is not measured. */
+  bool keepRunning() {
+    if (done == 0)
+      startTimer();
+    if (done == iterations) {
+      stopTimer();
+      return false;
+    }
+    done++;
+    return true;
+  }
+
+  /// Argument of the case (number of objects, ...), zero for cases without arguments.
+  long long argument() const { return value; }
+
+  /// Number of processed items, reported as items per second.
+  void setItemsProcessed(long long count) { items = count; }
+
+  size_t    iterations;
+  size_t    done;
+  long long value;
+  long long items;
+  double    realSeconds;
+  double    cpuSeconds;
+
+private:
+  void startTimer();
+  void stopTimer();
+
+  std::chrono::steady_clock::time_point realStart;
+  double cpuStart;
+};
+
+typedef void (*BenchmarkFunction)(BenchmarkState& state);
+
+//**************************************************************************************************
+/// Registers a benchmark case.
+/**
+ \param[in]  name        Name of the case, "/<argument>" is appended for every argument.
+ \param[in]  function    Measured function.
+ \param[in]  arguments   Values passed to the case through BenchmarkState::argument(), the case runs once without them.
+*/
+void registerBenchmark(const std::string& name, BenchmarkFunction function, const std::vector<long long>& arguments = std::vector<long long>());
+
+//**************************************************************************************************
+/// Runs the registered cases and prints the results.
+/**
+ Accepted options:
+   --benchmark_filter=<regex>     runs only the matching cases
+   --benchmark_min_time=<s>       minimal measured time of one case (0.5 s by default)
+   --benchmark_format=<console|json>  format of the standard output
+   --benchmark_out=<file>         writes the JSON results into a file
+
+ \return                 Exit code of the program.
+*/
+int runBenchmarks(int argc, char** argv);
+
+/// Keeps the compiler from removing the computation of a value which is not used.
+template <typename T>
+inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : : "r,m"(value) : "memory");
+#else
+  static volatile char sink;
+  sink = *reinterpret_cast<const volatile char*>(&value);
+#endif
+}
+
+#endif // __BENCHMARK_H
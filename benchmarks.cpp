@@ -0,0 +1,546 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    benchmarks.cpp
+ * \author  Sean Phay
+ * \date    2023
+ * \brief   Benchmarks of the math and simulation hot paths (no OpenGL needed).
+ */
+//----------------------------------------------------------------------------------------
+
+#include <random>
+#include <vector>
+#include "benchmark.h"
+#include "collision.h"
+#include "entities.h"
+#include "flock.h"
+#include "jobs.h"
+#include "projectiles.h"
+#include "replay.h"
+#include "simulation.h"
+#include "spline.h"
+#include "transform.h"
+#include "data.h"
+
+// inputs are taken from a small table so that the loop measures the function, not the memory
+const size_t INPUT_COUNT = 1024;
+
+// object counts of the simulation cases (10 ... 1M)
+const std::vector<long long> OBJECT_COUNTS = { 10, 100, 1000, 10000, 100000, 1000000 };
+
+// missile counts of the collision cases, every missile is tested against COLLISION_TARGETS spheres
+const std::vector<long long> COLLISION_COUNTS = { 100, 1000, 10000, 100000 };
+const size_t COLLISION_TARGETS = 256;
+
+// ----------------------------------------------------------------------------------------
+// START OF HELPER FUNCTIONS
+
+// random points in range -range ... range, always the same
+std::vector<glm::vec3> randomPoints(size_t count, float range, unsigned int seed) {
+  std::mt19937 engine(seed);
+  std::vector<glm::vec3> points(count);
+
+  for (size_t i = 0; i < count; i++) {
+    points[i] = glm::vec3(
+      range * ((engine() >> 8) * (2.0f / 16777216.0f) - 1.0f),
+      range * ((engine() >> 8) * (2.0f / 16777216.0f) - 1.0f),
+      range * ((engine() >> 8) * (2.0f / 16777216.0f) - 1.0f)
+    );
+  }
+  return points;
+}
+
+// missiles at random positions flying in random directions, the same in every case
+std::vector<MissileObject> randomMissiles(size_t count) {
+  std::vector<glm::vec3> positions = randomPoints(count, SCENE_WIDTH, 8);
+  std::vector<glm::vec3> directions = randomPoints(count, 1.0f, 9);
+  std::vector<MissileObject> missiles(count);
+
+  for (size_t m = 0; m < count; m++) {
+    MissileObject& missile = missiles[m];
+    missile.position = positions[m];
+    missile.direction = glm::normalize(directions[m] + glm::vec3(1e-3f));
+    missile.speed = MISSILE_SPEED;
+    missile.size = MISSILE_SIZE;
+    missile.destroyed = false;
+    missile.startTime = 0.0f;
+    missile.currentTime = 0.0f;
+  }
+  return missiles;
+}
+
+// targets above the scene - nothing is hit, every iteration tests all pairs
+std::vector<Object> unreachableTargets(size_t count) {
+  std::vector<glm::vec3> positions = randomPoints(count, SCENE_WIDTH, 10);
+  std::vector<Object> targets(count);
+
+  for (size_t t = 0; t < count; t++) {
+    targets[t].position = positions[t] + glm::vec3(0.0f, 0.0f, 10.0f);
+    targets[t].size = ROCK_SIZE;
+    targets[t].destroyed = false;
+  }
+  return targets;
+}
+
+// END OF HELPER FUNCTIONS
+// ----------------------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------------------
+// START OF MATH BENCHMARKS
+
+void benchmarkCheckBounds(BenchmarkState& state) {
+  // positions up to one scene size outside the borders - wrapped without the warning print
+  std::vector<glm::vec3> points = randomPoints(INPUT_COUNT, 2.0f * SCENE_WIDTH, 1);
+  size_t i = 0;
+
+  while (state.keepRunning()) {
+    doNotOptimize(checkBounds(points[i], PENGUIN_SIZE));
+    i = (i + 1) & (INPUT_COUNT - 1);
+  }
+  state.setItemsProcessed(state.iterations);
+}
+
+// position counts of the array wrapping cases
+const std::vector<long long> WRAP_COUNTS = { 1000, 1000000 };
+
+// checkBounds() called for every position of an array, as updateMissiles() does
+void benchmarkCheckBoundsArray(BenchmarkState& state) {
+  std::vector<glm::vec3> points = randomPoints(size_t(state.argument()), 2.0f * SCENE_WIDTH, 13);
+
+  while (state.keepRunning()) {
+    for (size_t p = 0; p < points.size(); p++)
+      points[p] = checkBounds(points[p], MISSILE_SIZE);
+    doNotOptimize(points[0]);
+  }
+  state.setItemsProcessed(state.iterations * points.size());
+}
+
+// the same positions wrapped by checkBoundsBatch() with one implementation (COLLISION_KERNEL_*)
+template <int kernel>
+void benchmarkCheckBoundsBatch(BenchmarkState& state) {
+  std::vector<glm::vec3> points = randomPoints(size_t(state.argument()), 2.0f * SCENE_WIDTH, 13);
+  std::vector<float> positionsX(points.size()), positionsY(points.size()), sizes(points.size(), MISSILE_SIZE);
+  for (size_t p = 0; p < points.size(); p++) {
+    positionsX[p] = points[p].x;
+    positionsY[p] = points[p].y;
+  }
+
+  selectCollisionKernel(kernel);
+
+  while (state.keepRunning()) {
+    checkBoundsBatch(positionsX.data(), positionsY.data(), sizes.data(), points.size());
+    doNotOptimize(positionsX[0]);
+  }
+  state.setItemsProcessed(state.iterations * points.size());
+
+  selectCollisionKernel(COLLISION_KERNEL_AVX2) || selectCollisionKernel(COLLISION_KERNEL_SSE2);
+}
+
+void benchmarkPointInSphere(BenchmarkState& state) {
+  std::vector<glm::vec3> points = randomPoints(INPUT_COUNT, 1.0f, 2);
+  size_t i = 0;
+
+  while (state.keepRunning()) {
+    doNotOptimize(pointInSphere(points[i], points[(i + 1) & (INPUT_COUNT - 1)], 0.5f));
+    i = (i + 1) & (INPUT_COUNT - 1);
+  }
+  state.setItemsProcessed(state.iterations);
+}
+
+void benchmarkSpheresIntersection(BenchmarkState& state) {
+  std::vector<glm::vec3> points = randomPoints(INPUT_COUNT, 1.0f, 3);
+  size_t i = 0;
+
+  while (state.keepRunning()) {
+    doNotOptimize(spheresIntersection(points[i], 0.25f, points[(i + 1) & (INPUT_COUNT - 1)], 0.25f));
+    i = (i + 1) & (INPUT_COUNT - 1);
+  }
+  state.setItemsProcessed(state.iterations);
+}
+
+// one sphere against BATCH_SPHERES spheres with one implementation (COLLISION_KERNEL_*)
+const size_t BATCH_SPHERES = 4096;
+
+template <int kernel>
+void benchmarkSpheresIntersectionBatch(BenchmarkState& state) {
+  std::vector<glm::vec3> centers = randomPoints(BATCH_SPHERES, 1.0f, 11);
+  std::vector<glm::vec3> tested = randomPoints(INPUT_COUNT, 1.0f, 12);
+  std::vector<float> centersX(BATCH_SPHERES), centersY(BATCH_SPHERES), centersZ(BATCH_SPHERES), radii(BATCH_SPHERES, 0.05f);
+  std::vector<uint64_t> hitMask(BATCH_SPHERES / 64);
+  for (size_t s = 0; s < BATCH_SPHERES; s++) {
+    centersX[s] = centers[s].x;
+    centersY[s] = centers[s].y;
+    centersZ[s] = centers[s].z;
+  }
+
+  selectCollisionKernel(kernel);
+  size_t i = 0;
+
+  while (state.keepRunning()) {
+    doNotOptimize(spheresIntersectionBatch(tested[i], 0.05f, centersX.data(), centersY.data(), centersZ.data(), radii.data(), BATCH_SPHERES, hitMask.data()));
+    i = (i + 1) & (INPUT_COUNT - 1);
+  }
+  state.setItemsProcessed(state.iterations * BATCH_SPHERES);
+
+  // the next cases use the best implementation again
+  selectCollisionKernel(COLLISION_KERNEL_AVX2) || selectCollisionKernel(COLLISION_KERNEL_SSE2);
+}
+
+void benchmarkAlignObject(BenchmarkState& state) {
+  std::vector<glm::vec3> positions = randomPoints(INPUT_COUNT, 1.0f, 4);
+  std::vector<glm::vec3> directions = randomPoints(INPUT_COUNT, 1.0f, 5);
+  const glm::vec3 up(0.0f, 0.0f, 1.0f);
+  size_t i = 0;
+
+  while (state.keepRunning()) {
+    doNotOptimize(alignObject(positions[i], directions[i], up));
+    i = (i + 1) & (INPUT_COUNT - 1);
+  }
+  state.setItemsProcessed(state.iterations);
+}
+
+void benchmarkEvaluateClosedCurve(BenchmarkState& state) {
+  float t = 0.0f;
+
+  while (state.keepRunning()) {
+    doNotOptimize(evaluateClosedCurve(curveData, curveSize, t));
+    t += 0.01f;
+  }
+  state.setItemsProcessed(state.iterations);
+}
+
+void benchmarkEvaluateClosedCurve1stDerivative(BenchmarkState& state) {
+  float t = 0.0f;
+
+  while (state.keepRunning()) {
+    doNotOptimize(evaluateClosedCurve_1stDerivative(curveData, curveSize, t));
+    t += 0.01f;
+  }
+  state.setItemsProcessed(state.iterations);
+}
+
+// position, first and second derivative in one pass with one of the bases
+template <class Basis>
+void benchmarkEvaluateCurveSegmentBasis(BenchmarkState& state) {
+  std::vector<glm::vec3> points = randomPoints(INPUT_COUNT, 1.0f, 14);
+  size_t i = 0;
+  float t = 0.0f;
+
+  while (state.keepRunning()) {
+    doNotOptimize(evaluateCurveSegmentBasis<Basis>(points[i], points[i+1], points[i+2], points[i+3], t));
+    i = (i + 4) & (INPUT_COUNT - 1);
+    t = t < 0.99f ? t + 0.01f : 0.0f;
+  }
+  state.setItemsProcessed(state.iterations);
+}
+
+// the same curve and the same parameter steps through the arc length table
+void benchmarkEvaluateSplinePath(BenchmarkState& state) {
+  SplinePath path;
+  buildSplinePath(path, curveData, curveSize);
+  float distance = 0.0f;
+
+  while (state.keepRunning()) {
+    doNotOptimize(evaluateSplinePath(path, distance));
+    distance += 0.01f;
+  }
+  state.setItemsProcessed(state.iterations);
+}
+
+void benchmarkEvaluateSplinePathTangent(BenchmarkState& state) {
+  SplinePath path;
+  buildSplinePath(path, curveData, curveSize);
+  float distance = 0.0f;
+
+  while (state.keepRunning()) {
+    doNotOptimize(evaluateSplinePathTangent(path, distance));
+    distance += 0.01f;
+  }
+  state.setItemsProcessed(state.iterations);
+}
+
+// agent counts of the batch path cases
+const std::vector<long long> AGENT_COUNTS = { 1000, 10000, 100000 };
+
+// every agent at its own distance along the path, moved a little in every iteration
+std::vector<float> agentDistances(size_t count, float length) {
+  std::vector<float> distances(count);
+  for (size_t a = 0; a < count; a++)
+    distances[a] = length * float(a) / float(count);
+  return distances;
+}
+
+// positions and tangents of the agents by one call per agent each
+void benchmarkEvaluateSplinePathAgents(BenchmarkState& state) {
+  SplinePath path;
+  buildSplinePath(path, curveData, curveSize);
+  std::vector<float> distances = agentDistances(size_t(state.argument()), path.length);
+  std::vector<glm::vec3> positions(distances.size()), tangents(distances.size());
+
+  while (state.keepRunning()) {
+    for (size_t a = 0; a < distances.size(); a++) {
+      distances[a] += 0.001f;
+      positions[a] = evaluateSplinePath(path, distances[a]);
+      tangents[a] = evaluateSplinePathTangent(path, distances[a]);
+    }
+    doNotOptimize(positions[0]);
+    doNotOptimize(tangents[0]);
+  }
+  state.setItemsProcessed(state.iterations * distances.size());
+}
+
+// the same agents by evaluateSplinePathBatch()
+void benchmarkEvaluateSplinePathBatch(BenchmarkState& state) {
+  SplinePath path;
+  buildSplinePath(path, curveData, curveSize);
+  std::vector<float> distances = agentDistances(size_t(state.argument()), path.length);
+  std::vector<float> positionsX(distances.size()), positionsY(distances.size()), positionsZ(distances.size());
+  std::vector<float> tangentsX(distances.size()), tangentsY(distances.size()), tangentsZ(distances.size());
+
+  while (state.keepRunning()) {
+    for (size_t a = 0; a < distances.size(); a++)
+      distances[a] += 0.001f;
+    evaluateSplinePathBatch(
+      path, distances.data(), distances.size(),
+      positionsX.data(), positionsY.data(), positionsZ.data(),
+      tangentsX.data(), tangentsY.data(), tangentsZ.data()
+    );
+    doNotOptimize(positionsX[0]);
+    doNotOptimize(tangentsX[0]);
+  }
+  state.setItemsProcessed(state.iterations * distances.size());
+}
+
+// the matrix math of setTransformUniforms() - one drawn object
+void benchmarkTransformMatrices(BenchmarkState& state) {
+  std::vector<glm::vec3> positions = randomPoints(INPUT_COUNT, 1.0f, 6);
+  std::vector<glm::vec3> directions = randomPoints(INPUT_COUNT, 1.0f, 7);
+  std::vector<glm::mat4> modelMatrices(INPUT_COUNT);
+  for (size_t m = 0; m < INPUT_COUNT; m++)
+    modelMatrices[m] = alignObject(positions[m], directions[m], glm::vec3(0.0f, 0.0f, 1.0f));
+
+  const glm::mat4 viewMatrix = alignObject(glm::vec3(0.0f, -1.0f, 0.5f), glm::vec3(0.0f, 1.0f, -0.5f), glm::vec3(0.0f, 0.0f, 1.0f));
+  glm::mat4 projectionMatrix(1.0f);
+  projectionMatrix[2][3] = -1.0f;
+  TransformMatrices matrices;
+  size_t i = 0;
+
+  while (state.keepRunning()) {
+    computeTransformMatrices(modelMatrices[i], viewMatrix, projectionMatrix, matrices);
+    doNotOptimize(matrices);
+    i = (i + 1) & (INPUT_COUNT - 1);
+  }
+  state.setItemsProcessed(state.iterations);
+}
+
+// END OF MATH BENCHMARKS
+// ----------------------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------------------
+// START OF SIMULATION BENCHMARKS
+
+// the time goes back and forth by one step => objects move but never expire
+float oscillatingTime(size_t iteration) {
+  return (iteration & 1) ? SIMULATION_TIMESTEP : 0.0f;
+}
+
+void benchmarkUpdateMissiles(BenchmarkState& state) {
+  std::vector<glm::vec3> positions = randomPoints(size_t(state.argument()), SCENE_WIDTH, 8);
+  std::vector<glm::vec3> directions = randomPoints(size_t(state.argument()), 1.0f, 9);
+  std::vector<MissileObject> storage(positions.size());
+  GameObjectsList missiles;
+
+  for (size_t m = 0; m < storage.size(); m++) {
+    MissileObject& missile = storage[m];
+    missile.position = positions[m];
+    missile.direction = glm::normalize(directions[m] + glm::vec3(1e-3f));
+    missile.speed = MISSILE_SPEED;
+    missile.size = MISSILE_SIZE;
+    missile.destroyed = false;
+    missile.startTime = 0.0f;
+    missile.currentTime = 0.0f;
+    missiles.push_back(&missile);
+  }
+
+  size_t iteration = 0;
+  while (state.keepRunning())
+    updateMissiles(missiles, oscillatingTime(++iteration));
+
+  state.setItemsProcessed(state.iterations * storage.size());
+}
+
+void benchmarkUpdateMissilesParallel(BenchmarkState& state) {
+  std::vector<glm::vec3> positions = randomPoints(size_t(state.argument()), SCENE_WIDTH, 8);
+  std::vector<glm::vec3> directions = randomPoints(size_t(state.argument()), 1.0f, 9);
+  std::vector<MissileObject> storage(positions.size());
+  GameObjectsList missiles;
+
+  for (size_t m = 0; m < storage.size(); m++) {
+    MissileObject& missile = storage[m];
+    missile.position = positions[m];
+    missile.direction = glm::normalize(directions[m] + glm::vec3(1e-3f));
+    missile.speed = MISSILE_SPEED;
+    missile.size = MISSILE_SIZE;
+    missile.destroyed = false;
+    missile.startTime = 0.0f;
+    missile.currentTime = 0.0f;
+    missiles.push_back(&missile);
+  }
+
+  size_t iteration = 0;
+  while (state.keepRunning())
+    updateMissilesParallel(missiles, oscillatingTime(++iteration));
+
+  state.setItemsProcessed(state.iterations * storage.size());
+}
+
+void benchmarkUpdateMissileEntities(BenchmarkState& state) {
+  std::vector<MissileObject> storage = randomMissiles(size_t(state.argument()));
+  EntityStore missiles;
+
+  for (size_t m = 0; m < storage.size(); m++)
+    createEntity(missiles, storage[m]);
+
+  size_t iteration = 0;
+  while (state.keepRunning())
+    updateMissileEntities(missiles, oscillatingTime(++iteration));
+
+  state.setItemsProcessed(state.iterations * storage.size());
+}
+
+void benchmarkCollideMissilesParallel(BenchmarkState& state) {
+  std::vector<MissileObject> storage = randomMissiles(size_t(state.argument()));
+  std::vector<Object> targets = unreachableTargets(COLLISION_TARGETS);
+  GameObjectsList missiles;
+  std::vector<glm::vec3> hits;
+
+  for (size_t m = 0; m < storage.size(); m++)
+    missiles.push_back(&storage[m]);
+
+  while (state.keepRunning())
+    collideMissilesParallel(missiles, targets, hits);
+
+  state.setItemsProcessed(state.iterations * storage.size() * targets.size());
+}
+
+void benchmarkCollideEntities(BenchmarkState& state) {
+  std::vector<MissileObject> storage = randomMissiles(size_t(state.argument()));
+  std::vector<Object> targetObjects = unreachableTargets(COLLISION_TARGETS);
+  EntityStore missiles;
+  EntityStore targets;
+  std::vector<glm::vec3> hits;
+
+  for (size_t m = 0; m < storage.size(); m++)
+    createEntity(missiles, storage[m]);
+  for (size_t t = 0; t < targetObjects.size(); t++)
+    createEntity(targets, targetObjects[t]);
+
+  while (state.keepRunning())
+    collideEntities(missiles, targets, hits);
+
+  state.setItemsProcessed(state.iterations * storage.size() * targetObjects.size());
+}
+
+// bird counts of the flock cases
+const std::vector<long long> FLOCK_COUNTS = { 100, 1000, 10000 };
+
+// one simulation step of the flock - grid sorting, steering of all birds and their moving
+void benchmarkUpdateFlock(BenchmarkState& state) {
+  Flock flock;
+  seedSimulationRandom(10);
+  initializeFlock(flock, size_t(state.argument()), 0.0f);
+
+  // the birds fly on, their density stays the same
+  size_t iteration = 0;
+  while (state.keepRunning())
+    updateFlock(flock, float(++iteration) * SIMULATION_TIMESTEP);
+
+  state.setItemsProcessed(state.iterations * flockSize(flock));
+}
+
+// the targets of collideEntities() through the grid, the missiles sweep one simulation step
+void benchmarkSweepProjectiles(BenchmarkState& state) {
+  std::vector<MissileObject> storage = randomMissiles(size_t(state.argument()));
+  std::vector<Object> targets = unreachableTargets(COLLISION_TARGETS);
+  EntityStore missiles;
+  SphereGrid grid;
+  std::vector<ProjectileHit> hits;
+
+  for (size_t m = 0; m < storage.size(); m++)
+    createEntity(missiles, storage[m]);
+  for (size_t t = 0; t < targets.size(); t++)
+    addGridSphere(grid, targets[t].position, targets[t].size, (unsigned int)t);
+  buildSphereGrid(grid);
+
+  while (state.keepRunning())
+    sweepProjectiles(missiles, grid, SIMULATION_TIMESTEP, hits);
+
+  state.setItemsProcessed(state.iterations * storage.size() * targets.size());
+}
+
+void benchmarkUpdateExplosions(BenchmarkState& state) {
+  std::vector<ExplosionObject> storage(size_t(state.argument()));
+  GameObjectsList explosions;
+
+  for (size_t e = 0; e < storage.size(); e++) {
+    ExplosionObject& explosion = storage[e];
+    explosion.destroyed = false;
+    explosion.startTime = 0.0f;
+    explosion.currentTime = 0.0f;
+    explosion.frameDuration = 0.1f;
+    explosion.textureFrames = 16;
+    explosions.push_back(&explosion);
+  }
+
+  size_t iteration = 0;
+  while (state.keepRunning())
+    updateExplosions(explosions, oscillatingTime(++iteration));
+
+  state.setItemsProcessed(state.iterations * storage.size());
+}
+
+// END OF SIMULATION BENCHMARKS
+// ----------------------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+
+  registerBenchmark("checkBounds", benchmarkCheckBounds);
+  registerBenchmark("checkBoundsArray", benchmarkCheckBoundsArray, WRAP_COUNTS);
+  if (isCollisionKernelSupported(COLLISION_KERNEL_SCALAR))
+    registerBenchmark("checkBoundsBatch_scalar", benchmarkCheckBoundsBatch<COLLISION_KERNEL_SCALAR>, WRAP_COUNTS);
+  if (isCollisionKernelSupported(COLLISION_KERNEL_SSE2))
+    registerBenchmark("checkBoundsBatch_sse2", benchmarkCheckBoundsBatch<COLLISION_KERNEL_SSE2>, WRAP_COUNTS);
+  if (isCollisionKernelSupported(COLLISION_KERNEL_AVX2))
+    registerBenchmark("checkBoundsBatch_avx2", benchmarkCheckBoundsBatch<COLLISION_KERNEL_AVX2>, WRAP_COUNTS);
+  registerBenchmark("pointInSphere", benchmarkPointInSphere);
+  registerBenchmark("spheresIntersection", benchmarkSpheresIntersection);
+  if (isCollisionKernelSupported(COLLISION_KERNEL_SCALAR))
+    registerBenchmark("spheresIntersectionBatch_scalar", benchmarkSpheresIntersectionBatch<COLLISION_KERNEL_SCALAR>);
+  if (isCollisionKernelSupported(COLLISION_KERNEL_SSE2))
+    registerBenchmark("spheresIntersectionBatch_sse2", benchmarkSpheresIntersectionBatch<COLLISION_KERNEL_SSE2>);
+  if (isCollisionKernelSupported(COLLISION_KERNEL_AVX2))
+    registerBenchmark("spheresIntersectionBatch_avx2", benchmarkSpheresIntersectionBatch<COLLISION_KERNEL_AVX2>);
+  registerBenchmark("alignObject", benchmarkAlignObject);
+  registerBenchmark("evaluateClosedCurve", benchmarkEvaluateClosedCurve);
+  registerBenchmark("evaluateClosedCurve_1stDerivative", benchmarkEvaluateClosedCurve1stDerivative);
+  registerBenchmark("evaluateCurveSegmentBasis_catmullRom", benchmarkEvaluateCurveSegmentBasis<CatmullRomBasis>);
+  registerBenchmark("evaluateCurveSegmentBasis_bSpline", benchmarkEvaluateCurveSegmentBasis<BSplineBasis>);
+  registerBenchmark("evaluateCurveSegmentBasis_bezier", benchmarkEvaluateCurveSegmentBasis<BezierBasis>);
+  registerBenchmark("evaluateCurveSegmentBasis_hermite", benchmarkEvaluateCurveSegmentBasis<HermiteBasis>);
+  registerBenchmark("evaluateSplinePath", benchmarkEvaluateSplinePath);
+  registerBenchmark("evaluateSplinePathTangent", benchmarkEvaluateSplinePathTangent);
+  registerBenchmark("evaluateSplinePathAgents", benchmarkEvaluateSplinePathAgents, AGENT_COUNTS);
+  registerBenchmark("evaluateSplinePathBatch", benchmarkEvaluateSplinePathBatch, AGENT_COUNTS);
+  registerBenchmark("computeTransformMatrices", benchmarkTransformMatrices);
+  registerBenchmark("updateMissiles", benchmarkUpdateMissiles, OBJECT_COUNTS);
+  registerBenchmark("updateExplosions", benchmarkUpdateExplosions, OBJECT_COUNTS);
+  registerBenchmark("updateMissilesParallel", benchmarkUpdateMissilesParallel, OBJECT_COUNTS);
+  registerBenchmark("updateMissileEntities", benchmarkUpdateMissileEntities, OBJECT_COUNTS);
+  registerBenchmark("collideMissilesParallel", benchmarkCollideMissilesParallel, COLLISION_COUNTS);
+  registerBenchmark("collideEntities", benchmarkCollideEntities, COLLISION_COUNTS);
+  registerBenchmark("sweepProjectiles", benchmarkSweepProjectiles, COLLISION_COUNTS);
+  registerBenchmark("updateFlock", benchmarkUpdateFlock, FLOCK_COUNTS);
+
+  int result = runBenchmarks(argc, argv);
+  cleanupJobSystem();
+  return result;
+}
@@ -0,0 +1,498 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    capture.cpp
+ * \author  Sean Phay
+ * \date    2023
+ * \brief   Screenshots and video capture without stalling the rendering (ring of pixel buffers).
+ */
+//----------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "pgr.h"
+#include "capture.h"
+#include "golden.h"
+#include "data.h"
+
+#ifdef _WIN32
+#include <direct.h>
+#define makeDirectory(path) _mkdir(path)
+#define openPipe(command)   _popen(command, "wb")
+#define closePipe(pipe)     _pclose(pipe)
+#else
+#include <sys/stat.h>
+#define makeDirectory(path) mkdir(path, 0755)
+#define openPipe(command)   popen(command, "w")
+#define closePipe(pipe)     pclose(pipe)
+#endif
+
+// work of the encoding thread
+enum { CAPTURE_JOB_IMAGE, CAPTURE_JOB_VIDEO_FRAME, CAPTURE_JOB_VIDEO_END };
+
+typedef struct _CaptureJob {
+  int                        type;
+  int                        width;
+  int                        height;
+  std::string                fileName;  // image file, empty for the piped video
+  std::vector<unsigned char> pixels;    // RGB, rows from the bottom (as read by OpenGL)
+} CaptureJob;
+
+// one pixel buffer of the ring
+typedef struct _CaptureSlot {
+  GLuint      buffer;
+  int         width;
+  int         height;
+  bool        pending;         // glReadPixels() issued, not read yet
+  bool        videoFrame;      // goes to the recorded video
+  std::string screenshotName;  // goes to a screenshot if not empty
+  std::string videoName;       // image of the sequence, empty for the pipe
+} CaptureSlot;
+
+struct CaptureState {
+  std::string directory;
+  std::string pipeCommand;
+  int         format;
+
+  CaptureSlot slots[CAPTURE_RING_SIZE];
+  bool        buffersCreated;
+  int         nextSlot;
+  int         pendingSlots;
+
+  bool         screenshotRequested;
+  unsigned int screenshots;        // taken in this run, distinguishes the screenshots of one second
+  bool         recording;
+  bool         videoEndRequested;  // stopped, the END job follows the frames still in flight
+  int          recordingWidth;
+  int          recordingHeight;
+  unsigned int recordedFrames;
+  unsigned int droppedFrames;
+  std::string  sessionName;
+
+  // encoding thread
+  std::thread             worker;
+  std::mutex              mutex;
+  std::condition_variable condition;
+  std::deque<CaptureJob>  jobs;
+  bool                    quit;
+} capture;
+
+// ----------------------------------------------------------------------------------------
+// START OF ENCODING FUNCTIONS
+
+// CRC of the PNG chunks
+unsigned int crc32(unsigned int crc, const unsigned char* data, size_t size) {
+  static unsigned int table[256];
+  static bool tableReady = false;
+
+  if (tableReady == false) {
+    for (unsigned int n = 0; n < 256; n++) {
+      unsigned int c = n;
+      for (int k = 0; k < 8; k++)
+        c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+      table[n] = c;
+    }
+    tableReady = true;
+  }
+
+  crc = ~crc;
+  for (size_t i = 0; i < size; i++)
+    crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+  return ~crc;
+}
+
+void appendBigEndian(std::vector<unsigned char>& out, unsigned int value) {
+  out.push_back((unsigned char)(value >> 24));
+  out.push_back((unsigned char)(value >> 16));
+  out.push_back((unsigned char)(value >> 8));
+  out.push_back((unsigned char)(value));
+}
+
+void writePngChunk(FILE* file, const char* type, const std::vector<unsigned char>& data) {
+  std::vector<unsigned char> chunk;
+  appendBigEndian(chunk, (unsigned int)data.size());
+  chunk.insert(chunk.end(), type, type + 4);
+  chunk.insert(chunk.end(), data.begin(), data.end());
+  appendBigEndian(chunk, crc32(0, &chunk[4], chunk.size() - 4));
+  fwrite(chunk.data(), 1, chunk.size(), file);
+}
+
+// PNG with the stored (not compressed) deflate blocks - the encoding costs just a copy,
+// the screenshots are compressed later if needed
+bool savePng(const std::string& fileName, const Image& image) {
+  FILE* file = fopen(fileName.c_str(), "wb");
+  if (file == NULL) {
+    std::cerr << "savePng(): Cannot create file \"" << fileName << "\"." << std::endl;
+    return false;
+  }
+
+  const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+  fwrite(signature, 1, sizeof(signature), file);
+
+  std::vector<unsigned char> header;
+  appendBigEndian(header, image.width);
+  appendBigEndian(header, image.height);
+  header.push_back(8);  // bits per channel
+  header.push_back(2);  // RGB
+  header.push_back(0);  // deflate
+  header.push_back(0);  // adaptive filtering
+  header.push_back(0);  // no interlace
+  writePngChunk(file, "IHDR", header);
+
+  // rows prefixed by the filter type 0 (none)
+  const size_t rowBytes = 3 * size_t(image.width);
+  std::vector<unsigned char> raw;
+  raw.reserve((rowBytes + 1) * image.height);
+  for (int y = 0; y < image.height; y++) {
+    raw.push_back(0);
+    raw.insert(raw.end(), image.pixels.begin() + y * rowBytes, image.pixels.begin() + (y + 1) * rowBytes);
+  }
+
+  // zlib stream of the stored blocks, up to 65535 bytes each
+  std::vector<unsigned char> data;
+  data.reserve(raw.size() + 5 * (raw.size() / 65535 + 1) + 6);
+  data.push_back(0x78);
+  data.push_back(0x01);
+
+  unsigned int adlerA = 1, adlerB = 0;
+  for (size_t offset = 0; offset < raw.size() || offset == 0; ) {
+    size_t size = std::min(raw.size() - offset, size_t(65535));
+    bool last = offset + size == raw.size();
+
+    data.push_back(last ? 1 : 0);
+    data.push_back((unsigned char)(size & 0xFF));
+    data.push_back((unsigned char)(size >> 8));
+    data.push_back((unsigned char)(~size & 0xFF));
+    data.push_back((unsigned char)((~size >> 8) & 0xFF));
+    data.insert(data.end(), raw.begin() + offset, raw.begin() + offset + size);
+
+    for (size_t i = offset; i < offset + size; i++) {
+      adlerA = (adlerA + raw[i]) % 65521;
+      adlerB = (adlerB + adlerA) % 65521;
+    }
+
+    offset += size;
+    if (last)
+      break;
+  }
+  appendBigEndian(data, (adlerB << 16) | adlerA);
+  writePngChunk(file, "IDAT", data);
+  writePngChunk(file, "IEND", std::vector<unsigned char>());
+
+  bool written = ferror(file) == 0;
+  fclose(file);
+  return written;
+}
+
+// the rows of the job in the order of the image files
+void flipRows(const CaptureJob& job, Image& image) {
+  const size_t rowBytes = 3 * size_t(job.width);
+  image.width = job.width;
+  image.height = job.height;
+  image.pixels.resize(job.pixels.size());
+  for (int y = 0; y < job.height; y++)
+    memcpy(&image.pixels[y * rowBytes], &job.pixels[(job.height - 1 - y) * rowBytes], rowBytes);
+}
+
+void encodeJobs() {
+  FILE* pipe = NULL;
+  Image image;
+
+  for (;;) {
+    CaptureJob job;
+    {
+      std::unique_lock<std::mutex> lock(capture.mutex);
+      capture.condition.wait(lock, []() { return capture.quit || !capture.jobs.empty(); });
+      if (capture.jobs.empty())
+        break;
+      job = std::move(capture.jobs.front());
+      capture.jobs.pop_front();
+    }
+
+    if (job.type == CAPTURE_JOB_VIDEO_END) {
+      if (pipe != NULL)
+        closePipe(pipe);
+      pipe = NULL;
+      continue;
+    }
+
+    flipRows(job, image);
+
+    if (job.fileName.empty() == false) {
+      if (capture.format == CAPTURE_FORMAT_PPM)
+        saveImage(job.fileName, image);
+      else
+        savePng(job.fileName, image);
+      continue;
+    }
+
+    // video frame for the encoder, the pipe is opened by the first frame of the recording
+    if (pipe == NULL) {
+      std::string command = capture.pipeCommand;
+      std::string size = std::to_string(job.width) + "x" + std::to_string(job.height);
+      for (size_t at = command.find("{size}"); at != std::string::npos; at = command.find("{size}"))
+        command.replace(at, 6, size);
+
+      pipe = openPipe(command.c_str());
+      if (pipe == NULL)
+        std::cerr << "encodeJobs(): Cannot start \"" << command << "\"." << std::endl;
+    }
+    if (pipe != NULL)
+      fwrite(image.pixels.data(), 1, image.pixels.size(), pipe);
+  }
+
+  if (pipe != NULL)
+    closePipe(pipe);
+}
+
+void submitJob(CaptureJob& job) {
+  {
+    std::lock_guard<std::mutex> lock(capture.mutex);
+    capture.jobs.push_back(std::move(job));
+  }
+  capture.condition.notify_one();
+}
+
+// END OF ENCODING FUNCTIONS
+// ----------------------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------------------
+// START OF CAPTURE FUNCTIONS
+
+// date and time for the file names - the captures of the previous runs are not overwritten
+std::string captureTimeStamp() {
+  char text[32];
+  time_t now = time(NULL);
+  strftime(text, sizeof(text), "%Y%m%d-%H%M%S", localtime(&now));
+  return text;
+}
+
+std::string captureExtension() {
+  return capture.format == CAPTURE_FORMAT_PPM ? ".ppm" : ".png";
+}
+
+void initializeCapture(const std::string& directory, const std::string& pipeCommand, int format) {
+  capture.directory = directory.empty() ? std::string(".") : directory;
+  capture.pipeCommand = pipeCommand;
+  capture.format = format;
+
+  capture.buffersCreated = false;
+  capture.nextSlot = 0;
+  capture.pendingSlots = 0;
+  capture.screenshotRequested = false;
+  capture.screenshots = 0;
+  capture.recording = false;
+  capture.videoEndRequested = false;
+  capture.recordedFrames = 0;
+  capture.droppedFrames = 0;
+
+  makeDirectory(capture.directory.c_str());
+
+  capture.quit = false;
+  capture.worker = std::thread(encodeJobs);
+}
+
+void requestScreenshot() {
+  capture.screenshotRequested = true;
+}
+
+void toggleCaptureRecording() {
+  if (capture.worker.joinable() == false)
+    return;
+
+  capture.recording = !capture.recording;
+
+  if (capture.recording) {
+    capture.sessionName = captureTimeStamp();
+    capture.recordingWidth = 0;
+    capture.recordingHeight = 0;
+    capture.recordedFrames = 0;
+    capture.droppedFrames = 0;
+    capture.videoEndRequested = false;
+    std::cout << "Recording started." << std::endl;
+  }
+  else {
+    capture.videoEndRequested = true;
+    std::cout << "Recording stopped, frames: " << capture.recordedFrames << ", dropped: " << capture.droppedFrames << std::endl;
+  }
+}
+
+bool isCaptureRecording() {
+  return capture.recording;
+}
+
+// maps the buffer of the slot and hands its pixels to the encoding thread
+void collectSlot(CaptureSlot& slot) {
+  const size_t size = 3 * size_t(slot.width) * slot.height;
+
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+  const unsigned char* mapped = (const unsigned char*)glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+
+  if (mapped != NULL) {
+    CaptureJob job;
+    job.width = slot.width;
+    job.height = slot.height;
+    job.pixels.assign(mapped, mapped + size);
+
+    if (slot.screenshotName.empty() == false) {
+      CaptureJob screenshot = job;
+      screenshot.type = CAPTURE_JOB_IMAGE;
+      screenshot.fileName = slot.screenshotName;
+      submitJob(screenshot);
+      std::cout << "Screenshot " << slot.screenshotName << std::endl;
+    }
+    if (slot.videoFrame) {
+      job.type = CAPTURE_JOB_VIDEO_FRAME;
+      job.fileName = slot.videoName;
+      submitJob(job);
+    }
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  slot.pending = false;
+  capture.pendingSlots--;
+}
+
+// the recording is closed after its last frame has been handed over
+void finishVideo() {
+  for (int s = 0; s < CAPTURE_RING_SIZE; s++) {
+    if (capture.slots[s].pending && capture.slots[s].videoFrame)
+      return;
+  }
+
+  CaptureJob job;
+  job.type = CAPTURE_JOB_VIDEO_END;
+  submitJob(job);
+  capture.videoEndRequested = false;
+}
+
+void captureFrame(int width, int height) {
+  if (capture.worker.joinable() == false)
+    return;
+
+  // a video for the encoder has one frame size
+  if (capture.recording && capture.pipeCommand.empty() == false && capture.recordingWidth != 0 &&
+      (capture.recordingWidth != width || capture.recordingHeight != height)) {
+    std::cerr << "captureFrame(): The window size changed, the recording stops." << std::endl;
+    toggleCaptureRecording();
+  }
+
+  const bool wanted = capture.screenshotRequested || capture.recording;
+  if (wanted == false && capture.pendingSlots == 0) {
+    if (capture.videoEndRequested)
+      finishVideo();
+    return;
+  }
+
+  if (capture.buffersCreated == false) {
+    for (int s = 0; s < CAPTURE_RING_SIZE; s++) {
+      glGenBuffers(1, &capture.slots[s].buffer);
+      capture.slots[s].width = capture.slots[s].height = 0;
+      capture.slots[s].pending = false;
+    }
+    capture.buffersCreated = true;
+  }
+
+  // the slot was filled CAPTURE_RING_SIZE frames ago, its copy is finished by now
+  CaptureSlot& slot = capture.slots[capture.nextSlot];
+  if (slot.pending)
+    collectSlot(slot);
+
+  if (capture.videoEndRequested)
+    finishVideo();
+
+  if (wanted) {
+    slot.videoFrame = false;
+    slot.screenshotName.clear();
+    slot.videoName.clear();
+
+    if (capture.screenshotRequested) {
+      slot.screenshotName = capture.directory + "/screenshot_" + captureTimeStamp() + "_" + std::to_string(++capture.screenshots) + captureExtension();
+      capture.screenshotRequested = false;
+    }
+
+    if (capture.recording) {
+      size_t queued;
+      {
+        std::lock_guard<std::mutex> lock(capture.mutex);
+        queued = capture.jobs.size();
+      }
+
+      // the encoder does not keep up - the frame is skipped instead of waiting for it
+      if (queued >= CAPTURE_QUEUE_LIMIT) {
+        capture.droppedFrames++;
+      }
+      else {
+        char frameNumber[16];
+        snprintf(frameNumber, sizeof(frameNumber), "%06u", capture.recordedFrames);
+        slot.videoFrame = true;
+        if (capture.pipeCommand.empty())
+          slot.videoName = capture.directory + "/video_" + capture.sessionName + "_" + frameNumber + captureExtension();
+        capture.recordingWidth = width;
+        capture.recordingHeight = height;
+        capture.recordedFrames++;
+      }
+    }
+
+    if (slot.videoFrame || slot.screenshotName.empty() == false) {
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+      if (slot.width != width || slot.height != height) {
+        glBufferData(GL_PIXEL_PACK_BUFFER, 3 * GLsizeiptr(width) * height, NULL, GL_STREAM_READ);
+        slot.width = width;
+        slot.height = height;
+      }
+
+      // copied into the buffer object on the GPU, the call returns without waiting
+      glPixelStorei(GL_PACK_ALIGNMENT, 1);
+      glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, (void*)0);
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+      slot.pending = true;
+      capture.pendingSlots++;
+    }
+  }
+
+  capture.nextSlot = (capture.nextSlot + 1) % CAPTURE_RING_SIZE;
+}
+
+void cleanupCapture() {
+  if (capture.worker.joinable() == false)
+    return;
+
+  if (capture.recording)
+    toggleCaptureRecording();
+
+  // the frames in flight in the order they were drawn
+  for (int s = 0; s < CAPTURE_RING_SIZE; s++) {
+    CaptureSlot& slot = capture.slots[(capture.nextSlot + s) % CAPTURE_RING_SIZE];
+    if (slot.pending)
+      collectSlot(slot);
+  }
+  if (capture.videoEndRequested)
+    finishVideo();
+
+  if (capture.buffersCreated) {
+    for (int s = 0; s < CAPTURE_RING_SIZE; s++)
+      glDeleteBuffers(1, &capture.slots[s].buffer);
+    capture.buffersCreated = false;
+  }
+
+  // the encoding thread finishes the queued jobs first
+  {
+    std::lock_guard<std::mutex> lock(capture.mutex);
+    capture.quit = true;
+  }
+  capture.condition.notify_one();
+  capture.worker.join();
+}
+
+// END OF CAPTURE FUNCTIONS
+// ----------------------------------------------------------------------------------------
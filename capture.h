@@ -0,0 +1,57 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    capture.h
+ * \author  Sean Phay
+ * \date    2023
+ * \brief   Screenshots and video capture without stalling the rendering (ring of pixel buffers).
+ */
+//----------------------------------------------------------------------------------------
+
+#ifndef __CAPTURE_H
+#define __CAPTURE_H
+
+#include <string>
+
+// file format of the captured images
+enum { CAPTURE_FORMAT_PNG, CAPTURE_FORMAT_PPM };
+
+//**************************************************************************************************
+/// Sets where the captured frames go and starts the encoding thread.
+/**
+ Screenshots are always stored as images into the directory. The recorded video goes into the
+ directory as an image sequence, or into the standard input of the pipe command as raw RGB frames
+ (rows from the top) if the command is not empty. "{size}" in the command is replaced by the frame
+ size, e.g. "ffmpeg -y -f rawvideo -pix_fmt rgb24 -s {size} -r 30 -i - demo.mp4".
+
+ \param[in]  directory    Output directory, created if it does not exist.
+ \param[in]  pipeCommand  Encoder command for the video, empty for the image sequence.
+ \param[in]  format       CAPTURE_FORMAT_PNG or CAPTURE_FORMAT_PPM.
+*/
+void initializeCapture(const std::string& directory, const std::string& pipeCommand, int format);
+
+/// Stores the next drawn frame as an image.
+void requestScreenshot();
+
+/// Starts or stops the recording of every drawn frame.
+void toggleCaptureRecording();
+
+/// True while the frames are recorded.
+bool isCaptureRecording();
+
+//**************************************************************************************************
+/// Captures the frame which was just drawn into the current framebuffer.
+/**
+ Called at the end of every frame, before the buffers are swapped. The pixels are copied into
+ a pixel buffer object on the GPU and read by the CPU CAPTURE_RING_SIZE frames later, when the
+ copy is long finished, so neither glReadPixels() nor the mapping waits for the GPU. The images
+ are encoded by a worker thread. Does nothing if no frame is requested or in flight.
+
+ \param[in]  width       Size of the framebuffer.
+ \param[in]  height
+*/
+void captureFrame(int width, int height);
+
+/// Reads the frames still in flight, waits for the encoding and deletes the buffers.
+void cleanupCapture();
+
+#endif // __CAPTURE_H
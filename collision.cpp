@@ -0,0 +1,484 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    collision.cpp
+ * \author  Sean Phay
+ * \date    2023
+ * \brief   Collision tests and wrapping of the positions inside the scene.
+ */
+//----------------------------------------------------------------------------------------
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include "collision.h"
+#include "data.h"
+
+// SSE2 and AVX2 kernels on x86, the AVX2 one is compiled for AVX2 without enabling it for the whole file
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define COLLISION_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define COLLISION_TARGET_AVX2
+#else
+#define COLLISION_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+// positions still outside of the scene after the wrapping, checkBounds() runs in the jobs as well
+std::atomic<size_t> outOfBoundsCount(0);
+
+// counts a wrong position, only the first one is printed - a print per position would stall the update
+void reportOutOfBounds(const glm::vec3& position) {
+  if (outOfBoundsCount.fetch_add(1) == 0)
+    printf("Coordinates out of the window, [x, y, z] = [%f, %f, %f] (further ones are only counted)\n", position.x, position.y, position.z);
+}
+
+size_t getOutOfBoundsCount() {
+  return outOfBoundsCount.load();
+}
+
+//----------------------------------------------------------------------------------------
+// START OF COLLISION HELPER FUNCTIONS
+/// Checks whether a given point is inside a sphere or not.
+/**
+\param[in]  point      Point to be tested.
+\param[in]  center     Center of the sphere.
+\param[in]  radius     Radius of the sphere.
+\return                True if the point lies inside the sphere, otherwise false.
+*/
+bool pointInSphere(const glm::vec3& point, const glm::vec3& center, float radius) {
+	if (glm::distance(point, center) <= radius)
+		return true;
+	else
+	return false;
+}
+
+/// Checks if there is intersection between two given spheres or not.
+/**
+\param[in]  center1    First sphere center.
+\param[in]  radius1    First sphere radius.
+\param[in]  center2    Second sphere center.
+\param[in]  radius2    Second sphere radius.
+\return                True if the spheres overlap, otherwise false.
+*/
+bool spheresIntersection(const glm::vec3& center1, float radius1, const glm::vec3& center2, float radius2) {
+	//   check whether given spheres are intersecting each other or not
+	if (glm::distance(center1, center2) < radius1 + radius2)
+		return true;
+	else
+		return false;
+}
+
+/// Checks if a sphere moving along a segment hits another sphere.
+/**
+ The moving sphere is tested over the whole segment, not only at its end - a fast object cannot
+ pass through a thin one between two steps. Solves |start + t * (end - start) - center2| = radius1 + radius2
+ for the smaller root t.
+\param[in]  start      Center of the moving sphere at the beginning of the step.
+\param[in]  end        Center of the moving sphere at the end of the step.
+\param[in]  radius1    Radius of the moving sphere.
+\param[in]  center2    Center of the static sphere.
+\param[in]  radius2    Radius of the static sphere.
+\param[out] fraction   Part of the segment travelled at the first contact (0 if the spheres overlap at the start).
+\return                True if the spheres touch anywhere along the segment, otherwise false.
+*/
+bool sweptSphereIntersection(const glm::vec3& start, const glm::vec3& end, float radius1, const glm::vec3& center2, float radius2, float& fraction) {
+	glm::vec3 offset = start - center2;
+	glm::vec3 motion = end - start;
+	float reach = radius1 + radius2;
+
+	float c = glm::dot(offset, offset) - reach * reach;
+	if (c <= 0.0f) {
+		// overlapping already at the start
+		fraction = 0.0f;
+		return true;
+	}
+
+	float b = glm::dot(offset, motion);
+	float a = glm::dot(motion, motion);
+	// moving away or not moving at all
+	if (b >= 0.0f || a <= 0.0f)
+		return false;
+
+	float discriminant = b * b - a * c;
+	if (discriminant < 0.0f)
+		return false;
+
+	float t = (-b - sqrt(discriminant)) / a;
+	if (t > 1.0f)
+		return false;
+
+	fraction = t;
+	return true;
+}
+
+/// Makes a given location to be valid position inside a scene.
+/**
+ Checks whether a given location \a position is valid position inside a scene.
+ Valid position coordinates are always in range -(SCENE_WIDTH+objectSize)...SCENE_WIDTH+objectSize,
+ -(SCENE_HEIGHT+objectSize)...SCENE_HEIGHT+objectSize, and -(SCENE_DEPTH+objectSize)...SCENE_DEPTH+objectSize.
+ \param[in]  position       Position (object center) to be checked and corrected.
+ \param[in]  objectSize     Size of the object which position is tested.
+ \return                    Valid position inside a scene.
+*/
+glm::vec3 checkBounds(const glm::vec3 &position, float objectSize) {
+ glm::vec3 newPosition = position;
+
+  // wrap a given position (object center) to be inside a scene
+  // If x is negative and goes past the negative treshold, it should reappear on the positive side on the object space
+  // and vice versa
+  // The function fmod() is useful for this: => same as % but it can handle floating point numbers
+  // /
+  // you have to take into account the objectSize parameter
+
+     float halfSceneWidth = SCENE_WIDTH + objectSize;
+     float halfSceneHeight = SCENE_HEIGHT + objectSize;
+
+     // Wrap the x-coordinate within the scene width
+     newPosition.x = fmod(newPosition.x + halfSceneWidth, 2 * halfSceneWidth) - halfSceneWidth;
+
+     if (newPosition.x < -halfSceneWidth)
+         newPosition.x += 2 * halfSceneWidth;
+
+
+     // Wrap the y-coordinate within the scene height
+     newPosition.y = fmod(newPosition.y + halfSceneHeight, 2 * halfSceneHeight) - halfSceneHeight;
+
+     if (newPosition.y < -halfSceneHeight)
+         newPosition.y += 2 * halfSceneHeight;
+
+   if( abs(newPosition.x) > (SCENE_WIDTH+objectSize) || abs(newPosition.y) > (SCENE_HEIGHT+objectSize) ) {
+     reportOutOfBounds(newPosition);
+   }
+  return newPosition;
+}
+
+// END OF COLLISION HELPER FUNCTIONS
+//----------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------
+// START OF BATCH COLLISION FUNCTIONS
+
+// signature of one implementation of the batch test - inclusive compares with <= (points), otherwise <
+typedef size_t (*SphereBatchKernel)(const glm::vec3& center, float radius,
+  const float* centersX, const float* centersY, const float* centersZ, const float* radii,
+  size_t count, uint64_t* hitMask);
+
+// number of set bits of a lane mask (at most 8 bits)
+inline size_t countLaneBits(unsigned int bits) {
+  bits = bits - ((bits >> 1) & 0x55u);
+  bits = (bits & 0x33u) + ((bits >> 2) & 0x33u);
+  return (bits + (bits >> 4)) & 0x0Fu;
+}
+
+// tests the spheres begin ... count-1 one by one and sets their bits, the mask must be cleared
+template <bool inclusive>
+size_t sphereRangeScalar(const glm::vec3& center, float radius,
+  const float* centersX, const float* centersY, const float* centersZ, const float* radii,
+  size_t begin, size_t count, uint64_t* hitMask) {
+
+  size_t hits = 0;
+  for (size_t i = begin; i < count; i++) {
+    float dx = centersX[i] - center.x;
+    float dy = centersY[i] - center.y;
+    float dz = centersZ[i] - center.z;
+    float distance2 = dx * dx + dy * dy + dz * dz;
+    float reach = radii[i] + radius;
+    bool hit = inclusive ? (distance2 <= reach * reach) : (distance2 < reach * reach);
+
+    hitMask[i >> 6] |= uint64_t(hit) << (i & 63);
+    hits += hit;
+  }
+  return hits;
+}
+
+inline void clearHitMask(size_t count, uint64_t* hitMask) {
+  for (size_t word = 0; word < (count + 63) / 64; word++)
+    hitMask[word] = 0;
+}
+
+template <bool inclusive>
+size_t sphereBatchScalar(const glm::vec3& center, float radius,
+  const float* centersX, const float* centersY, const float* centersZ, const float* radii,
+  size_t count, uint64_t* hitMask) {
+
+  clearHitMask(count, hitMask);
+  return sphereRangeScalar<inclusive>(center, radius, centersX, centersY, centersZ, radii, 0, count, hitMask);
+}
+
+#ifdef COLLISION_X86
+
+// four spheres per step, the products are summed in the order of the scalar code => the same results
+template <bool inclusive>
+size_t sphereBatchSse2(const glm::vec3& center, float radius,
+  const float* centersX, const float* centersY, const float* centersZ, const float* radii,
+  size_t count, uint64_t* hitMask) {
+
+  clearHitMask(count, hitMask);
+
+  const __m128 cx = _mm_set1_ps(center.x);
+  const __m128 cy = _mm_set1_ps(center.y);
+  const __m128 cz = _mm_set1_ps(center.z);
+  const __m128 r = _mm_set1_ps(radius);
+
+  size_t hits = 0;
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128 dx = _mm_sub_ps(_mm_loadu_ps(centersX + i), cx);
+    __m128 dy = _mm_sub_ps(_mm_loadu_ps(centersY + i), cy);
+    __m128 dz = _mm_sub_ps(_mm_loadu_ps(centersZ + i), cz);
+    __m128 distance2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+    __m128 reach = _mm_add_ps(_mm_loadu_ps(radii + i), r);
+    __m128 reach2 = _mm_mul_ps(reach, reach);
+
+    unsigned int bits = (unsigned int)_mm_movemask_ps(inclusive ? _mm_cmple_ps(distance2, reach2) : _mm_cmplt_ps(distance2, reach2));
+    hitMask[i >> 6] |= uint64_t(bits) << (i & 63);
+    hits += countLaneBits(bits);
+  }
+  return hits + sphereRangeScalar<inclusive>(center, radius, centersX, centersY, centersZ, radii, i, count, hitMask);
+}
+
+// eight spheres per step
+template <bool inclusive>
+COLLISION_TARGET_AVX2
+size_t sphereBatchAvx2(const glm::vec3& center, float radius,
+  const float* centersX, const float* centersY, const float* centersZ, const float* radii,
+  size_t count, uint64_t* hitMask) {
+
+  clearHitMask(count, hitMask);
+
+  const __m256 cx = _mm256_set1_ps(center.x);
+  const __m256 cy = _mm256_set1_ps(center.y);
+  const __m256 cz = _mm256_set1_ps(center.z);
+  const __m256 r = _mm256_set1_ps(radius);
+
+  size_t hits = 0;
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(centersX + i), cx);
+    __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(centersY + i), cy);
+    __m256 dz = _mm256_sub_ps(_mm256_loadu_ps(centersZ + i), cz);
+    __m256 distance2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+    __m256 reach = _mm256_add_ps(_mm256_loadu_ps(radii + i), r);
+    __m256 reach2 = _mm256_mul_ps(reach, reach);
+
+    __m256 inside = inclusive ? _mm256_cmp_ps(distance2, reach2, _CMP_LE_OQ) : _mm256_cmp_ps(distance2, reach2, _CMP_LT_OQ);
+    unsigned int bits = (unsigned int)_mm256_movemask_ps(inside);
+    hitMask[i >> 6] |= uint64_t(bits) << (i & 63);
+    hits += countLaneBits(bits);
+  }
+  return hits + sphereRangeScalar<inclusive>(center, radius, centersX, centersY, centersZ, radii, i, count, hitMask);
+}
+
+// AVX2 needs the support of the processor and of the operating system (saving of the YMM registers)
+bool cpuHasAvx2() {
+#ifdef _MSC_VER
+  int info[4];
+  __cpuid(info, 0);
+  if (info[0] < 7)
+    return false;
+  __cpuid(info, 1);
+  if ((info[2] & (1 << 27)) == 0 || (_xgetbv(0) & 6) != 6)  // OSXSAVE, XMM and YMM state
+    return false;
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0;
+#else
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif // COLLISION_X86
+
+// implementations indexed by COLLISION_KERNEL_*, the point test is the sphere test with a zero radius
+#ifdef COLLISION_X86
+const SphereBatchKernel sphereKernels[COLLISION_KERNELS_COUNT] = { sphereBatchScalar<false>, sphereBatchSse2<false>, sphereBatchAvx2<false> };
+const SphereBatchKernel pointKernels[COLLISION_KERNELS_COUNT] = { sphereBatchScalar<true>, sphereBatchSse2<true>, sphereBatchAvx2<true> };
+#else
+const SphereBatchKernel sphereKernels[COLLISION_KERNELS_COUNT] = { sphereBatchScalar<false>, sphereBatchScalar<false>, sphereBatchScalar<false> };
+const SphereBatchKernel pointKernels[COLLISION_KERNELS_COUNT] = { sphereBatchScalar<true>, sphereBatchScalar<true>, sphereBatchScalar<true> };
+#endif
+
+// -1 = not selected yet, the jobs of the parallel loops read it concurrently
+std::atomic<int> collisionKernel(-1);
+
+bool isCollisionKernelSupported(int kernel) {
+  switch (kernel) {
+  case COLLISION_KERNEL_SCALAR:
+    return true;
+#ifdef COLLISION_X86
+  case COLLISION_KERNEL_SSE2:
+    return true;  // part of every x86-64 processor
+  case COLLISION_KERNEL_AVX2: {
+    static const bool avx2 = cpuHasAvx2();
+    return avx2;
+  }
+#endif
+  default:
+    return false;
+  }
+}
+
+bool selectCollisionKernel(int kernel) {
+  if (isCollisionKernelSupported(kernel) == false)
+    return false;
+
+  collisionKernel.store(kernel);
+  return true;
+}
+
+int getCollisionKernel() {
+  int kernel = collisionKernel.load();
+  if (kernel < 0) {
+    kernel = COLLISION_KERNELS_COUNT - 1;
+    while (isCollisionKernelSupported(kernel) == false)
+      kernel--;
+    collisionKernel.store(kernel);
+  }
+  return kernel;
+}
+
+const char* getCollisionKernelName(int kernel) {
+  const char* names[COLLISION_KERNELS_COUNT] = { "scalar", "sse2", "avx2" };
+  return (kernel >= 0 && kernel < COLLISION_KERNELS_COUNT) ? names[kernel] : "unknown";
+}
+
+size_t spheresIntersectionBatch(const glm::vec3& center, float radius,
+  const float* centersX, const float* centersY, const float* centersZ, const float* radii,
+  size_t count, uint64_t* hitMask) {
+  return sphereKernels[getCollisionKernel()](center, radius, centersX, centersY, centersZ, radii, count, hitMask);
+}
+
+size_t pointInSphereBatch(const glm::vec3& point,
+  const float* centersX, const float* centersY, const float* centersZ, const float* radii,
+  size_t count, uint64_t* hitMask) {
+  return pointKernels[getCollisionKernel()](point, 0.0f, centersX, centersY, centersZ, radii, count, hitMask);
+}
+
+// END OF BATCH COLLISION FUNCTIONS
+//----------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------
+// START OF BATCH WRAPPING FUNCTIONS
+
+// one coordinate wrapped into -half ... half, floor instead of fmod => no branch, no library call
+inline float wrapCoordinate(float x, float half) {
+  float width = 2.0f * half;
+  return x - width * std::floor((x + half) / width);
+}
+
+// wraps the positions begin ... count-1 one by one, returns the number of the wrong ones
+size_t wrapRangeScalar(float* positionsX, float* positionsY, const float* objectSizes, size_t begin, size_t count) {
+  size_t outside = 0;
+  for (size_t i = begin; i < count; i++) {
+    float halfWidth = SCENE_WIDTH + objectSizes[i];
+    float halfHeight = SCENE_HEIGHT + objectSizes[i];
+    positionsX[i] = wrapCoordinate(positionsX[i], halfWidth);
+    positionsY[i] = wrapCoordinate(positionsY[i], halfHeight);
+    outside += (std::fabs(positionsX[i]) > halfWidth) | (std::fabs(positionsY[i]) > halfHeight);
+  }
+  return outside;
+}
+
+#ifdef COLLISION_X86
+
+// floor() without SSE4.1: truncation corrected by one for the negative fractions (|x| < 2^31)
+inline __m128 floorSse2(__m128 x) {
+  __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+  return _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, x), _mm_set1_ps(1.0f)));
+}
+
+inline __m128 wrapSse2(__m128 x, __m128 half) {
+  __m128 width = _mm_add_ps(half, half);
+  return _mm_sub_ps(x, _mm_mul_ps(width, floorSse2(_mm_div_ps(_mm_add_ps(x, half), width))));
+}
+
+// |x| > half for a vector
+inline __m128 outsideSse2(__m128 x, __m128 half) {
+  return _mm_cmpgt_ps(_mm_andnot_ps(_mm_set1_ps(-0.0f), x), half);
+}
+
+size_t wrapBatchSse2(float* positionsX, float* positionsY, const float* objectSizes, size_t count) {
+  const __m128 sceneWidth = _mm_set1_ps(SCENE_WIDTH);
+  const __m128 sceneHeight = _mm_set1_ps(SCENE_HEIGHT);
+
+  size_t outside = 0;
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128 size = _mm_loadu_ps(objectSizes + i);
+    __m128 halfWidth = _mm_add_ps(sceneWidth, size);
+    __m128 halfHeight = _mm_add_ps(sceneHeight, size);
+
+    __m128 x = wrapSse2(_mm_loadu_ps(positionsX + i), halfWidth);
+    __m128 y = wrapSse2(_mm_loadu_ps(positionsY + i), halfHeight);
+    _mm_storeu_ps(positionsX + i, x);
+    _mm_storeu_ps(positionsY + i, y);
+
+    outside += countLaneBits((unsigned int)_mm_movemask_ps(_mm_or_ps(outsideSse2(x, halfWidth), outsideSse2(y, halfHeight))));
+  }
+  return outside + wrapRangeScalar(positionsX, positionsY, objectSizes, i, count);
+}
+
+COLLISION_TARGET_AVX2
+size_t wrapBatchAvx2(float* positionsX, float* positionsY, const float* objectSizes, size_t count) {
+  const __m256 sceneWidth = _mm256_set1_ps(SCENE_WIDTH);
+  const __m256 sceneHeight = _mm256_set1_ps(SCENE_HEIGHT);
+  const __m256 signBit = _mm256_set1_ps(-0.0f);
+
+  size_t outside = 0;
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256 size = _mm256_loadu_ps(objectSizes + i);
+    __m256 halfWidth = _mm256_add_ps(sceneWidth, size);
+    __m256 halfHeight = _mm256_add_ps(sceneHeight, size);
+    __m256 width = _mm256_add_ps(halfWidth, halfWidth);
+    __m256 height = _mm256_add_ps(halfHeight, halfHeight);
+
+    __m256 x = _mm256_loadu_ps(positionsX + i);
+    __m256 y = _mm256_loadu_ps(positionsY + i);
+    x = _mm256_sub_ps(x, _mm256_mul_ps(width, _mm256_floor_ps(_mm256_div_ps(_mm256_add_ps(x, halfWidth), width))));
+    y = _mm256_sub_ps(y, _mm256_mul_ps(height, _mm256_floor_ps(_mm256_div_ps(_mm256_add_ps(y, halfHeight), height))));
+    _mm256_storeu_ps(positionsX + i, x);
+    _mm256_storeu_ps(positionsY + i, y);
+
+    __m256 outsideX = _mm256_cmp_ps(_mm256_andnot_ps(signBit, x), halfWidth, _CMP_GT_OQ);
+    __m256 outsideY = _mm256_cmp_ps(_mm256_andnot_ps(signBit, y), halfHeight, _CMP_GT_OQ);
+    outside += countLaneBits((unsigned int)_mm256_movemask_ps(_mm256_or_ps(outsideX, outsideY)));
+  }
+  return outside + wrapRangeScalar(positionsX, positionsY, objectSizes, i, count);
+}
+
+#endif // COLLISION_X86
+
+void checkBoundsBatch(float* positionsX, float* positionsY, const float* objectSizes, size_t count) {
+  size_t outside = 0;
+
+  switch (getCollisionKernel()) {
+#ifdef COLLISION_X86
+  case COLLISION_KERNEL_AVX2:
+    outside = wrapBatchAvx2(positionsX, positionsY, objectSizes, count);
+    break;
+  case COLLISION_KERNEL_SSE2:
+    outside = wrapBatchSse2(positionsX, positionsY, objectSizes, count);
+    break;
+#endif
+  default:
+    outside = wrapRangeScalar(positionsX, positionsY, objectSizes, 0, count);
+  }
+
+  // rare - the first wrong position is searched for the message only
+  if (outside > 0) {
+    for (size_t i = 0; i < count; i++) {
+      if (std::fabs(positionsX[i]) > SCENE_WIDTH + objectSizes[i] || std::fabs(positionsY[i]) > SCENE_HEIGHT + objectSizes[i]) {
+        reportOutOfBounds(glm::vec3(positionsX[i], positionsY[i], 0.0f));
+        break;
+      }
+    }
+    outOfBoundsCount.fetch_add(outside - 1);
+  }
+}
+
+// END OF BATCH WRAPPING FUNCTIONS
+//----------------------------------------------------------------------------------------
@@ -0,0 +1,87 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    collision.h
+ * \author  Sean Phay
+ * \date    2023
+ * \brief   Collision tests and wrapping of the positions inside the scene.
+ */
+//----------------------------------------------------------------------------------------
+
+#ifndef __COLLISION_H
+#define __COLLISION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+// implementations of the batch tests, picked by the processor at the first call
+enum { COLLISION_KERNEL_SCALAR, COLLISION_KERNEL_SSE2, COLLISION_KERNEL_AVX2, COLLISION_KERNELS_COUNT };
+
+/// Checks whether a given point is inside a sphere or not.
+bool pointInSphere(const glm::vec3& point, const glm::vec3& center, float radius);
+
+/// Checks if there is intersection between two given spheres or not.
+bool spheresIntersection(const glm::vec3& center1, float radius1, const glm::vec3& center2, float radius2);
+
+/// Checks if a sphere moving along a segment hits another sphere, returns the first contact in fraction (0 ... 1).
+bool sweptSphereIntersection(const glm::vec3& start, const glm::vec3& end, float radius1, const glm::vec3& center2, float radius2, float& fraction);
+
+/// Makes a given location to be valid position inside a scene (wraps it around the scene borders).
+glm::vec3 checkBounds(const glm::vec3 & position, float objectSize = 1.0f);
+
+//**************************************************************************************************
+/// checkBounds() for arrays of positions, the z coordinates are not changed.
+/**
+ Wraps x - width * floor((x + half) / width) without branches, eight or four positions at once
+ (the implementation selected by selectCollisionKernel()). The results equal checkBounds() up to
+ the rounding of the last bit.
+
+ \param[in,out] positionsX    X coordinates of the object centers.
+ \param[in,out] positionsY    Y coordinates.
+ \param[in]     objectSizes   Sizes of the objects.
+ \param[in]     count         Number of the positions.
+*/
+void checkBoundsBatch(float* positionsX, float* positionsY, const float* objectSizes, size_t count);
+
+/// Number of positions found outside of the scene after the wrapping (only the first one is printed).
+size_t getOutOfBoundsCount();
+
+//**************************************************************************************************
+/// Tests one sphere against many spheres stored as separate coordinate arrays.
+/**
+ Same test as spheresIntersection(), but the squared distances are compared (no square root)
+ eight or four spheres at once. Bit i % 64 of hitMask[i / 64] is set when the sphere i is hit.
+
+ \param[in]  center      Center of the tested sphere.
+ \param[in]  radius      Radius of the tested sphere.
+ \param[in]  centersX    Coordinates of the centers of the other spheres.
+ \param[in]  centersY
+ \param[in]  centersZ
+ \param[in]  radii       Radii of the other spheres.
+ \param[in]  count       Number of the other spheres.
+ \param[out] hitMask     (count + 63) / 64 words, all of them are overwritten.
+ \return                 Number of the hit spheres.
+*/
+size_t spheresIntersectionBatch(const glm::vec3& center, float radius,
+  const float* centersX, const float* centersY, const float* centersZ, const float* radii,
+  size_t count, uint64_t* hitMask);
+
+/// pointInSphere() for one point and many spheres, the mask and the result as in spheresIntersectionBatch().
+size_t pointInSphereBatch(const glm::vec3& point,
+  const float* centersX, const float* centersY, const float* centersZ, const float* radii,
+  size_t count, uint64_t* hitMask);
+
+/// True if the processor can run an implementation of the batch tests.
+bool isCollisionKernelSupported(int kernel);
+
+/// Selects the implementation of the batch tests (the best supported one by default).
+/** Returns false if the processor does not support it, the previous one is kept. */
+bool selectCollisionKernel(int kernel);
+
+/// Implementation used by the batch tests (one of COLLISION_KERNEL_*).
+int getCollisionKernel();
+
+/// Name of an implementation ("scalar", "sse2", "avx2").
+const char* getCollisionKernelName(int kernel);
+
+#endif // __COLLISION_H
@@ -10,21 +10,111 @@
 #ifndef __DATA_H
 #define __DATA_H
 
+#include <cmath>
+#include <string>
+
 #define WINDOW_WIDTH   1080
 #define WINDOW_HEIGHT  1080
 #define WINDOW_TITLE   "Forest Scene"
 
+// fixed step of the simulation - one timer callback, the game time does not follow the wall clock
+#define SIMULATION_TIMESTEP_MS   33
+#define SIMULATION_TIMESTEP      (0.001f * SIMULATION_TIMESTEP_MS)  // seconds
+#define SIMULATION_CHUNK_SIZE    1024 // objects in one job of the parallel update
+#define OFFSCREEN_DEFAULT_FRAMES 300  // frames drawn by --offscreen without --frames
+#define CAPTURE_RING_SIZE        3    // frames between the copy of a captured frame and its reading
+#define CAPTURE_QUEUE_LIMIT      8    // frames waiting for the encoding, further recorded frames are dropped
+
+// golden image tests (--golden), rendered on the software rasterizer
+#define GOLDEN_SIZE          256    // width and height of the images without --offscreen
+#define GOLDEN_TICKS         90     // simulation steps before the images are taken
+#define GOLDEN_SEED          2023   // seed of the scenery and of the missiles
+#define GOLDEN_THRESHOLD     0.1f   // largest tolerated YIQ difference of one pixel
+#define GOLDEN_MAX_DIFFERENT 0.002f // tolerated fraction of the pixels over the threshold
+#define GOLDEN_SKIP_CODE     77     // exit code without an EGL display or driver (ctest SKIP_RETURN_CODE)
+
 // keys used in the key map
 enum { KEY_LEFT_ARROW, KEY_RIGHT_ARROW, KEY_UP_ARROW, KEY_DOWN_ARROW, KEY_SPACE, KEY_UP_HEIGHT, KEY_DOWN_HEIGHT, KEY_EXPLODE1, KEY_W, KEY_A, KEY_S, KEY_D, KEY_Q, KEY_E, KEY_P, KEY_O, KEYS_COUNT };
 
-// WIP => define the params for the palm trees here
+// categories of the clickable objects, the top 8 bits of the pick id (see picking.h)
+enum { PICK_BACKGROUND, PICK_TARGET, PICK_FERN, PICK_SCATTERED_FERN };
+
+// categories of the objects hit by the missiles, the top 8 bits of the collider id (see projectiles.h)
+enum { COLLIDER_TARGET, COLLIDER_PALM_TREE, COLLIDER_STONE, COLLIDER_ROCK };
+
+// number of objects of the given type in the scene
 #define PALM_TREE_COUNT_MIN 5
-#define PALM_TREE_COUNT_MAX 10
-#define SPARROW_COUNT_MIN 1
-#define SPARROW_COUNT_MAX 1
+#define PALM_TREE_COUNT_MAX 64  // above what the scatter density gives - the density decides
+#define SPARROW_COUNT_MIN 256
+#define SPARROW_COUNT_MAX 512
 #define TARGET_COUNT_MIN 2
 #define TARGET_COUNT_MAX 5
 
+// procedural scenery placement (see scatter.h), densities are in objects per unit of area
+#define SCATTER_SEED             2023
+#define SCATTER_AREA             0.9f  // scenery is scattered over -SCATTER_AREA ... SCATTER_AREA
+#define PALM_TREE_MIN_DISTANCE   0.25f
+#define PALM_TREE_EXCLUSION      0.12f
+#define PALM_TREE_DENSITY        12.0f
+#define FERN_MIN_DISTANCE        0.15f
+#define FERN_EXCLUSION           0.05f
+#define FERN_DENSITY             6.0f
+#define STONE_MIN_DISTANCE       0.4f
+#define STONE_EXCLUSION          0.08f
+#define STONE_DENSITY            1.0f
+#define ROCK_MIN_DISTANCE        0.4f
+#define ROCK_EXCLUSION           0.08f
+#define ROCK_DENSITY             1.0f
+
+// heights of the scenery object centres above the terrain (see heightfield.h)
+#define PALM_TREE_BASE_HEIGHT    0.24f
+#define FERN_BASE_HEIGHT        -0.02f
+#define STONE_BASE_HEIGHT        0.13f
+#define ROCK_BASE_HEIGHT         0.08f
+#define HEIGHTFIELD_RESOLUTION   128   // samples along each side of the terrain
+
+// wind moving the vegetation (see lighting.vert), offset of the top of the plant in world units
+#define WIND_DIRECTION           glm::vec3(0.8f, 0.6f, 0.0f)
+#define WIND_STRENGTH            0.01f
+
+// flock of the sparrows (see flock.h), distances in world units, speeds per second
+#define FLOCK_NEIGHBOUR_RADIUS   0.15f  // also the cell size of the neighbour grid
+#define FLOCK_SEPARATION_RADIUS  0.05f
+#define FLOCK_SEPARATION_WEIGHT  0.004f
+#define FLOCK_ALIGNMENT_WEIGHT   1.0f
+#define FLOCK_COHESION_WEIGHT    0.8f
+#define FLOCK_BOUNDS_WEIGHT      4.0f   // return towards the flight area, per unit of the overshoot
+#define FLOCK_SPEED_MIN          0.15f
+#define FLOCK_SPEED_MAX          0.35f
+#define FLOCK_ACCELERATION_MAX   0.6f
+#define FLOCK_AREA               0.8f   // the birds fly over -FLOCK_AREA ... FLOCK_AREA
+#define FLOCK_HEIGHT_MIN         0.35f
+#define FLOCK_HEIGHT_MAX         0.8f
+#define FLOCK_CHUNK_SIZE         256    // birds in one job, the steering is heavier than the other updates
+
+// GPU particle system (see particles.h)
+#define PARTICLE_CAPACITY              131072  // particles on the GPU, new ones replace the oldest
+#define PARTICLE_FRAMES                16      // frames of the explosion texture
+#define PARTICLE_SPARKS_PER_EXPLOSION  24
+#define PARTICLE_SPARK_SPEED           0.6f
+#define PARTICLE_GRAVITY               0.8f
+#define PARTICLE_DRAG                  1.5f    // fraction of the spark velocity lost per second
+#define PARTICLE_SEED                  7
+
+// impostors of the distant trees (see impostor.h), distances can be changed in config.ini
+#define IMPOSTOR_VIEWS           8     // directions around the vertical axis baked into the atlas
+#define IMPOSTOR_TOP_ELEVATION   60.0f // degrees, steeper views show the top view of the atlas
+#define IMPOSTOR_RESOLUTION      128   // pixels per view
+#define IMPOSTOR_DISTANCE        1.5f  // mesh => impostor switch distance from the camera
+#define IMPOSTOR_FADE_BAND       0.3f  // width of the cross-fade around the switch distance
+
+// terrain streaming (see terrain.h), radii are in chunks around the penguin
+#define TERRAIN_CHUNK_GRID                4  // terrain model is split into GRID x GRID chunks
+#define TERRAIN_CHUNK_LOAD_RADIUS         3
+#define TERRAIN_CHUNK_UNLOAD_RADIUS       4  // larger than the load radius => no reloading at the chunk border
+#define TERRAIN_CHUNK_MAX_BUILDS          4  // chunks built on the worker threads at the same time
+#define TERRAIN_CHUNK_UPLOADS_PER_UPDATE  2
+
 // Removed sections on asteroids and ufo
 // missles can be used to throw another object
 #define PENGUIN_VIEW_ANGLE_DELTA 2.5f
@@ -34,13 +124,15 @@ enum { KEY_LEFT_ARROW, KEY_RIGHT_ARROW, KEY_UP_ARROW, KEY_DOWN_ARROW, KEY_SPACE,
 #define PENGUIN_LENGTH_MAX        0.1f
 #define PENGUIN_LENGTH_MIN       0.25f
 #define PENGUIN_HEIGHT_MAX        1.0f
-#define PENGUIN_HEIGHT_MIN        0.0f
+#define PENGUIN_HEIGHT_MIN        0.0f  // above the terrain
 
 #define MISSILE_MAX_DISTANCE       1.5f
 #define MISSILE_LAUNCH_TIME_DELAY  0.25f // seconds
+#define PROJECTILE_CAPACITY        4096  // missiles in flight at most, their arrays are allocated once
+#define PROJECTILE_CELL_SIZE       0.25f // cell of the grid of the spheres the missiles hit
 
 #define PENGUIN_SIZE        0.1f
-#define SPARROW_SIZE     0.2f
+#define SPARROW_SIZE     0.04f
 #define CAT_SIZE         0.2f
 #define TERRAIN_SIZE     1.0f
 #define ROCK_SIZE        0.2f
@@ -0,0 +1,279 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    entities.cpp
+ * \author  Sean Phay
+ * \date    2023
+ * \brief   Structure-of-arrays storage of the moving objects, addressed by entity handles.
+ */
+//----------------------------------------------------------------------------------------
+
+#include "entities.h"
+#include "collision.h"
+#include "jobs.h"
+#include "data.h"
+
+// ----------------------------------------------------------------------------------------
+// START OF HELPER FUNCTIONS
+
+// moves the entity at index from into index to (all components and the slot tables)
+void moveEntity(EntityStore& store, size_t from, size_t to) {
+  store.positionX[to] = store.positionX[from];
+  store.positionY[to] = store.positionY[from];
+  store.positionZ[to] = store.positionZ[from];
+  store.directionX[to] = store.directionX[from];
+  store.directionY[to] = store.directionY[from];
+  store.directionZ[to] = store.directionZ[from];
+  store.speed[to] = store.speed[from];
+  store.size[to] = store.size[from];
+  store.startTime[to] = store.startTime[from];
+  store.currentTime[to] = store.currentTime[from];
+  store.destroyed[to] = store.destroyed[from];
+
+  store.entitySlot[to] = store.entitySlot[from];
+  store.slotIndex[store.entitySlot[to]] = (unsigned int)to;
+}
+
+// removes the entity at an index, the last one takes its place
+void removeEntityAt(EntityStore& store, size_t index) {
+  unsigned int slot = store.entitySlot[index];
+  store.slotGeneration[slot]++;
+  store.freeSlots.push_back(slot);
+
+  size_t last = entityCount(store) - 1;
+  if (index != last)
+    moveEntity(store, last, index);
+
+  store.positionX.pop_back();
+  store.positionY.pop_back();
+  store.positionZ.pop_back();
+  store.directionX.pop_back();
+  store.directionY.pop_back();
+  store.directionZ.pop_back();
+  store.speed.pop_back();
+  store.size.pop_back();
+  store.startTime.pop_back();
+  store.currentTime.pop_back();
+  store.destroyed.pop_back();
+  store.entitySlot.pop_back();
+}
+
+// the loops below take the arrays through restrict pointers - without them the compiler
+// has to assume the arrays overlap and keeps the loops scalar
+
+void moveEntityRange(EntityStore& store, size_t begin, size_t end, float elapsedTime) {
+  float* __restrict positionX = store.positionX.data();
+  float* __restrict positionY = store.positionY.data();
+  float* __restrict positionZ = store.positionZ.data();
+  const float* __restrict directionX = store.directionX.data();
+  const float* __restrict directionY = store.directionY.data();
+  const float* __restrict directionZ = store.directionZ.data();
+  const float* __restrict speed = store.speed.data();
+  float* __restrict currentTime = store.currentTime.data();
+
+  for (size_t i = begin; i < end; i++) {
+    float step = (elapsedTime - currentTime[i]) * speed[i];
+    currentTime[i] = elapsedTime;
+    positionX[i] += step * directionX[i];
+    positionY[i] += step * directionY[i];
+    positionZ[i] += step * directionZ[i];
+  }
+}
+
+void wrapEntityRange(EntityStore& store, size_t begin, size_t end) {
+  checkBoundsBatch(store.positionX.data() + begin, store.positionY.data() + begin, store.size.data() + begin, end - begin);
+}
+
+void expireEntityRange(EntityStore& store, size_t begin, size_t end, float maxDistance) {
+  const float* __restrict speed = store.speed.data();
+  const float* __restrict startTime = store.startTime.data();
+  const float* __restrict currentTime = store.currentTime.data();
+  unsigned char* __restrict destroyed = store.destroyed.data();
+
+  for (size_t i = begin; i < end; i++)
+    destroyed[i] |= (unsigned char)((currentTime[i] - startTime[i]) * speed[i] > maxDistance);
+}
+
+// END OF HELPER FUNCTIONS
+// ----------------------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------------------
+// START OF ENTITY FUNCTIONS
+
+EntityHandle createEntity(EntityStore& store, const Object& object) {
+  EntityHandle handle;
+
+  if (store.freeSlots.empty()) {
+    handle.slot = (unsigned int)store.slotIndex.size();
+    store.slotIndex.push_back(0);
+    store.slotGeneration.push_back(0);
+  }
+  else {
+    handle.slot = store.freeSlots.back();
+    store.freeSlots.pop_back();
+  }
+  handle.generation = store.slotGeneration[handle.slot];
+  store.slotIndex[handle.slot] = (unsigned int)entityCount(store);
+
+  store.positionX.push_back(object.position.x);
+  store.positionY.push_back(object.position.y);
+  store.positionZ.push_back(object.position.z);
+  store.directionX.push_back(object.direction.x);
+  store.directionY.push_back(object.direction.y);
+  store.directionZ.push_back(object.direction.z);
+  store.speed.push_back(object.speed);
+  store.size.push_back(object.size);
+  store.startTime.push_back(object.startTime);
+  store.currentTime.push_back(object.currentTime);
+  store.destroyed.push_back(object.destroyed ? 1 : 0);
+  store.entitySlot.push_back(handle.slot);
+
+  return handle;
+}
+
+bool isEntityAlive(const EntityStore& store, EntityHandle handle) {
+  return handle.slot < store.slotGeneration.size() && store.slotGeneration[handle.slot] == handle.generation;
+}
+
+size_t entityIndex(const EntityStore& store, EntityHandle handle) {
+  return store.slotIndex[handle.slot];
+}
+
+EntityHandle entityHandle(const EntityStore& store, size_t index) {
+  EntityHandle handle;
+  handle.slot = store.entitySlot[index];
+  handle.generation = store.slotGeneration[handle.slot];
+  return handle;
+}
+
+void destroyEntity(EntityStore& store, EntityHandle handle) {
+  if (isEntityAlive(store, handle))
+    removeEntityAt(store, entityIndex(store, handle));
+}
+
+size_t removeDestroyedEntities(EntityStore& store) {
+  size_t removed = 0;
+  size_t i = 0;
+
+  // the moved entity is tested again at the same index
+  while (i < entityCount(store)) {
+    if (store.destroyed[i]) {
+      removeEntityAt(store, i);
+      removed++;
+    }
+    else {
+      i++;
+    }
+  }
+  return removed;
+}
+
+void reserveEntities(EntityStore& store, size_t capacity) {
+  store.positionX.reserve(capacity);
+  store.positionY.reserve(capacity);
+  store.positionZ.reserve(capacity);
+  store.directionX.reserve(capacity);
+  store.directionY.reserve(capacity);
+  store.directionZ.reserve(capacity);
+  store.speed.reserve(capacity);
+  store.size.reserve(capacity);
+  store.startTime.reserve(capacity);
+  store.currentTime.reserve(capacity);
+  store.destroyed.reserve(capacity);
+  store.entitySlot.reserve(capacity);
+  store.slotIndex.reserve(capacity);
+  store.slotGeneration.reserve(capacity);
+  store.freeSlots.reserve(capacity);
+}
+
+void clearEntities(EntityStore& store) {
+  for (size_t i = 0; i < entityCount(store); i++) {
+    store.slotGeneration[store.entitySlot[i]]++;
+    store.freeSlots.push_back(store.entitySlot[i]);
+  }
+
+  store.positionX.clear();
+  store.positionY.clear();
+  store.positionZ.clear();
+  store.directionX.clear();
+  store.directionY.clear();
+  store.directionZ.clear();
+  store.speed.clear();
+  store.size.clear();
+  store.startTime.clear();
+  store.currentTime.clear();
+  store.destroyed.clear();
+  store.entitySlot.clear();
+}
+
+void getEntityObject(const EntityStore& store, size_t index, Object& object) {
+  object.position = glm::vec3(store.positionX[index], store.positionY[index], store.positionZ[index]);
+  object.direction = glm::vec3(store.directionX[index], store.directionY[index], store.directionZ[index]);
+  object.speed = store.speed[index];
+  object.size = store.size[index];
+  object.destroyed = (store.destroyed[index] != 0);
+  object.startTime = store.startTime[index];
+  object.currentTime = store.currentTime[index];
+}
+
+// END OF ENTITY FUNCTIONS
+// ----------------------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------------------
+// START OF ENTITY UPDATE
+
+void updateMissileEntities(EntityStore& missiles, float elapsedTime) {
+
+  parallelFor(entityCount(missiles), SIMULATION_CHUNK_SIZE, [&](size_t begin, size_t end) {
+    moveEntityRange(missiles, begin, end, elapsedTime);
+    wrapEntityRange(missiles, begin, end);
+    expireEntityRange(missiles, begin, end, MISSILE_MAX_DISTANCE);
+  });
+
+  removeDestroyedEntities(missiles);
+}
+
+void collideEntities(EntityStore& movers, const EntityStore& targets, std::vector<glm::vec3>& hits) {
+
+  const size_t count = entityCount(movers);
+  const size_t targetCount = entityCount(targets);
+  const float* __restrict targetX = targets.positionX.data();
+  const float* __restrict targetY = targets.positionY.data();
+  const float* __restrict targetZ = targets.positionZ.data();
+  const float* __restrict targetRadius = targets.size.data();
+
+  // entities hit in this call - the ones flagged before are not reported again
+  std::vector<unsigned char> hit(count, 0);
+
+  parallelFor(count, SIMULATION_CHUNK_SIZE, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      if (movers.destroyed[i])
+        continue;
+
+      const float x = movers.positionX[i];
+      const float y = movers.positionY[i];
+      const float z = movers.positionZ[i];
+      const float radius = movers.size[i];
+
+      // all targets are tested - no early exit, so the loop stays vectorized
+      int inside = 0;
+      for (size_t t = 0; t < targetCount; t++) {
+        float dx = targetX[t] - x;
+        float dy = targetY[t] - y;
+        float dz = targetZ[t] - z;
+        float reach = targetRadius[t] + radius;
+        inside |= (dx * dx + dy * dy + dz * dz < reach * reach);
+      }
+      hit[i] = (unsigned char)inside;
+      movers.destroyed[i] = (unsigned char)inside;
+    }
+  });
+
+  hits.clear();
+  for (size_t i = 0; i < count; i++) {
+    if (hit[i])
+      hits.push_back(glm::vec3(movers.positionX[i], movers.positionY[i], movers.positionZ[i]));
+  }
+}
+
+// END OF ENTITY UPDATE
+// ----------------------------------------------------------------------------------------
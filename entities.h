@@ -0,0 +1,124 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    entities.h
+ * \author  Sean Phay
+ * \date    2023
+ * \brief   Structure-of-arrays storage of the moving objects, addressed by entity handles.
+ */
+//----------------------------------------------------------------------------------------
+
+#ifndef __ENTITIES_H
+#define __ENTITIES_H
+
+#include <cstddef>
+#include <new>
+#include <vector>
+#include "objects.h"
+
+// alignment of the component arrays in bytes - one AVX register
+const size_t ENTITY_ALIGNMENT = 32;
+
+// allocator of the component arrays, the loops over them start on an aligned address
+template <typename T>
+struct AlignedAllocator {
+  typedef T value_type;
+
+  AlignedAllocator() {}
+  template <typename U> AlignedAllocator(const AlignedAllocator<U>&) {}
+
+  T* allocate(size_t count) {
+    return (T*)::operator new(count * sizeof(T), std::align_val_t(ENTITY_ALIGNMENT));
+  }
+  void deallocate(T* pointer, size_t) {
+    ::operator delete(pointer, std::align_val_t(ENTITY_ALIGNMENT));
+  }
+
+  template <typename U> bool operator==(const AlignedAllocator<U>&) const { return true; }
+  template <typename U> bool operator!=(const AlignedAllocator<U>&) const { return false; }
+};
+
+typedef std::vector<float, AlignedAllocator<float> >                 FloatArray;
+typedef std::vector<unsigned char, AlignedAllocator<unsigned char> > FlagArray;
+
+// stable reference to an entity - stays valid while the arrays are compacted, dead after destroyEntity()
+typedef struct _EntityHandle {
+  unsigned int slot;
+  unsigned int generation;  // generation of the slot when the entity was created
+} EntityHandle;
+
+//**************************************************************************************************
+/// Objects of one kind stored component by component.
+/**
+ The components of the entity i are positionX[i], positionY[i], ..., all arrays have the same
+ length and the live entities are packed at 0 ... count-1 - a loop over one component reads
+ a contiguous aligned array, which the compiler turns into SIMD code. Removing an entity moves
+ the last one into its place, the handles follow it through the slot tables.
+*/
+typedef struct _EntityStore {
+  FloatArray positionX, positionY, positionZ;
+  FloatArray directionX, directionY, directionZ;
+  FloatArray speed;
+  FloatArray size;
+  FloatArray startTime;
+  FloatArray currentTime;
+  FlagArray  destroyed;                     // 0 or 1, removed by removeDestroyedEntities()
+
+  std::vector<unsigned int> entitySlot;     // slot of the entity at an index
+  std::vector<unsigned int> slotIndex;      // index of the entity in a slot
+  std::vector<unsigned int> slotGeneration; // incremented when the entity of a slot is destroyed
+  std::vector<unsigned int> freeSlots;
+} EntityStore;
+
+/// Number of the stored entities (including the ones flagged destroyed).
+inline size_t entityCount(const EntityStore& store) { return store.positionX.size(); }
+
+/// Adds an entity initialized from an object and returns its handle.
+EntityHandle createEntity(EntityStore& store, const Object& object);
+
+/// True if the handle refers to an entity which was not removed yet.
+bool isEntityAlive(const EntityStore& store, EntityHandle handle);
+
+/// Current index of a live entity in the component arrays (changes when other entities are removed).
+size_t entityIndex(const EntityStore& store, EntityHandle handle);
+
+/// Handle of the entity at an index.
+EntityHandle entityHandle(const EntityStore& store, size_t index);
+
+/// Removes an entity right away, the last entity moves into its index.
+void destroyEntity(EntityStore& store, EntityHandle handle);
+
+/// Removes the entities flagged destroyed. Returns their number.
+size_t removeDestroyedEntities(EntityStore& store);
+
+/// Allocates the arrays for a number of entities at once, adding entities up to it does not allocate.
+void reserveEntities(EntityStore& store, size_t capacity);
+
+/// Removes all entities, the handles given out before are dead.
+void clearEntities(EntityStore& store);
+
+/// Copies the components of the entity at an index into an object (e.g. for the drawing).
+void getEntityObject(const EntityStore& store, size_t index, Object& object);
+
+//**************************************************************************************************
+/// Moves the missiles and removes those which flew further than MISSILE_MAX_DISTANCE.
+/**
+ updateMissiles() over the arrays: one loop moves all entities, one wraps them into the scene and
+ one flags the expired ones, split into chunks on all cores. The flagged ones are removed after.
+
+ \param[in,out] missiles     Missile entities.
+ \param[in]     elapsedTime  Current simulation time (seconds).
+*/
+void updateMissileEntities(EntityStore& missiles, float elapsedTime);
+
+//**************************************************************************************************
+/// Tests the moving entities against static ones, an entity is flagged destroyed by any hit.
+/**
+ Compares squared distances, the loop over the targets has no branch and is vectorized.
+
+ \param[in,out] movers   Entities tested, the hitting ones are flagged (removed by the next update).
+ \param[in]     targets  Bounding spheres (position, size = radius) the entities hit.
+ \param[out]    hits     Positions of the flagged entities in the order of their indices.
+*/
+void collideEntities(EntityStore& movers, const EntityStore& targets, std::vector<glm::vec3>& hits);
+
+#endif // __ENTITIES_H
@@ -1,18 +1,16 @@
 #version 140
 
-uniform float time;           // used for simulation of moving lights (such as sun) and to select proper animation frame
-uniform mat4 Vmatrix;         // view (camera) transform --> world to eye coordinates
+uniform float time;           // current time, used to select proper animation frame
 uniform sampler2D texSampler; // sampler for texture access
 
-smooth in vec3 position_v;    // camera space fragment position
 smooth in vec2 texCoord_v;    // fragment texture coordinates
+flat in float startTime_v;    // time the explosion started
+flat in float frameDuration_v; // duration of one animation frame of this explosion
 
 out vec4 color_f;             // outgoing fragment color
 
 // there are 8 frames in the row, two rows total
 uniform ivec2 pattern = ivec2(8, 2);
-// one frame lasts 0.1s
-uniform float frameDuration = 0.1f;
 
 
 vec4 sampleTexture(int frame) {
@@ -27,7 +25,7 @@ vec4 sampleTexture(int frame) {
 
 void main() {
   // frame of the texture to be used for explosion drawing 
-  int frame = int(time / frameDuration);
+  int frame = int((time - startTime_v) / frameDuration_v);
 
   // sample proper frame of the texture to get a fragment color  
   color_f = sampleTexture(frame);
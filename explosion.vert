@@ -1,17 +1,30 @@
 #version 140
 
-uniform mat4 PVMmatrix;     // Projection * View * Model --> model to clip coordinates
+uniform mat4 PVmatrix;      // Projection * View --> world to clip coordinates
+uniform vec3 cameraRight;   // billboard axes - rows of the view rotation (world coordinates)
+uniform vec3 cameraUp;
 
-in vec3 position;           // vertex position in world space
-in vec2 texCoord;           // incoming texture coordinates
+in vec3 center;             // explosion position in world space
+in float size;              // explosion size
+in float startTime;         // time the explosion started
+in float frameDuration;     // duration of one animation frame
+in vec2 texCoord;           // incoming texture coordinates, also the corner of the quad
 
-smooth out vec2 texCoord_v; // outgoing vertex texture coordinates
+smooth out vec2 texCoord_v;        // outgoing vertex texture coordinates
+flat out float startTime_v;        // the same for the whole quad
+flat out float frameDuration_v;
 
 void main() {
 
+  // camera facing quad, corner -1..1 derived from the texture coordinates
+  vec2 corner = 2.0 * texCoord - 1.0;
+  vec3 position = center + size * (corner.x * cameraRight + corner.y * cameraUp);
+
   // vertex position after the projection (gl_Position is predefined output variable)
-  gl_Position = PVMmatrix * vec4(position, 1);   // outgoing vertex in clip coordinates
+  gl_Position = PVmatrix * vec4(position, 1);   // outgoing vertex in clip coordinates
 
   // outputs entering the fragment shader
   texCoord_v = texCoord;
+  startTime_v = startTime;
+  frameDuration_v = frameDuration;
 }
@@ -0,0 +1,43 @@
+// Code shared by lighting.frag and impostor.frag, inserted after their #version line by
+// createShaderWithCommonFile(). The mesh and its impostor must fade and fog the same way,
+// otherwise the switch between them is visible.
+
+uniform bool fogOnLinearToggle; // fog
+uniform bool fogOnExpToggle;
+uniform float fogNearValue;
+uniform float fogDensityValue;
+
+// 4x4 ordered dither
+float ditherThreshold() {
+  const float bayer[16] = float[16](
+     0.0,  8.0,  2.0, 10.0,
+    12.0,  4.0, 14.0,  6.0,
+     3.0, 11.0,  1.0,  9.0,
+    15.0,  7.0, 13.0,  5.0
+  );
+  int index = int(mod(gl_FragCoord.x, 4.0)) + 4 * int(mod(gl_FragCoord.y, 4.0));
+  return (bayer[index] + 0.5) / 16.0;
+}
+
+// cross-fade: the mesh keeps the pixel, the impostor draws exactly the other ones
+bool meshKeepsPixel(float fade) {
+  return ditherThreshold() < fade;
+}
+
+// fog of the color at the distance from the camera
+vec4 applyFog(vec4 color, float distToCam) {
+  vec4 fogcolor = vec4(0.4, 0.4, 0.4, 1);
+  float fogFar = 2.0f;
+
+  if (fogOnLinearToggle) {
+    float fogAmount = (fogNearValue - distToCam) / (fogNearValue - fogFar);
+    fogAmount = clamp(fogAmount, 0.0, 1.0);
+    color = mix(color, fogcolor, fogAmount);
+  }
+
+  if (fogOnExpToggle) {
+    float fogAmount = 1.0 - exp(-fogDensityValue * distToCam);
+    color = mix(color, fogcolor, fogAmount);
+  }
+  return color;
+}
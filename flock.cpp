@@ -0,0 +1,290 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    flock.cpp
+ * \author  Sean Phay
+ * \date    2023
+ * \brief   Flock of sparrows steered by separation, alignment and cohesion (boids).
+ */
+//----------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cmath>
+#include "flock.h"
+#include "jobs.h"
+#include "replay.h"
+#include "data.h"
+
+// ----------------------------------------------------------------------------------------
+// START OF HELPER FUNCTIONS
+
+// cell coordinate of a position, the birds outside the grid belong to its border cells
+inline int flockCellCoordinate(const Flock& flock, float x) {
+  int cell = int((x - flock.gridOrigin) * flock.invCellSize);
+  return std::min(std::max(cell, 0), flock.gridSize - 1);
+}
+
+// moves the values of one component into the cell order (the padding of scratch stays zero)
+void reorderFlockArray(Flock& flock, FloatArray& values) {
+  for (size_t i = 0; i < flock.count; i++)
+    flock.scratch[i] = values[flock.order[i]];
+  values.swap(flock.scratch);
+}
+
+// counting sort of the birds by their cells, fills cellStart
+void sortFlockByCells(Flock& flock) {
+  const size_t count = flockSize(flock);
+  const size_t cells = size_t(flock.gridSize) * flock.gridSize;
+
+  flock.birdCell.resize(count);
+  flock.cellStart.assign(cells + 1, 0);
+
+  for (size_t i = 0; i < count; i++) {
+    int x = flockCellCoordinate(flock, flock.positionX[i]);
+    int y = flockCellCoordinate(flock, flock.positionY[i]);
+    flock.birdCell[i] = (unsigned int)(y * flock.gridSize + x);
+    flock.cellStart[flock.birdCell[i] + 1]++;
+  }
+
+  for (size_t c = 0; c < cells; c++)
+    flock.cellStart[c + 1] += flock.cellStart[c];
+
+  // stable, the birds of a cell keep their order => the same result with any thread count
+  std::vector<unsigned int> next(flock.cellStart.begin(), flock.cellStart.end() - 1);
+  flock.order.resize(count);
+  for (size_t i = 0; i < count; i++)
+    flock.order[next[flock.birdCell[i]]++] = (unsigned int)i;
+
+  reorderFlockArray(flock, flock.positionX);
+  reorderFlockArray(flock, flock.positionY);
+  reorderFlockArray(flock, flock.positionZ);
+  reorderFlockArray(flock, flock.velocityX);
+  reorderFlockArray(flock, flock.velocityY);
+  reorderFlockArray(flock, flock.velocityZ);
+}
+
+// steering force keeping a coordinate within minimum ... maximum
+inline float flockBoundsForce(float value, float minimum, float maximum) {
+  if (value < minimum)
+    return (minimum - value) * FLOCK_BOUNDS_WEIGHT;
+  if (value > maximum)
+    return (maximum - value) * FLOCK_BOUNDS_WEIGHT;
+  return 0.0f;
+}
+
+// partial sums of the neighbours of one bird, one column per lane
+typedef struct _FlockSums {
+  float count[FLOCK_LANES];
+  float velocityX[FLOCK_LANES], velocityY[FLOCK_LANES], velocityZ[FLOCK_LANES];
+  float offsetX[FLOCK_LANES], offsetY[FLOCK_LANES], offsetZ[FLOCK_LANES];         // neighbour - bird
+  float separationX[FLOCK_LANES], separationY[FLOCK_LANES], separationZ[FLOCK_LANES];
+} FlockSums;
+
+// adds the candidates begin ... end-1 within the neighbour radius of (x, y, z) to the sums
+// every lane sums its own candidates and the loop has no branch => one SIMD register per sum
+void sumFlockNeighbours(
+  const float* __restrict positionX, const float* __restrict positionY, const float* __restrict positionZ,
+  const float* __restrict velocityX, const float* __restrict velocityY, const float* __restrict velocityZ,
+  size_t begin, size_t end, float x, float y, float z, FlockSums& __restrict sums
+) {
+  const float neighbourRadius2 = FLOCK_NEIGHBOUR_RADIUS * FLOCK_NEIGHBOUR_RADIUS;
+  const float separationRadius2 = FLOCK_SEPARATION_RADIUS * FLOCK_SEPARATION_RADIUS;
+
+  for (size_t j = begin; j < end; j += FLOCK_LANES) {
+    for (size_t lane = 0; lane < FLOCK_LANES; lane++) {
+      // the lanes past the end are masked out (the arrays are padded, see sortFlockByCells())
+      const size_t candidate = j + lane;
+      const float dx = positionX[candidate] - x;
+      const float dy = positionY[candidate] - y;
+      const float dz = positionZ[candidate] - z;
+      const float distance2 = dx * dx + dy * dy + dz * dz;
+
+      const float inside = (candidate < end && distance2 < neighbourRadius2) ? 1.0f : 0.0f;
+      // pushed away from the close ones, the more the closer (0 for the bird itself, its offset is 0)
+      const float push = (candidate < end && distance2 < separationRadius2) ? 1.0f / (distance2 + 1e-6f) : 0.0f;
+
+      sums.count[lane] += inside;
+      sums.velocityX[lane] += inside * velocityX[candidate];
+      sums.velocityY[lane] += inside * velocityY[candidate];
+      sums.velocityZ[lane] += inside * velocityZ[candidate];
+      sums.offsetX[lane] += inside * dx;
+      sums.offsetY[lane] += inside * dy;
+      sums.offsetZ[lane] += inside * dz;
+      sums.separationX[lane] -= push * dx;
+      sums.separationY[lane] -= push * dy;
+      sums.separationZ[lane] -= push * dz;
+    }
+  }
+}
+
+inline float sumFlockLanes(const float* values) {
+  float sum = 0.0f;
+  for (size_t lane = 0; lane < FLOCK_LANES; lane++)
+    sum += values[lane];
+  return sum;
+}
+
+// new velocities of the birds begin ... end-1 from their neighbours
+void steerFlockRange(Flock& flock, size_t begin, size_t end, float timeDelta) {
+  const float* positionX = flock.positionX.data();
+  const float* positionY = flock.positionY.data();
+  const float* positionZ = flock.positionZ.data();
+  const float* velocityX = flock.velocityX.data();
+  const float* velocityY = flock.velocityY.data();
+  const float* velocityZ = flock.velocityZ.data();
+  const unsigned int* cellStart = flock.cellStart.data();
+
+  for (size_t i = begin; i < end; i++) {
+    const float x = positionX[i];
+    const float y = positionY[i];
+    const float z = positionZ[i];
+    const int cellX = flockCellCoordinate(flock, x);
+    const int cellY = flockCellCoordinate(flock, y);
+
+    FlockSums sums = {};
+
+    for (int cy = std::max(cellY - 1, 0); cy <= std::min(cellY + 1, flock.gridSize - 1); cy++) {
+      // the cells of one row are contiguous in the arrays => one range for the three of them
+      const unsigned int rowBegin = cellStart[cy * flock.gridSize + std::max(cellX - 1, 0)];
+      const unsigned int rowEnd = cellStart[cy * flock.gridSize + std::min(cellX + 1, flock.gridSize - 1) + 1];
+      sumFlockNeighbours(positionX, positionY, positionZ, velocityX, velocityY, velocityZ, rowBegin, rowEnd, x, y, z, sums);
+    }
+
+    // the bird itself was summed as its own neighbour
+    const float neighbours = sumFlockLanes(sums.count) - 1.0f;
+    float accelerationX = 0.0f, accelerationY = 0.0f, accelerationZ = 0.0f;
+
+    if (neighbours > 0.5f) {
+      const float invNeighbours = 1.0f / neighbours;
+      const float meanVelocityX = (sumFlockLanes(sums.velocityX) - velocityX[i]) * invNeighbours;
+      const float meanVelocityY = (sumFlockLanes(sums.velocityY) - velocityY[i]) * invNeighbours;
+      const float meanVelocityZ = (sumFlockLanes(sums.velocityZ) - velocityZ[i]) * invNeighbours;
+      // alignment - towards the mean velocity, cohesion - towards the centre (relative to the bird)
+      accelerationX = FLOCK_ALIGNMENT_WEIGHT * (meanVelocityX - velocityX[i]) + FLOCK_COHESION_WEIGHT * sumFlockLanes(sums.offsetX) * invNeighbours;
+      accelerationY = FLOCK_ALIGNMENT_WEIGHT * (meanVelocityY - velocityY[i]) + FLOCK_COHESION_WEIGHT * sumFlockLanes(sums.offsetY) * invNeighbours;
+      accelerationZ = FLOCK_ALIGNMENT_WEIGHT * (meanVelocityZ - velocityZ[i]) + FLOCK_COHESION_WEIGHT * sumFlockLanes(sums.offsetZ) * invNeighbours;
+    }
+    accelerationX += FLOCK_SEPARATION_WEIGHT * sumFlockLanes(sums.separationX) + flockBoundsForce(x, -FLOCK_AREA, FLOCK_AREA);
+    accelerationY += FLOCK_SEPARATION_WEIGHT * sumFlockLanes(sums.separationY) + flockBoundsForce(y, -FLOCK_AREA, FLOCK_AREA);
+    accelerationZ += FLOCK_SEPARATION_WEIGHT * sumFlockLanes(sums.separationZ) + flockBoundsForce(z, FLOCK_HEIGHT_MIN, FLOCK_HEIGHT_MAX);
+
+    // limited turning, then the speed kept within the flight range
+    const float acceleration = std::sqrt(accelerationX * accelerationX + accelerationY * accelerationY + accelerationZ * accelerationZ);
+    if (acceleration > FLOCK_ACCELERATION_MAX) {
+      const float scale = FLOCK_ACCELERATION_MAX / acceleration;
+      accelerationX *= scale;
+      accelerationY *= scale;
+      accelerationZ *= scale;
+    }
+
+    float newX = velocityX[i] + accelerationX * timeDelta;
+    float newY = velocityY[i] + accelerationY * timeDelta;
+    float newZ = velocityZ[i] + accelerationZ * timeDelta;
+
+    const float speed = std::sqrt(newX * newX + newY * newY + newZ * newZ);
+    const float clamped = std::min(std::max(speed, FLOCK_SPEED_MIN), FLOCK_SPEED_MAX);
+    const float scale = speed > 0.0f ? clamped / speed : 0.0f;
+
+    flock.steeredX[i] = newX * scale;
+    flock.steeredY[i] = newY * scale;
+    flock.steeredZ[i] = newZ * scale;
+  }
+}
+
+void moveFlockRange(Flock& flock, size_t begin, size_t end, float timeDelta) {
+  float* __restrict positionX = flock.positionX.data();
+  float* __restrict positionY = flock.positionY.data();
+  float* __restrict positionZ = flock.positionZ.data();
+  const float* __restrict velocityX = flock.velocityX.data();
+  const float* __restrict velocityY = flock.velocityY.data();
+  const float* __restrict velocityZ = flock.velocityZ.data();
+
+  for (size_t i = begin; i < end; i++) {
+    positionX[i] += velocityX[i] * timeDelta;
+    positionY[i] += velocityY[i] * timeDelta;
+    positionZ[i] += velocityZ[i] * timeDelta;
+  }
+}
+
+// END OF HELPER FUNCTIONS
+// ----------------------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------------------
+// START OF FLOCK FUNCTIONS
+
+void initializeFlock(Flock& flock, size_t count, float elapsedTime) {
+
+  // all padded by zeros, the velocities are swapped with the steered ones
+  flock.positionX.assign(count + FLOCK_LANES, 0.0f);
+  flock.positionY.assign(count + FLOCK_LANES, 0.0f);
+  flock.positionZ.assign(count + FLOCK_LANES, 0.0f);
+  flock.velocityX.assign(count + FLOCK_LANES, 0.0f);
+  flock.velocityY.assign(count + FLOCK_LANES, 0.0f);
+  flock.velocityZ.assign(count + FLOCK_LANES, 0.0f);
+  flock.steeredX.assign(count + FLOCK_LANES, 0.0f);
+  flock.steeredY.assign(count + FLOCK_LANES, 0.0f);
+  flock.steeredZ.assign(count + FLOCK_LANES, 0.0f);
+  flock.scratch.assign(count + FLOCK_LANES, 0.0f);
+  flock.count = count;
+  flock.currentTime = elapsedTime;
+
+  // the grid covers the whole scene, the birds leaving FLOCK_AREA are turned back before its border
+  flock.gridSize = std::max(1, int(std::ceil(2.0f * SCENE_WIDTH / FLOCK_NEIGHBOUR_RADIUS)));
+  flock.gridOrigin = -SCENE_WIDTH;
+  flock.invCellSize = 1.0f / FLOCK_NEIGHBOUR_RADIUS;
+
+  for (size_t i = 0; i < count; i++) {
+    flock.positionX[i] = FLOCK_AREA * (2.0f * decorationRandom() - 1.0f);
+    flock.positionY[i] = FLOCK_AREA * (2.0f * decorationRandom() - 1.0f);
+    flock.positionZ[i] = FLOCK_HEIGHT_MIN + (FLOCK_HEIGHT_MAX - FLOCK_HEIGHT_MIN) * decorationRandom();
+
+    float heading = 2.0f * float(M_PI) * decorationRandom();
+    float speed = FLOCK_SPEED_MIN + (FLOCK_SPEED_MAX - FLOCK_SPEED_MIN) * decorationRandom();
+    flock.velocityX[i] = speed * std::cos(heading);
+    flock.velocityY[i] = speed * std::sin(heading);
+    flock.velocityZ[i] = 0.0f;
+  }
+}
+
+void updateFlock(Flock& flock, float elapsedTime) {
+
+  const float timeDelta = elapsedTime - flock.currentTime;
+  flock.currentTime = elapsedTime;
+
+  if (flockSize(flock) == 0 || timeDelta <= 0.0f)
+    return;
+
+  sortFlockByCells(flock);
+
+  // all birds steer from the same old state, the new velocities are swapped in afterwards
+  parallelFor(flockSize(flock), FLOCK_CHUNK_SIZE, [&](size_t begin, size_t end) {
+    steerFlockRange(flock, begin, end, timeDelta);
+  });
+
+  flock.velocityX.swap(flock.steeredX);
+  flock.velocityY.swap(flock.steeredY);
+  flock.velocityZ.swap(flock.steeredZ);
+
+  parallelFor(flockSize(flock), SIMULATION_CHUNK_SIZE, [&](size_t begin, size_t end) {
+    moveFlockRange(flock, begin, end, timeDelta);
+  });
+}
+
+void getFlockSparrow(const Flock& flock, size_t index, SparrowObject& sparrow) {
+  const glm::vec3 velocity(flock.velocityX[index], flock.velocityY[index], flock.velocityZ[index]);
+  const float speed = glm::length(velocity);
+
+  sparrow.position = glm::vec3(flock.positionX[index], flock.positionY[index], flock.positionZ[index]);
+  sparrow.direction = speed > 0.0f ? velocity / speed : glm::vec3(1.0f, 0.0f, 0.0f);
+  sparrow.speed = speed;
+  sparrow.size = SPARROW_SIZE;
+  sparrow.destroyed = false;
+  sparrow.startTime = 0.0f;
+  sparrow.currentTime = flock.currentTime;
+  sparrow.rotationSpeed = 0.0f;
+
+  // drawSparrow() turns the model by 180 - currentAngle around z
+  sparrow.currentAngle = -glm::degrees(std::atan2(velocity.y, velocity.x));
+}
+
+// END OF FLOCK FUNCTIONS
+// ----------------------------------------------------------------------------------------
@@ -0,0 +1,75 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    flock.h
+ * \author  Sean Phay
+ * \date    2023
+ * \brief   Flock of sparrows steered by separation, alignment and cohesion (boids).
+ */
+//----------------------------------------------------------------------------------------
+
+#ifndef __FLOCK_H
+#define __FLOCK_H
+
+#include <vector>
+#include "entities.h"
+#include "objects.h"
+
+// birds summed at once by the neighbour search - one AVX register of floats
+const size_t FLOCK_LANES = 8;
+
+//**************************************************************************************************
+/// Birds stored component by component, sorted by the cells of a uniform grid.
+/**
+ The grid covers the scene in x and y with cells as large as the neighbour radius, so the
+ neighbours of a bird are in its own cell and the 8 around it. Every update sorts the birds
+ by their cells (counting sort), the birds of one cell are then contiguous in the arrays and
+ the neighbour search reads them in order. The birds have no identity, only their number stays.
+ The arrays have FLOCK_LANES unused entries at the end, the search reads whole registers.
+*/
+typedef struct _Flock {
+  FloatArray positionX, positionY, positionZ;
+  FloatArray velocityX, velocityY, velocityZ;
+  FloatArray steeredX, steeredY, steeredZ;   // velocities of the next step, written by the steering pass
+  size_t     count;                          // number of the birds, the arrays are longer by FLOCK_LANES
+  float      currentTime;
+
+  int   gridSize;                            // cells along each side of the grid
+  float gridOrigin;                          // lower x and y of the grid
+  float invCellSize;
+  std::vector<unsigned int> birdCell;        // cell of every bird, before sorting
+  std::vector<unsigned int> cellStart;       // first bird of every cell, gridSize^2 + 1 entries
+  std::vector<unsigned int> order;           // birds in the cell order, scratch of the sorting
+  FloatArray scratch;                        // scratch of the sorting
+} Flock;
+
+/// Number of the birds.
+inline size_t flockSize(const Flock& flock) { return flock.count; }
+
+//**************************************************************************************************
+/// Places the birds at random positions above the scene flying in random directions.
+/**
+ Uses decorationRandom(), a flock created after seedSimulationRandom() is the same in every run.
+
+ \param[out] flock        Flock to be created (the previous birds are removed).
+ \param[in]  count        Number of the birds.
+ \param[in]  elapsedTime  Current simulation time (seconds).
+*/
+void initializeFlock(Flock& flock, size_t count, float elapsedTime);
+
+//**************************************************************************************************
+/// Steers and moves the birds.
+/**
+ The grid is rebuilt, then every bird sums its neighbours within FLOCK_NEIGHBOUR_RADIUS
+ (separation from the close ones, their mean velocity and their centre), the birds are steered
+ in parallel chunks on all cores and moved by their new velocities. The birds are kept within
+ FLOCK_AREA horizontally and between FLOCK_HEIGHT_MIN and FLOCK_HEIGHT_MAX.
+
+ \param[in,out] flock        Flock of the birds.
+ \param[in]     elapsedTime  Current simulation time (seconds).
+*/
+void updateFlock(Flock& flock, float elapsedTime);
+
+/// Copies the bird at an index into a sparrow object (position, direction, heading for the drawing).
+void getFlockSparrow(const Flock& flock, size_t index, SparrowObject& sparrow);
+
+#endif // __FLOCK_H
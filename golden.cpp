@@ -0,0 +1,140 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    golden.cpp
+ * \author  Sean Phay
+ * \date    2023
+ * \brief   Comparison of the rendered images with the stored reference (golden) images.
+ */
+//----------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include "golden.h"
+
+// largest possible YIQ difference (black against white) - normalizes the threshold
+const float YIQ_MAX_DELTA = 35215.0f;
+
+// ----------------------------------------------------------------------------------------
+// START OF IMAGE FILE FUNCTIONS
+
+// skips white space and comments of the PPM header
+void skipHeaderSpace(std::istream& in) {
+  while (in) {
+    int c = in.peek();
+    if (c == '#') {
+      std::string comment;
+      std::getline(in, comment);
+    }
+    else if (c == ' ' || c == '\t' || c == '\n' || c == '\r')
+      in.get();
+    else
+      break;
+  }
+}
+
+bool loadImage(const std::string& fileName, Image& image) {
+  std::ifstream in(fileName.c_str(), std::ios::binary);
+  if (!in)
+    return false;
+
+  std::string magic;
+  int maxValue = 0;
+  in >> magic;
+  skipHeaderSpace(in);
+  in >> image.width;
+  skipHeaderSpace(in);
+  in >> image.height;
+  skipHeaderSpace(in);
+  in >> maxValue;
+  in.get(); // single white space before the data
+
+  if (!in || magic != "P6" || maxValue != 255 || image.width <= 0 || image.height <= 0) {
+    std::cerr << "loadImage(): \"" << fileName << "\" is not a binary 8-bit PPM." << std::endl;
+    return false;
+  }
+
+  image.pixels.resize(3 * size_t(image.width) * image.height);
+  if (!in.read((char*)image.pixels.data(), image.pixels.size())) {
+    std::cerr << "loadImage(): \"" << fileName << "\" is truncated." << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool saveImage(const std::string& fileName, const Image& image) {
+  std::ofstream out(fileName.c_str(), std::ios::binary);
+  if (!out) {
+    std::cerr << "saveImage(): Cannot create file \"" << fileName << "\"." << std::endl;
+    return false;
+  }
+
+  out << "P6\n" << image.width << " " << image.height << "\n255\n";
+  out.write((const char*)image.pixels.data(), image.pixels.size());
+  return bool(out);
+}
+
+// END OF IMAGE FILE FUNCTIONS
+// ----------------------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------------------
+// START OF COMPARISON FUNCTIONS
+
+float rgbToY(float r, float g, float b) { return 0.29889531f * r + 0.58662247f * g + 0.11448223f * b; }
+float rgbToI(float r, float g, float b) { return 0.59597799f * r - 0.27417610f * g - 0.32180189f * b; }
+float rgbToQ(float r, float g, float b) { return 0.21147017f * r - 0.52261711f * g + 0.31114694f * b; }
+
+// squared YIQ distance of two pixels, 0 ... YIQ_MAX_DELTA
+float colorDelta(const unsigned char* a, const unsigned char* b) {
+  float y = rgbToY(a[0], a[1], a[2]) - rgbToY(b[0], b[1], b[2]);
+  float i = rgbToI(a[0], a[1], a[2]) - rgbToI(b[0], b[1], b[2]);
+  float q = rgbToQ(a[0], a[1], a[2]) - rgbToQ(b[0], b[1], b[2]);
+  return 0.5053f * y * y + 0.299f * i * i + 0.1957f * q * q;
+}
+
+bool compareImages(const Image& reference, const Image& image, float threshold, ImageDifference& difference, Image* diffImage) {
+  difference.differentPixels = 0;
+  difference.maxDelta = 0.0f;
+
+  if (reference.width != image.width || reference.height != image.height)
+    return false;
+
+  // threshold is given for the distance, the delta is squared
+  const float maxDelta = YIQ_MAX_DELTA * threshold * threshold;
+  const size_t pixelCount = size_t(image.width) * image.height;
+
+  if (diffImage != NULL) {
+    diffImage->width = image.width;
+    diffImage->height = image.height;
+    diffImage->pixels.resize(3 * pixelCount);
+  }
+
+  for (size_t p = 0; p < pixelCount; p++) {
+    const unsigned char* a = &reference.pixels[3 * p];
+    const unsigned char* b = &image.pixels[3 * p];
+    float delta = colorDelta(a, b);
+
+    difference.maxDelta = std::max(difference.maxDelta, delta);
+    if (delta > maxDelta)
+      difference.differentPixels++;
+
+    if (diffImage != NULL) {
+      unsigned char* d = &diffImage->pixels[3 * p];
+      if (delta > maxDelta) {
+        d[0] = 255; d[1] = 0; d[2] = 0;
+      }
+      else {
+        // faded reference keeps the context of the differences
+        unsigned char gray = (unsigned char)(160 + rgbToY(a[0], a[1], a[2]) * 0.375f);
+        d[0] = d[1] = d[2] = gray;
+      }
+    }
+  }
+
+  difference.maxDelta = std::sqrt(difference.maxDelta / YIQ_MAX_DELTA);
+  return true;
+}
+
+// END OF COMPARISON FUNCTIONS
+// ----------------------------------------------------------------------------------------
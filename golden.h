@@ -0,0 +1,52 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    golden.h
+ * \author  Sean Phay
+ * \date    2023
+ * \brief   Comparison of the rendered images with the stored reference (golden) images.
+ */
+//----------------------------------------------------------------------------------------
+
+#ifndef __GOLDEN_H
+#define __GOLDEN_H
+
+#include <string>
+#include <vector>
+
+// RGB image, 3 bytes per pixel, rows from the top
+typedef struct _Image {
+  int                        width;
+  int                        height;
+  std::vector<unsigned char> pixels;
+} Image;
+
+// result of the comparison of two images
+typedef struct _ImageDifference {
+  size_t differentPixels;  // pixels over the threshold
+  float  maxDelta;         // largest perceived difference, 0.0f ... 1.0f
+} ImageDifference;
+
+/// Loads a binary PPM (P6) image.
+bool loadImage(const std::string& fileName, Image& image);
+
+/// Stores an image as binary PPM (P6).
+bool saveImage(const std::string& fileName, const Image& image);
+
+//**************************************************************************************************
+/// Compares two images pixel by pixel with a perceptual metric.
+/**
+ The difference of two pixels is measured in the YIQ color space with the weights of
+ "Measuring perceived color difference using YIQ NTSC transmission color space" (Kotsarenko,
+ Ramos), the same metric as used by pixelmatch. Small changes of the rasterization (another
+ llvmpipe version, a different order of the draw calls) stay under the threshold.
+
+ \param[in]  reference   Stored image.
+ \param[in]  image       Rendered image.
+ \param[in]  threshold   Largest tolerated difference of one pixel, 0.0f ... 1.0f (0.1f is a good start).
+ \param[out] difference  Number of the different pixels and the largest difference.
+ \param[out] diffImage   If not NULL, gets the reference in gray with the different pixels in red.
+ \return                 False if the images have a different size.
+*/
+bool compareImages(const Image& reference, const Image& image, float threshold, ImageDifference& difference, Image* diffImage = NULL);
+
+#endif // __GOLDEN_H
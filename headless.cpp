@@ -0,0 +1,213 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    headless.cpp
+ * \author  Sean Phay
+ * \date    2023
+ * \brief   Simulation of the scene without a window and OpenGL (profiling of the CPU side).
+ */
+//----------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "collision.h"
+#include "data.h"
+#include "entities.h"
+#include "heightfield.h"
+#include "jobs.h"
+#include "replay.h"
+#include "scatter.h"
+#include "simulation.h"
+#include "spline.h"
+
+// the same file as TERRAIN_MODEL_NAME of the application
+const char* HEADLESS_TERRAIN_MODEL_NAME = "data/terrain/terrain.obj";
+
+// distance walked by the penguin along the animation curve per second
+const float HEADLESS_PENGUIN_SPEED = 0.09f;
+
+// parameters of the run, set from the command line
+typedef struct _HeadlessOptions {
+  unsigned int ticks;              // number of simulation steps
+  unsigned int seed;               // seed of the simulation random generator
+  unsigned int missilesPerLaunch;  // missiles fired at once by the penguin
+  unsigned int threads;            // threads of the update, 0 = one per core
+} HeadlessOptions;
+
+// ----------------------------------------------------------------------------------------
+// START OF HELPER FUNCTIONS
+
+bool parseOptions(int argc, char** argv, HeadlessOptions& options) {
+  options.ticks = 3000;
+  options.seed = SCATTER_SEED;
+  options.missilesPerLaunch = 16;
+  options.threads = 0;
+
+  for (int i = 1; i < argc; i++) {
+    std::string option = argv[i];
+
+    if (i + 1 < argc && option == "--ticks")
+      options.ticks = (unsigned int)std::strtoul(argv[++i], NULL, 10);
+    else if (i + 1 < argc && option == "--seed")
+      options.seed = (unsigned int)std::strtoul(argv[++i], NULL, 10);
+    else if (i + 1 < argc && option == "--missiles")
+      options.missilesPerLaunch = (unsigned int)std::strtoul(argv[++i], NULL, 10);
+    else if (i + 1 < argc && option == "--threads")
+      options.threads = (unsigned int)std::strtoul(argv[++i], NULL, 10);
+    else {
+      std::cerr << "usage: " << argv[0] << " [--ticks N] [--seed S] [--missiles M] [--threads T]" << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+// scenery generated the same way as generateScenery() of the application, objects only collide here
+void generateTargets(unsigned int seed, EntityStore& targets) {
+  const ScatterLayer layers[] = {
+    { SCATTER_PALM_TREE, PALM_TREE_MIN_DISTANCE, PALM_TREE_EXCLUSION, PALM_TREE_DENSITY },
+    { SCATTER_STONE,     STONE_MIN_DISTANCE,     STONE_EXCLUSION,     STONE_DENSITY },
+    { SCATTER_ROCK,      ROCK_MIN_DISTANCE,      ROCK_EXCLUSION,      ROCK_DENSITY },
+    { SCATTER_FERN,      FERN_MIN_DISTANCE,      FERN_EXCLUSION,      FERN_DENSITY },
+  };
+  const float baseHeight[SCATTER_TYPES_COUNT] = { PALM_TREE_BASE_HEIGHT, FERN_BASE_HEIGHT, STONE_BASE_HEIGHT, ROCK_BASE_HEIGHT };
+  const float size[SCATTER_TYPES_COUNT] = { PALM_TREE_SIZE, FERN_SIZE, ROCK_SIZE, ROCK_SIZE };
+
+  std::vector<ScatterPoint> points = scatterScenery(
+    layers, sizeof(layers) / sizeof(layers[0]),
+    glm::vec2(-SCATTER_AREA), glm::vec2(SCATTER_AREA),
+    std::vector<glm::vec3>(), seed
+  );
+
+  Object target = Object();
+  for (size_t i = 0; i < points.size(); i++) {
+    const glm::vec2& position = points[i].position;
+    target.position = glm::vec3(position, getTerrainHeight(position.x, position.y) + baseHeight[points[i].type]);
+    target.size = 0.5f * size[points[i].type];
+    createEntity(targets, target);
+  }
+}
+
+ExplosionObject* createExplosion(const glm::vec3& position, float time) {
+  ExplosionObject* explosion = new ExplosionObject;
+  explosion->position = position;
+  explosion->direction = glm::vec3(0.0f, 0.0f, 1.0f);
+  explosion->speed = 0.0f;
+  explosion->size = BILLBOARD_SIZE;
+  explosion->destroyed = false;
+  explosion->startTime = time;
+  explosion->currentTime = time;
+  explosion->frameDuration = 0.1f;
+  explosion->textureFrames = 16;
+  return explosion;
+}
+
+// deletes the objects through their own type - Object has no virtual destructor
+template <typename ObjectType>
+void deleteObjects(GameObjectsList& objects) {
+  for (GameObjectsList::iterator it = objects.begin(); it != objects.end(); ++it)
+    delete (ObjectType*)(*it);
+  objects.clear();
+}
+
+// END OF HELPER FUNCTIONS
+// ----------------------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+
+  HeadlessOptions options;
+  if (parseOptions(argc, argv, options) != true)
+    return 1;
+
+  seedSimulationRandom(options.seed);
+  initializeJobSystem(options.threads);
+
+  // without the terrain the objects stand on the plane z = 0
+  if (initializeHeightfield(HEADLESS_TERRAIN_MODEL_NAME, TERRAIN_SIZE, HEIGHTFIELD_RESOLUTION) != true)
+    std::cerr << "main(): Terrain heightfield baking failed, using flat ground." << std::endl;
+
+  EntityStore targets;
+  generateTargets(options.seed, targets);
+
+  SplinePath penguinPath;
+  buildSplinePath(penguinPath, curveData, curveSize);
+
+  EntityStore missiles;
+  GameObjectsList explosions;
+  float missileLaunchTime = -MISSILE_LAUNCH_TIME_DELAY;
+  size_t hits = 0;
+  std::vector<glm::vec3> hitPositions;
+
+  std::vector<double> tickTimes(options.ticks);
+
+  for (unsigned int tick = 1; tick <= options.ticks; tick++) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    const float elapsedTime = tick * SIMULATION_TIMESTEP;
+
+    // the penguin walks along the animation curve at a constant speed and fires a fan of missiles
+    float walkedDistance = HEADLESS_PENGUIN_SPEED * elapsedTime;
+    glm::vec3 penguinPosition = evaluateSplinePath(penguinPath, walkedDistance);
+    glm::vec3 penguinDirection = evaluateSplinePathTangent(penguinPath, walkedDistance);
+    penguinPosition.z = getTerrainHeight(penguinPosition.x, penguinPosition.y) + PENGUIN_HEIGHT_MIN + 0.1f;
+
+    if (elapsedTime - missileLaunchTime >= MISSILE_LAUNCH_TIME_DELAY) {
+      missileLaunchTime = elapsedTime;
+
+      for (unsigned int m = 0; m < options.missilesPerLaunch; m++) {
+        float angle = 0.5f * (2.0f * simulationRandom() - 1.0f);
+        MissileObject missile;
+        missile.direction = glm::vec3(
+          penguinDirection.x * cos(angle) - penguinDirection.y * sin(angle),
+          penguinDirection.x * sin(angle) + penguinDirection.y * cos(angle),
+          0.0f
+        );
+        missile.position = penguinPosition + 1.5f * MISSILE_SIZE * missile.direction;
+        missile.speed = MISSILE_SPEED;
+        missile.size = MISSILE_SIZE;
+        missile.destroyed = false;
+        missile.startTime = elapsedTime;
+        missile.currentTime = elapsedTime;
+        createEntity(missiles, missile);
+      }
+    }
+
+    updateMissileEntities(missiles, elapsedTime);
+    updateExplosionsParallel(explosions, elapsedTime);
+
+    // missiles hitting the scenery explode - the hits come in the order of the missiles on any thread count
+    collideEntities(missiles, targets, hitPositions);
+    for (size_t h = 0; h < hitPositions.size(); h++)
+      explosions.push_back(createExplosion(hitPositions[h], elapsedTime));
+    hits += hitPositions.size();
+
+    tickTimes[tick - 1] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  // summary of the tick times
+  std::vector<double> sorted = tickTimes;
+  std::sort(sorted.begin(), sorted.end());
+  double total = 0.0;
+  for (size_t i = 0; i < sorted.size(); i++)
+    total += sorted[i];
+
+  if (!sorted.empty()) {
+    std::cout << "threads: " << getJobThreadCount() << ", ticks: " << options.ticks << ", scenery objects: " << entityCount(targets) << ", hits: " << hits << std::endl;
+    std::cout << "tick time [ms]: mean " << total / sorted.size()
+              << ", median " << sorted[sorted.size() / 2]
+              << ", p99 " << sorted[std::min(sorted.size() - 1, sorted.size() * 99 / 100)]
+              << ", max " << sorted.back() << std::endl;
+  }
+
+  if (getOutOfBoundsCount() > 0)
+    std::cout << "positions outside of the scene after the wrapping: " << getOutOfBoundsCount() << std::endl;
+
+  deleteObjects<ExplosionObject>(explosions);
+  cleanupHeightfield();
+  cleanupJobSystem();
+
+  return 0;
+}
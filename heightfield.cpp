@@ -0,0 +1,181 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    heightfield.cpp
+ * \author  Sean Phay
+ * \date    2023
+ * \brief   Terrain heights baked into a regular grid.
+ */
+//----------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <iostream>
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+#include "heightfield.h"
+
+// heightfield of the terrain used by the game
+Heightfield terrainHeightfield;
+
+// ----------------------------------------------------------------------------------------
+// START OF BAKING FUNCTIONS
+
+bool bakeHeightfield(const std::vector<glm::vec3>& triangles, int resolution, Heightfield& heightfield) {
+
+  if (triangles.size() < 3 || resolution < 2)
+    return false;
+
+  glm::vec3 boundsMin(FLT_MAX);
+  glm::vec3 boundsMax(-FLT_MAX);
+  for (size_t i = 0; i < triangles.size(); i++) {
+    boundsMin = glm::min(boundsMin, triangles[i]);
+    boundsMax = glm::max(boundsMax, triangles[i]);
+  }
+
+  heightfield.origin = glm::vec2(boundsMin);
+  heightfield.extent = glm::max(glm::vec2(boundsMax) - glm::vec2(boundsMin), glm::vec2(1e-6f));
+  heightfield.cols = resolution;
+  heightfield.rows = resolution;
+  heightfield.heights.assign(resolution * resolution, -FLT_MAX);
+
+  const glm::vec2 cellSize = heightfield.extent / float(resolution - 1);
+
+  // rasterize the triangles projected to the xy plane, the highest surface wins
+  for (size_t t = 0; t + 2 < triangles.size(); t += 3) {
+    const glm::vec3& a = triangles[t];
+    const glm::vec3& b = triangles[t + 1];
+    const glm::vec3& c = triangles[t + 2];
+
+    float area = (b.x - a.x) * (c.y - a.y) - (c.x - a.x) * (b.y - a.y);
+    if (std::fabs(area) < 1e-12f)
+      continue; // vertical or degenerated triangle
+
+    int x0 = std::max(0, int(std::ceil((std::min(a.x, std::min(b.x, c.x)) - heightfield.origin.x) / cellSize.x)));
+    int x1 = std::min(heightfield.cols - 1, int(std::floor((std::max(a.x, std::max(b.x, c.x)) - heightfield.origin.x) / cellSize.x)));
+    int y0 = std::max(0, int(std::ceil((std::min(a.y, std::min(b.y, c.y)) - heightfield.origin.y) / cellSize.y)));
+    int y1 = std::min(heightfield.rows - 1, int(std::floor((std::max(a.y, std::max(b.y, c.y)) - heightfield.origin.y) / cellSize.y)));
+
+    for (int y = y0; y <= y1; y++) {
+      for (int x = x0; x <= x1; x++) {
+        glm::vec2 p = heightfield.origin + glm::vec2(x * cellSize.x, y * cellSize.y);
+
+        // barycentric coordinates, small tolerance so that samples on shared edges are not lost
+        float wa = ((b.x - p.x) * (c.y - p.y) - (c.x - p.x) * (b.y - p.y)) / area;
+        float wb = ((c.x - p.x) * (a.y - p.y) - (a.x - p.x) * (c.y - p.y)) / area;
+        float wc = 1.0f - wa - wb;
+        if (wa < -1e-5f || wb < -1e-5f || wc < -1e-5f)
+          continue;
+
+        float& height = heightfield.heights[y * heightfield.cols + x];
+        height = std::max(height, wa * a.z + wb * b.z + wc * c.z);
+      }
+    }
+  }
+
+  // holes in the mesh
+  for (size_t i = 0; i < heightfield.heights.size(); i++) {
+    if (heightfield.heights[i] == -FLT_MAX)
+      heightfield.heights[i] = boundsMin.z;
+  }
+
+  return true;
+}
+
+bool initializeHeightfield(const std::string& fileName, float size, int resolution) {
+
+  Assimp::Importer importer;
+
+  // the same processing as in loadSingleMesh()
+  importer.SetPropertyInteger(AI_CONFIG_PP_PTV_NORMALIZE, 1);
+
+  const aiScene* scn = importer.ReadFile(fileName.c_str(), 0
+      | aiProcess_Triangulate
+      | aiProcess_PreTransformVertices
+      | aiProcess_GenSmoothNormals
+      | aiProcess_JoinIdenticalVertices);
+
+  if (scn == NULL) {
+    std::cerr << "assimp error: " << importer.GetErrorString() << std::endl;
+    return false;
+  }
+
+  return initializeHeightfield(scn, size, resolution);
+}
+
+bool initializeHeightfield(const aiScene* scene, float size, int resolution) {
+
+  std::vector<glm::vec3> triangles;
+  for (size_t i = 0; i < scene->mNumMeshes; i++) {
+    const aiMesh* mesh = scene->mMeshes[i];
+
+    for (unsigned int f = 0; f < mesh->mNumFaces; f++) {
+      for (int corner = 0; corner < 3; corner++) {
+        const aiVector3D& vertex = mesh->mVertices[mesh->mFaces[f].mIndices[corner]];
+        triangles.push_back(size * glm::vec3(vertex.x, vertex.y, vertex.z));
+      }
+    }
+  }
+
+  if (bakeHeightfield(triangles, resolution, terrainHeightfield) != true) {
+    std::cerr << "initializeHeightfield(): terrain has no triangles" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+void cleanupHeightfield() {
+  terrainHeightfield.heights.clear();
+  terrainHeightfield.cols = 0;
+  terrainHeightfield.rows = 0;
+}
+
+// END OF BAKING FUNCTIONS
+// ----------------------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------------------
+// START OF QUERY FUNCTIONS
+
+float getTerrainHeight(float x, float y) {
+
+  const Heightfield& heightfield = terrainHeightfield;
+  if (heightfield.heights.empty())
+    return 0.0f;
+
+  // the terrain is repeated (see terrain.h) => so is the heightfield
+  float u = (x - heightfield.origin.x) / heightfield.extent.x;
+  float v = (y - heightfield.origin.y) / heightfield.extent.y;
+  u = (u - std::floor(u)) * (heightfield.cols - 1);
+  v = (v - std::floor(v)) * (heightfield.rows - 1);
+
+  int x0 = std::min(int(u), heightfield.cols - 2);
+  int y0 = std::min(int(v), heightfield.rows - 2);
+  float fx = u - x0;
+  float fy = v - y0;
+
+  const float* row0 = &heightfield.heights[y0 * heightfield.cols + x0];
+  const float* row1 = row0 + heightfield.cols;
+
+  float bottom = row0[0] + fx * (row0[1] - row0[0]);
+  float top    = row1[0] + fx * (row1[1] - row1[0]);
+  return bottom + fy * (top - bottom);
+}
+
+glm::vec3 getTerrainNormal(float x, float y) {
+
+  const Heightfield& heightfield = terrainHeightfield;
+  if (heightfield.heights.empty())
+    return glm::vec3(0.0f, 0.0f, 1.0f);
+
+  float dx = heightfield.extent.x / (heightfield.cols - 1);
+  float dy = heightfield.extent.y / (heightfield.rows - 1);
+
+  float slopeX = (getTerrainHeight(x + dx, y) - getTerrainHeight(x - dx, y)) / (2.0f * dx);
+  float slopeY = (getTerrainHeight(x, y + dy) - getTerrainHeight(x, y - dy)) / (2.0f * dy);
+
+  return glm::normalize(glm::vec3(-slopeX, -slopeY, 1.0f));
+}
+
+// END OF QUERY FUNCTIONS
+// ----------------------------------------------------------------------------------------
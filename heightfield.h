@@ -0,0 +1,66 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    heightfield.h
+ * \author  Sean Phay
+ * \date    2023
+ * \brief   Terrain heights baked into a regular grid.
+ */
+//----------------------------------------------------------------------------------------
+
+#ifndef __HEIGHTFIELD_H
+#define __HEIGHTFIELD_H
+
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+struct aiScene;
+
+// heights of the terrain sampled in the vertices of a regular grid
+typedef struct _Heightfield {
+  glm::vec2          origin;     // lower left corner of the grid (world coordinates)
+  glm::vec2          extent;     // size of the grid, the terrain repeats with this period
+  int                cols;       // number of samples along x
+  int                rows;       // number of samples along y
+  std::vector<float> heights;    // cols x rows samples, row by row
+} Heightfield;
+
+//**************************************************************************************************
+/// Bakes a heightfield from a triangle soup.
+/**
+ Every sample gets the highest z of the triangles covering it, samples not covered by any
+ triangle get the lowest height of the mesh.
+
+ \param[in]  triangles   Vertices of the triangles, three per triangle (world coordinates).
+ \param[in]  resolution  Number of samples along each side of the grid.
+ \param[out] heightfield Baked heightfield.
+ \return                 False if there are no triangles.
+*/
+bool bakeHeightfield(const std::vector<glm::vec3>& triangles, int resolution, Heightfield& heightfield);
+
+//**************************************************************************************************
+/// Loads the terrain model and bakes the heightfield used by getTerrainHeight() and getTerrainNormal().
+/**
+ The model is processed the same way as by loadSingleMesh(), so the heights match the drawn terrain.
+ Does not need an OpenGL context.
+
+ \param[in]  fileName    Terrain model file.
+ \param[in]  size        Scale of the terrain (TERRAIN_SIZE).
+ \param[in]  resolution  Number of samples along each side of the grid (HEIGHTFIELD_RESOLUTION).
+ \return                 True if the heightfield was baked.
+*/
+bool initializeHeightfield(const std::string& fileName, float size, int resolution);
+
+/// Bakes the heightfield from a terrain model already loaded with the processing of loadSingleMesh().
+bool initializeHeightfield(const aiScene* scene, float size, int resolution);
+
+/// Height of the terrain at (x, y), bilinear interpolation of the four nearest samples.
+float getTerrainHeight(float x, float y);
+
+/// Unit normal of the terrain at (x, y) from central differences of the heights.
+glm::vec3 getTerrainNormal(float x, float y);
+
+/// Releases the baked heightfield.
+void cleanupHeightfield();
+
+#endif // __HEIGHTFIELD_H
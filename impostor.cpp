@@ -0,0 +1,338 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    impostor.cpp
+ * \author  Sean Phay
+ * \date    2023
+ * \brief   Impostors replacing the distant tree meshes.
+ */
+//----------------------------------------------------------------------------------------
+
+#include <iostream>
+#include "pgr.h"
+#include "impostor.h"
+#include "data.h"
+
+extern SCommonShaderProgram shaderProgram;
+
+// ----------------------------------------------------------------------------------------
+// START OF IMPOSTOR DATA
+
+struct ImpostorShaderProgram {
+  // identifier for the shader program
+  GLuint program;           // = 0;
+  // vertex attributes locations
+  GLint posLocation;        // = -1;
+  GLint texCoordLocation;   // = -1;
+  GLint meshFadeLocation;   // = -1;
+  // uniforms locations
+  GLint PVmatrixLocation;   // = -1;
+  GLint VmatrixLocation;    // = -1;
+  GLint texSamplerLocation; // = -1;
+  GLint fogOnLinearLoc;     // = -1;
+  GLint fogOnExpLoc;        // = -1;
+  GLint fogNearLoc;         // = -1;
+  GLint fogDensityLoc;      // = -1;
+} impostorShaderProgram;
+
+// quads of all impostors, refilled every frame
+MeshGeometry* impostorGeometry = NULL;
+
+// vertex of the impostor quad: position, texture coordinates and mesh fade
+const int IMPOSTOR_VERTEX_FLOATS = 6;
+
+float impostorDistance = IMPOSTOR_DISTANCE;
+float impostorFadeBand = IMPOSTOR_FADE_BAND;
+
+// fog of the drawn frame, see setImpostorFog()
+bool  impostorFogLinear = false;
+bool  impostorFogExp = false;
+float impostorFogNear = 0.0f;
+float impostorFogDensity = 0.0f;
+
+// END OF IMPOSTOR DATA
+// ----------------------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------------------
+// START OF IMPOSTOR FUNCTIONS
+
+void initializeImpostors() {
+
+  std::vector<GLuint> shaderList;
+
+  // push vertex shader and fragment shader
+  shaderList.push_back(pgr::createShaderFromFile(GL_VERTEX_SHADER, "impostor.vert"));
+  shaderList.push_back(createShaderWithCommonFile(GL_FRAGMENT_SHADER, "fade_fog.frag", "impostor.frag"));
+
+  // create the program with two shaders
+  impostorShaderProgram.program = pgr::createProgram(shaderList);
+
+  // get vertex attributes locations
+  impostorShaderProgram.posLocation      = glGetAttribLocation(impostorShaderProgram.program, "position");
+  impostorShaderProgram.texCoordLocation = glGetAttribLocation(impostorShaderProgram.program, "texCoord");
+  impostorShaderProgram.meshFadeLocation = glGetAttribLocation(impostorShaderProgram.program, "meshFade");
+  // get uniforms locations
+  impostorShaderProgram.PVmatrixLocation   = glGetUniformLocation(impostorShaderProgram.program, "PVmatrix");
+  impostorShaderProgram.VmatrixLocation    = glGetUniformLocation(impostorShaderProgram.program, "Vmatrix");
+  impostorShaderProgram.texSamplerLocation = glGetUniformLocation(impostorShaderProgram.program, "texSampler");
+  impostorShaderProgram.fogOnLinearLoc     = glGetUniformLocation(impostorShaderProgram.program, "fogOnLinearToggle");
+  impostorShaderProgram.fogOnExpLoc        = glGetUniformLocation(impostorShaderProgram.program, "fogOnExpToggle");
+  impostorShaderProgram.fogNearLoc         = glGetUniformLocation(impostorShaderProgram.program, "fogNearValue");
+  impostorShaderProgram.fogDensityLoc      = glGetUniformLocation(impostorShaderProgram.program, "fogDensityValue");
+
+  impostorGeometry = new MeshGeometry;
+  impostorGeometry->texture = 0;
+  impostorGeometry->elementBufferObject = 0;
+  impostorGeometry->numTriangles = 0;
+
+  glGenVertexArrays(1, &(impostorGeometry->vertexArrayObject));
+  glBindVertexArray(impostorGeometry->vertexArrayObject);
+
+  // data are uploaded by drawImpostors()
+  glGenBuffers(1, &(impostorGeometry->vertexBufferObject));
+  glBindBuffer(GL_ARRAY_BUFFER, impostorGeometry->vertexBufferObject);
+
+  glEnableVertexAttribArray(impostorShaderProgram.posLocation);
+  glVertexAttribPointer(impostorShaderProgram.posLocation, 3, GL_FLOAT, GL_FALSE, IMPOSTOR_VERTEX_FLOATS * sizeof(float), 0);
+
+  glEnableVertexAttribArray(impostorShaderProgram.texCoordLocation);
+  glVertexAttribPointer(impostorShaderProgram.texCoordLocation, 2, GL_FLOAT, GL_FALSE, IMPOSTOR_VERTEX_FLOATS * sizeof(float), (void*)(3 * sizeof(float)));
+
+  glEnableVertexAttribArray(impostorShaderProgram.meshFadeLocation);
+  glVertexAttribPointer(impostorShaderProgram.meshFadeLocation, 1, GL_FLOAT, GL_FALSE, IMPOSTOR_VERTEX_FLOATS * sizeof(float), (void*)(5 * sizeof(float)));
+
+  glBindVertexArray(0);
+  CHECK_GL_ERROR();
+}
+
+void cleanupImpostors() {
+
+  pgr::deleteProgramAndShaders(impostorShaderProgram.program);
+
+  if (impostorGeometry != NULL) {
+    glDeleteVertexArrays(1, &(impostorGeometry->vertexArrayObject));
+    glDeleteBuffers(1, &(impostorGeometry->vertexBufferObject));
+    delete impostorGeometry;
+    impostorGeometry = NULL;
+  }
+}
+
+bool bakeImpostorAtlas(const std::vector<MeshGeometry*>& geometry, const glm::mat4& alignMatrix, ImpostorAtlas& atlas) {
+
+  atlas.views = IMPOSTOR_VIEWS;
+  atlas.resolution = IMPOSTOR_RESOLUTION;
+
+  // remember the state changed by the baking
+  GLint previousFramebuffer;
+  GLint previousViewport[4];
+  GLfloat previousClearColor[4];
+  glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebuffer);
+  glGetIntegerv(GL_VIEWPORT, previousViewport);
+  glGetFloatv(GL_COLOR_CLEAR_VALUE, previousClearColor);
+
+  glGenTextures(1, &atlas.texture);
+  glBindTexture(GL_TEXTURE_2D, atlas.texture);
+  // the views around the model and the view from above
+  const int frames = atlas.views + 1;
+
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, frames * atlas.resolution, atlas.resolution, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  GLuint depthBuffer;
+  glGenRenderbuffers(1, &depthBuffer);
+  glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, frames * atlas.resolution, atlas.resolution);
+  glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+  GLuint framebuffer;
+  glGenFramebuffers(1, &framebuffer);
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, atlas.texture, 0);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+
+  bool complete = (glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+
+  if (complete) {
+    // empty parts of the views stay transparent
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    glUseProgram(shaderProgram.program);
+
+    // sun straight above the model (time = 0), reflector below the ground pointing down => no spot light
+    glUniform1f(shaderProgram.timeLocation, 0.0f);
+    glUniform3f(shaderProgram.reflectorPositionLocation, 0.0f, 0.0f, -100.0f);
+    glUniform3f(shaderProgram.reflectorDirectionLocation, 0.0f, 0.0f, -1.0f);
+    glUniform1i(shaderProgram.pointLightLoc, 0);
+    glUniform1i(shaderProgram.fogOnLinearLoc, 0);
+    glUniform1i(shaderProgram.fogOnExpLoc, 0);
+    glUniform1f(shaderProgram.fadeLocation, 1.0f);
+    glUniform3f(shaderProgram.windLocation, 0.0f, 0.0f, 0.0f);
+
+    // the model fits into (-1..1)^3 (see loadSingleMesh)
+    const glm::mat4 projectionMatrix = glm::ortho(-1.0f, 1.0f, -1.0f, 1.0f, 0.1f, 6.0f);
+
+    for (int view = 0; view < frames; view++) {
+      float angle = 2.0f * float(M_PI) * view / atlas.views;
+      glm::mat4 viewMatrix = glm::lookAt(
+        3.0f * glm::vec3(cos(angle), sin(angle), 0.0f),
+        glm::vec3(0.0f, 0.0f, 0.0f),
+        glm::vec3(0.0f, 0.0f, 1.0f)
+      );
+
+      // the last view from above - x to the right, y up (see drawImpostors())
+      if (view == atlas.views)
+        viewMatrix = glm::lookAt(glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+      glViewport(view * atlas.resolution, 0, atlas.resolution, atlas.resolution);
+      setTransformUniforms(alignMatrix, viewMatrix, projectionMatrix);
+
+      for (size_t i = 0; i < geometry.size(); i++) {
+        setMaterialUniforms(
+          geometry[i]->ambient,
+          geometry[i]->diffuse,
+          geometry[i]->specular,
+          geometry[i]->shininess,
+          geometry[i]->texture
+        );
+
+        glBindVertexArray(geometry[i]->vertexArrayObject);
+        glDrawElements(GL_TRIANGLES, geometry[i]->numTriangles * 3, GL_UNSIGNED_INT, 0);
+      }
+    }
+    glBindVertexArray(0);
+    glUseProgram(0);
+  }
+  else {
+    std::cerr << "bakeImpostorAtlas(): framebuffer is not complete" << std::endl;
+  }
+
+  glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+  glViewport(previousViewport[0], previousViewport[1], previousViewport[2], previousViewport[3]);
+  glClearColor(previousClearColor[0], previousClearColor[1], previousClearColor[2], previousClearColor[3]);
+
+  glDeleteFramebuffers(1, &framebuffer);
+  glDeleteRenderbuffers(1, &depthBuffer);
+  CHECK_GL_ERROR();
+
+  if (complete == false) {
+    cleanupImpostorAtlas(atlas);
+    return false;
+  }
+  return true;
+}
+
+void cleanupImpostorAtlas(ImpostorAtlas& atlas) {
+  if (atlas.texture != 0)
+    glDeleteTextures(1, &atlas.texture);
+  atlas.texture = 0;
+}
+
+void setImpostorDistances(float distance, float fadeBand) {
+  impostorDistance = distance;
+  impostorFadeBand = std::max(fadeBand, 0.0f);
+}
+
+void setImpostorFog(bool linear, bool exponential, float nearValue, float density) {
+  impostorFogLinear = linear;
+  impostorFogExp = exponential;
+  impostorFogNear = nearValue;
+  impostorFogDensity = density;
+}
+
+float getImpostorMeshFade(const glm::vec3& position, const glm::vec3& cameraPosition) {
+
+  float distance = glm::distance(position, cameraPosition);
+
+  if (impostorFadeBand <= 0.0f)
+    return (distance < impostorDistance) ? 1.0f : 0.0f;
+
+  // linear cross-fade over the band centred at the switch distance
+  float t = (distance - (impostorDistance - 0.5f * impostorFadeBand)) / impostorFadeBand;
+  return 1.0f - glm::clamp(t, 0.0f, 1.0f);
+}
+
+void drawImpostors(const ImpostorAtlas& atlas, const std::vector<ImpostorInstance>& instances, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix) {
+
+  if (instances.empty() || atlas.texture == 0 || impostorGeometry == NULL)
+    return;
+
+  glm::vec3 cameraPosition = glm::vec3(glm::inverse(viewMatrix)[3]);
+
+  const float corners[6][2] = { { -1, -1 }, { 1, -1 }, { 1, 1 }, { -1, -1 }, { 1, 1 }, { -1, 1 } };
+  const float viewWidth = 1.0f / (atlas.views + 1);
+  const float topSine = sin(glm::radians(IMPOSTOR_TOP_ELEVATION));
+
+  std::vector<float> vertices;
+  vertices.reserve(instances.size() * 6 * IMPOSTOR_VERTEX_FLOATS);
+
+  for (size_t i = 0; i < instances.size(); i++) {
+    const ImpostorInstance& instance = instances[i];
+    glm::vec3 toCamera = cameraPosition - instance.position;
+    float distance = glm::length(toCamera);
+
+    int view;
+    glm::vec3 right;
+    glm::vec3 up;
+
+    if (distance > 0.0f && toCamera.z > topSine * distance) {
+      // seen from above - the quad lies flat, axes of the view from above
+      view = atlas.views;
+      right = glm::vec3(1.0f, 0.0f, 0.0f);
+      up = glm::vec3(0.0f, 1.0f, 0.0f);
+    }
+    else {
+      // view of the atlas taken from the direction closest to the camera,
+      // the quad turns around the vertical axis only
+      float angle = atan2(toCamera.y, toCamera.x);
+      view = int(floor(angle / (2.0f * float(M_PI)) * atlas.views + 0.5f));
+      view = ((view % atlas.views) + atlas.views) % atlas.views;
+
+      right = glm::vec3(-sin(angle), cos(angle), 0.0f);
+      up = glm::vec3(0.0f, 0.0f, 1.0f);
+    }
+
+    for (int c = 0; c < 6; c++) {
+      glm::vec3 corner = instance.position + instance.size * (corners[c][0] * right + corners[c][1] * up);
+      vertices.push_back(corner.x);
+      vertices.push_back(corner.y);
+      vertices.push_back(corner.z);
+      vertices.push_back((view + 0.5f * (corners[c][0] + 1.0f)) * viewWidth);
+      vertices.push_back(0.5f * (corners[c][1] + 1.0f));
+      vertices.push_back(instance.meshFade);
+    }
+  }
+
+  glUseProgram(impostorShaderProgram.program);
+
+  glm::mat4 PVmatrix = projectionMatrix * viewMatrix;
+  glUniformMatrix4fv(impostorShaderProgram.PVmatrixLocation, 1, GL_FALSE, glm::value_ptr(PVmatrix));
+  glUniformMatrix4fv(impostorShaderProgram.VmatrixLocation, 1, GL_FALSE, glm::value_ptr(viewMatrix));
+  glUniform1i(impostorShaderProgram.texSamplerLocation, 0);
+
+  glUniform1i(impostorShaderProgram.fogOnLinearLoc, impostorFogLinear);
+  glUniform1i(impostorShaderProgram.fogOnExpLoc, impostorFogExp);
+  glUniform1f(impostorShaderProgram.fogNearLoc, impostorFogNear);
+  glUniform1f(impostorShaderProgram.fogDensityLoc, impostorFogDensity);
+
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, atlas.texture);
+
+  // orphan the old buffer so the driver does not wait for the previous frame
+  glBindBuffer(GL_ARRAY_BUFFER, impostorGeometry->vertexBufferObject);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(float) * vertices.size(), NULL, GL_STREAM_DRAW);
+  glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(float) * vertices.size(), &vertices[0]);
+
+  glBindVertexArray(impostorGeometry->vertexArrayObject);
+  glDrawArrays(GL_TRIANGLES, 0, GLsizei(vertices.size() / IMPOSTOR_VERTEX_FLOATS));
+
+  glBindVertexArray(0);
+  glUseProgram(0);
+  CHECK_GL_ERROR();
+}
+
+// END OF IMPOSTOR FUNCTIONS
+// ----------------------------------------------------------------------------------------
@@ -0,0 +1,29 @@
+#version 140
+
+uniform sampler2D texSampler; // impostor atlas
+
+smooth in vec2 texCoord_v;    // fragment texture coordinates
+flat in float meshFade_v;     // visibility of the mesh drawn at the same place
+smooth in vec3 positionOut;   // position in eye coordinates
+
+out vec4 color_f;             // outgoing fragment color
+
+// the fog uniforms, meshKeepsPixel() and applyFog() come from fade_fog.frag, shared with lighting.frag
+
+void main() {
+
+  color_f = texture(texSampler, texCoord_v);
+
+  // alpha tested => the impostors write depth and need no sorting
+  if (color_f.a < 0.5)
+    discard;
+
+  // cross-fade: keep exactly the pixels dropped by the mesh
+  if (meshKeepsPixel(meshFade_v))
+    discard;
+
+  color_f.a = 1.0;
+
+  // the same fog as the meshes => no change of the colour at the switch distance
+  color_f = applyFog(color_f, -positionOut.z);
+}
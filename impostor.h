@@ -0,0 +1,83 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    impostor.h
+ * \author  Sean Phay
+ * \date    2023
+ * \brief   Impostors replacing the distant tree meshes.
+ */
+//----------------------------------------------------------------------------------------
+
+#ifndef __IMPOSTOR_H
+#define __IMPOSTOR_H
+
+#include <vector>
+#include "render.h"
+
+// pictures of one model taken from IMPOSTOR_VIEWS directions around the vertical axis and from above
+typedef struct _ImpostorAtlas {
+  GLuint texture;      // all views next to each other in one row, the view from above is the last one
+  int    views;        // number of the views around the vertical axis
+  int    resolution;   // width and height of one view in pixels
+} ImpostorAtlas;
+
+// one impostor to be drawn
+typedef struct _ImpostorInstance {
+  glm::vec3 position;  // centre of the model
+  float     size;      // scale of the model (the model fits into -size ... size)
+  float     meshFade;  // visibility of the mesh drawn at the same place, see getImpostorMeshFade()
+} ImpostorInstance;
+
+/// Compiles the impostor shaders and creates the buffer for the impostor quads.
+void initializeImpostors();
+
+/// Releases the impostor shaders and buffers.
+void cleanupImpostors();
+
+//**************************************************************************************************
+/// Renders a model from IMPOSTOR_VIEWS directions around the vertical axis and from above into a texture.
+/**
+ The model is drawn by the common lighting shader with the sun straight above the model,
+ the views are taken by an orthographic camera looking at the model from the horizontal plane,
+ the last one by a camera looking down with x to the right and y up.
+
+ \param[in]  geometry    Meshes of the model.
+ \param[in]  alignMatrix Rotation of the model used by its draw function (without translation and scale).
+ \param[out] atlas       Created atlas.
+ \return                 True if the atlas was created.
+*/
+bool bakeImpostorAtlas(const std::vector<MeshGeometry*>& geometry, const glm::mat4& alignMatrix, ImpostorAtlas& atlas);
+
+/// Releases the texture of the atlas.
+void cleanupImpostorAtlas(ImpostorAtlas& atlas);
+
+/// Sets the distance of the mesh/impostor switch and the width of the cross-fade band around it.
+void setImpostorDistances(float distance, float fadeBand);
+
+/// Sets the fog of the impostors, the same values as the fog uniforms of the lighting shader.
+void setImpostorFog(bool linear, bool exponential, float nearValue, float density);
+
+//**************************************************************************************************
+/// Visibility of the mesh of an object at a given distance from the camera.
+/**
+ \param[in]  position        Position of the object.
+ \param[in]  cameraPosition  Position of the camera.
+ \return                     1.0f - mesh only, 0.0f - impostor only, values between => both are drawn dithered.
+*/
+float getImpostorMeshFade(const glm::vec3& position, const glm::vec3& cameraPosition);
+
+//**************************************************************************************************
+/// Draws all given impostors by one draw call.
+/**
+ The quads turn around the vertical axis only (cylindrical billboards), so the trees stay upright,
+ each quad shows the view of the atlas taken from the direction closest to the direction towards
+ the camera. Impostors seen from above IMPOSTOR_TOP_ELEVATION lie flat and show the view from above.
+ The fog set by setImpostorFog() is applied as on the meshes.
+
+ \param[in]  atlas            Atlas of the model.
+ \param[in]  instances        Impostors to be drawn.
+ \param[in]  viewMatrix       View matrix of the camera.
+ \param[in]  projectionMatrix Projection matrix of the camera.
+*/
+void drawImpostors(const ImpostorAtlas& atlas, const std::vector<ImpostorInstance>& instances, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix);
+
+#endif // __IMPOSTOR_H
@@ -0,0 +1,23 @@
+#version 140
+
+uniform mat4 PVmatrix;      // Projection * View --> world to clip coordinates
+uniform mat4 Vmatrix;       // View --> world to eye coordinates, for the fog
+
+in vec3 position;           // corner of the camera facing quad in world space
+in vec2 texCoord;           // texture coordinates in the impostor atlas
+in float meshFade;          // visibility of the mesh drawn at the same place
+
+smooth out vec2 texCoord_v; // outgoing vertex texture coordinates
+flat out float meshFade_v;  // the same for the whole quad
+smooth out vec3 positionOut; // position in eye coordinates
+
+void main() {
+
+  // vertex position after the projection (gl_Position is predefined output variable)
+  gl_Position = PVmatrix * vec4(position, 1);
+
+  // outputs entering the fragment shader
+  texCoord_v = texCoord;
+  meshFade_v = meshFade;
+  positionOut = (Vmatrix * vec4(position, 1)).xyz;
+}
@@ -0,0 +1,189 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    jobs.cpp
+ * \author  Sean Phay
+ * \date    2023
+ * \brief   Small work-stealing job system for the parallel loops of the simulation.
+ */
+//----------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "jobs.h"
+
+// one chunk of a parallel loop
+typedef struct _Job {
+  const std::function<void(size_t, size_t)>* body;
+  size_t                                     begin;
+  size_t                                     end;
+  std::atomic<size_t>*                       remaining;  // chunks of the loop not finished yet
+} Job;
+
+// jobs owned by one thread, the owner works at the back, the thieves at the front
+typedef struct _JobQueue {
+  std::mutex      mutex;
+  std::deque<Job> jobs;
+} JobQueue;
+
+struct JobSystem {
+  unsigned int                           threadCount = 0;  // 0 = not started
+  std::vector<std::thread>               workers;
+  std::vector<std::unique_ptr<JobQueue>> queues;           // [0] belongs to the threads outside the pool
+
+  std::mutex              sleepMutex;
+  std::condition_variable wake;
+  size_t                  queuedJobs = 0;                  // guarded by sleepMutex
+  bool                    quit = false;
+
+  // worker threads must be joined before the exit
+  ~JobSystem() { cleanupJobSystem(); }
+} jobSystem;
+
+// queue of the current thread - the workers have 1 ... threadCount-1
+thread_local unsigned int jobQueueIndex = 0;
+
+// ----------------------------------------------------------------------------------------
+// START OF HELPER FUNCTIONS
+
+static bool popJob(unsigned int queueIndex, bool fromBack, Job& job) {
+  JobQueue& queue = *jobSystem.queues[queueIndex];
+  std::lock_guard<std::mutex> lock(queue.mutex);
+
+  if (queue.jobs.empty())
+    return false;
+
+  if (fromBack) {
+    job = queue.jobs.back();
+    queue.jobs.pop_back();
+  }
+  else {
+    job = queue.jobs.front();
+    queue.jobs.pop_front();
+  }
+  return true;
+}
+
+// runs one job of the own queue or one stolen from another thread
+static bool runOneJob(unsigned int self) {
+  Job job;
+  bool found = popJob(self, true, job);
+
+  for (unsigned int i = 1; found == false && i < jobSystem.threadCount; i++)
+    found = popJob((self + i) % jobSystem.threadCount, false, job);
+
+  if (found == false)
+    return false;
+
+  {
+    std::lock_guard<std::mutex> lock(jobSystem.sleepMutex);
+    jobSystem.queuedJobs--;
+  }
+
+  (*job.body)(job.begin, job.end);
+  job.remaining->fetch_sub(1, std::memory_order_release);
+  return true;
+}
+
+static void workerLoop(unsigned int index) {
+  jobQueueIndex = index;
+
+  for (;;) {
+    if (runOneJob(index))
+      continue;
+
+    std::unique_lock<std::mutex> lock(jobSystem.sleepMutex);
+    jobSystem.wake.wait(lock, []() { return jobSystem.quit || jobSystem.queuedJobs > 0; });
+    if (jobSystem.quit)
+      return;
+  }
+}
+
+// END OF HELPER FUNCTIONS
+// ----------------------------------------------------------------------------------------
+
+void initializeJobSystem(unsigned int threadCount) {
+  cleanupJobSystem();
+
+  if (threadCount == 0)
+    threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+  jobSystem.threadCount = threadCount;
+  jobSystem.quit = false;
+  jobSystem.queuedJobs = 0;
+
+  jobSystem.queues.clear();
+  for (unsigned int i = 0; i < threadCount; i++)
+    jobSystem.queues.push_back(std::unique_ptr<JobQueue>(new JobQueue));
+
+  for (unsigned int i = 1; i < threadCount; i++)
+    jobSystem.workers.push_back(std::thread(workerLoop, i));
+}
+
+unsigned int getJobThreadCount() {
+  return std::max(1u, jobSystem.threadCount);
+}
+
+void parallelFor(size_t count, size_t chunkSize, const std::function<void(size_t begin, size_t end)>& job) {
+  if (count == 0)
+    return;
+
+  if (jobSystem.threadCount == 0)
+    initializeJobSystem();
+
+  chunkSize = std::max(chunkSize, size_t(1));
+  const size_t chunkCount = (count + chunkSize - 1) / chunkSize;
+
+  if (jobSystem.threadCount <= 1 || chunkCount == 1) {
+    for (size_t begin = 0; begin < count; begin += chunkSize)
+      job(begin, std::min(begin + chunkSize, count));
+    return;
+  }
+
+  // chunks dealt round-robin, starting with the own queue - stealing evens out the rest
+  std::atomic<size_t> remaining(chunkCount);
+  const unsigned int self = jobQueueIndex;
+
+  for (size_t c = 0; c < chunkCount; c++) {
+    Job chunk;
+    chunk.body = &job;
+    chunk.begin = c * chunkSize;
+    chunk.end = std::min(chunk.begin + chunkSize, count);
+    chunk.remaining = &remaining;
+
+    JobQueue& queue = *jobSystem.queues[(self + c) % jobSystem.threadCount];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.jobs.push_back(chunk);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(jobSystem.sleepMutex);
+    jobSystem.queuedJobs += chunkCount;
+  }
+  jobSystem.wake.notify_all();
+
+  // the waiting thread helps - a nested loop in a job cannot deadlock
+  while (remaining.load(std::memory_order_acquire) > 0) {
+    if (runOneJob(self) == false)
+      std::this_thread::yield();
+  }
+}
+
+void cleanupJobSystem() {
+  {
+    std::lock_guard<std::mutex> lock(jobSystem.sleepMutex);
+    jobSystem.quit = true;
+  }
+  jobSystem.wake.notify_all();
+
+  for (size_t i = 0; i < jobSystem.workers.size(); i++)
+    jobSystem.workers[i].join();
+
+  jobSystem.workers.clear();
+  jobSystem.threadCount = 0;
+}
@@ -0,0 +1,47 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    jobs.h
+ * \author  Sean Phay
+ * \date    2023
+ * \brief   Small work-stealing job system for the parallel loops of the simulation.
+ */
+//----------------------------------------------------------------------------------------
+
+#ifndef __JOBS_H
+#define __JOBS_H
+
+#include <cstddef>
+#include <functional>
+
+//**************************************************************************************************
+/// Starts the worker threads.
+/**
+ Every thread owns a queue of jobs. It takes its own jobs from the back and, when the queue is
+ empty, steals from the front of the other queues, so the chunks of one loop end up balanced
+ between the cores. Called automatically by the first parallelFor(); calling it again restarts
+ the workers with another count.
+
+ \param[in]  threadCount  Threads including the calling one, 0 = one per core, 1 = no workers.
+*/
+void initializeJobSystem(unsigned int threadCount = 0);
+
+/// Number of threads running the jobs (the workers and the thread calling parallelFor()).
+unsigned int getJobThreadCount();
+
+//**************************************************************************************************
+/// Runs a loop over 0 ... count-1 in chunks on all threads and waits for it.
+/**
+ The range is split into chunks of chunkSize indices, job(begin, end) is called once per chunk
+ (chunk number = begin / chunkSize). The calling thread runs chunks as well while it waits.
+ A loop with one chunk runs directly on the calling thread.
+
+ \param[in]  count       Number of the indices.
+ \param[in]  chunkSize   Indices in one job.
+ \param[in]  job         Called for the half-open range begin ... end-1.
+*/
+void parallelFor(size_t count, size_t chunkSize, const std::function<void(size_t begin, size_t end)>& job);
+
+/// Stops and joins the worker threads.
+void cleanupJobSystem();
+
+#endif // __JOBS_H
@@ -17,37 +17,25 @@ smooth in vec4 color_v;        // incoming fragment color (includes lighting)
 smooth in vec2 texCoord_v;     // fragment texture coordinates
 out vec4       color_f;        // outgoing fragment color
 
+// the fog uniforms, meshKeepsPixel() and applyFog() come from fade_fog.frag, shared with impostor.frag
 
-uniform bool fogOnLinearToggle; //fog
-uniform bool fogOnExpToggle;
-uniform float fogNearValue;
-uniform float fogDensityValue;
+uniform float fade = 1.0;       // < 1.0 => the mesh is cross-faded with its impostor
 
 smooth in vec3 positionOut;
 
 
 void main() {
 
-  color_f = color_v;
+  // cross-fade with the impostor: keep only a part of the pixels
+  if (!meshKeepsPixel(fade))
+    discard;
 
-  // fog parameter 
-  float distToCam = -positionOut.z;
-  vec4 fogcolor = vec4(0.4, 0.4, 0.4, 1);
-  float fogFar = 2.0f;
+  color_f = color_v;
 
   // if material has a texture -> apply it
   if(material.useTexture)
     color_f =  color_v * texture(texSampler, texCoord_v);
 
-  if(fogOnLinearToggle){
-    float fogAmount = (fogNearValue - distToCam) / (fogNearValue - fogFar);
-    fogAmount = clamp(fogAmount, 0.0, 1.0);
-    color_f = mix(color_f, fogcolor, fogAmount);
-  }
-
-  if (fogOnExpToggle) {
-    float fogAmount = 1.0 - exp(-fogDensityValue * distToCam);
-    color_f = mix(color_f, fogcolor, fogAmount);
-  }
+  color_f = applyFog(color_f, -positionOut.z);
 
 }
@@ -29,8 +29,10 @@ struct Light {         // structure describing light parameters
 in vec3 position;           // vertex position in world space
 in vec3 normal;             // vertex normal
 in vec2 texCoord;           // incoming texture coordinates
+in float swayWeight;        // how much the vertex moves in the wind (0 for everything except vegetation)
 
-uniform float time;         // time used for simulation of moving lights (such as sun)
+uniform float time;         // time used for simulation of moving lights (such as sun) and of the wind
+uniform vec3 wind;          // wind direction * strength (world coordinates)
 uniform Material material;  // current material
 
 
@@ -40,6 +42,9 @@ uniform mat4 Vmatrix;       // View                       --> world to eye coord
 uniform mat4 Mmatrix;       // Model                      --> model to world coordinates
 uniform mat4 normalMatrix;  // inverse transposed Mmatrix
 
+uniform bool instanced;           // instances of one model, their transforms are read from instances
+uniform samplerBuffer instances;  // two texels per instance: position + size, cos + sin of the rotation around z
+
 uniform vec3 reflectorPosition;   // reflector position (world coordinates)
 uniform vec3 reflectorDirection;  // reflector direction (world coordinates)
 uniform vec3 campfireLoc;
@@ -52,6 +57,11 @@ uniform vec3 pointLightSpecular; // vec3(1.0f)
 
 smooth out vec2 texCoord_v;  // outgoing texture coordinates
 smooth out vec4 color_v;     // outgoing fragment color
+smooth out vec3 positionOut; // vertex in eye coordinates, for the fog
+
+mat4 instanceMatrix;     // transform of the instance in the model space, identity if not instanced
+mat4 modelMatrix;        // Mmatrix * instanceMatrix
+mat4 modelNormalMatrix;  // normalMatrix * rotation of the instance
 
 
 vec4 spotLight(Light light, Material material, vec3 vertexPosition, vec3 vertexNormal) {
@@ -82,7 +92,7 @@ vec4 spotLight(Light light, Material material, vec3 vertexPosition, vec3 vertexN
     ret *= pow(spotCoef, light.spotExponent);
 
   const vec3 fogColor = vec3(0.45, 0.45, 0.45);
-  vec4 viewSpace = Vmatrix * Mmatrix * vec4(position, 1);
+  vec4 viewSpace = Vmatrix * modelMatrix * vec4(position, 1);
 
   float dist = abs(viewSpace.z);
   float fogFactor = 1.0 / exp(dist * fogDensity);
@@ -113,7 +123,7 @@ vec4 directionalLight(Light light, Material material, vec3 vertexPosition, vec3
   ret += material.specular * light.specular * pow(RdotV, material.shininess);
 
   const vec3 fogColor = vec3(0.45, 0.45, 0.45);
-  vec4 viewSpace = Vmatrix * Mmatrix * vec4(position, 1);
+  vec4 viewSpace = Vmatrix * modelMatrix * vec4(position, 1);
 
   float dist= abs(viewSpace.z);
   float fogFactor = 1.0 / exp(dist * fogDensity);
@@ -172,13 +182,55 @@ void setupLights() {
   
 }
 
+// transform of the drawn instance (see drawSparrows()), scale and rotation around z + translation
+void setupInstance() {
+  instanceMatrix = mat4(1.0);
+  modelMatrix = Mmatrix;
+  modelNormalMatrix = normalMatrix;
+
+  if(instanced) {
+    vec4 positionSize = texelFetch(instances, 2 * gl_InstanceID);
+    vec2 rotation = texelFetch(instances, 2 * gl_InstanceID + 1).xy;
+
+    mat4 instanceRotation = mat4(
+      vec4(rotation.x, rotation.y, 0.0, 0.0),
+      vec4(-rotation.y, rotation.x, 0.0, 0.0),
+      vec4(0.0, 0.0, 1.0, 0.0),
+      vec4(0.0, 0.0, 0.0, 1.0)
+    );
+    instanceMatrix = instanceRotation * positionSize.w;
+    instanceMatrix[3] = vec4(positionSize.xyz, 1.0);
+
+    modelMatrix = Mmatrix * instanceMatrix;
+    // uniform scale => the rotation alone transforms the normals
+    modelNormalMatrix = normalMatrix * instanceRotation;
+  }
+}
+
+// wind displacement of the vertex in model coordinates
+vec3 windSway() {
+  // phase of the instance from its position => neighbouring plants do not move in sync
+  vec2 origin = modelMatrix[3].xy;
+  float phase = dot(origin, vec2(7.3, 3.1));
+
+  // slow main sway + faster small flutter
+  float sway = sin(1.7 * time + phase) + 0.3 * sin(4.3 * time + 2.0 * phase);
+  vec3 offset = wind * (swayWeight * sway);
+
+  // world => model direction: transposed normalMatrix is the inverse of the model rotation (and scale)
+  return mat3(transpose(modelNormalMatrix)) * offset;
+}
+
 void main() {
 
   setupLights();
+  setupInstance();
+
+  vec3 swayedPosition = position + windSway();
 
   // eye-coordinates position and normal of vertex
-  vec3 vertexPosition = (Vmatrix * Mmatrix * vec4(position, 1.0)).xyz;         // vertex in eye coordinates
-  vec3 vertexNormal   = normalize( (Vmatrix * normalMatrix * vec4(normal, 0.0) ).xyz);   // normal in eye coordinates by NormalMatrix
+  vec3 vertexPosition = (Vmatrix * modelMatrix * vec4(swayedPosition, 1.0)).xyz;  // vertex in eye coordinates
+  vec3 vertexNormal   = normalize( (Vmatrix * modelNormalMatrix * vec4(normal, 0.0) ).xyz);   // normal in eye coordinates by NormalMatrix
 
   // initialize the output color with the global ambient term
   vec3 globalAmbientLight = vec3(0.4f);
@@ -199,9 +251,10 @@ void main() {
   }
 
   // vertex position after the projection (gl_Position is built-in output variable)
-  gl_Position = PVMmatrix * vec4(position, 1);   // out:v vertex in clip coordinates
+  gl_Position = PVMmatrix * instanceMatrix * vec4(swayedPosition, 1);   // out:v vertex in clip coordinates
 
   // outputs entering the fragment shader
   color_v = outputColor;
   texCoord_v = texCoord;
+  positionOut = vertexPosition;
 }
@@ -16,6 +16,29 @@
 #include "spline.h"
 #include "data.h"
 #include "INIReader.h"
+#include "scatter.h"
+#include "terrain.h"
+#include "heightfield.h"
+#include "impostor.h"
+#include "particles.h"
+#include "replay.h"
+#include "collision.h"
+#include "capture.h"
+#include "picking.h"
+#ifdef FOREST_OFFSCREEN
+#include "offscreen.h"
+#include "golden.h"
+#endif
+#include "simulation.h"
+#include "jobs.h"
+#include "entities.h"
+#include "snapshot.h"
+#include "flock.h"
+#include "projectiles.h"
+#include <atomic>
+#include <thread>
+#include <algorithm>
+#include <chrono>
 #include <unordered_map>
 #include <string>
 
@@ -24,8 +47,6 @@
 extern SCommonShaderProgram shaderProgram;
 extern bool useLighting;
 
-typedef std::list<void *> GameObjectsList;
-
 struct GameState {
 
 	int windowWidth;    // set by reshape callback
@@ -35,9 +56,17 @@ struct GameState {
 	float cameraElevationAngle; // in degrees = initially 0.0f
 
 	bool gameOver;              // false;
+	bool windowless;            // drawn offscreen by runOffscreen(), GLUT is not initialized
 	bool keyMap[KEYS_COUNT];    // false
-
-	float elapsedTime;
+	float keyPressTime[KEYS_COUNT]; // when the pressed keys went down within the current step (0 ... 1)
+	float keyHeldTime[KEYS_COUNT];  // part of the current step the released keys were held
+	float inputTime;            // arrival of the applied input event within the step (0 ... 1)
+
+	unsigned int tick;          // simulation steps since the start
+	unsigned int sceneryVersion; // changed by generateScenery(), the snapshots copy the scenery again
+	float impostorDistance;     // mesh/impostor switch of the trees (config.ini)
+	float impostorFade;
+	float elapsedTime;          // = tick * SIMULATION_TIMESTEP
 	float missileLaunchTime;
 	float ufoMissileLaunchTime;
 
@@ -47,7 +76,7 @@ struct GameObjects {
 
   TerrainObject *terrain;
   PenguinObject *penguin;
-  SparrowObject *sparrow;
+  Flock sparrows;            // boids, see flock.h
   CatObject *cat;
   RockObject *rock;
   StoneObject *stone;
@@ -55,15 +84,21 @@ struct GameObjects {
   FernObject* fern2;
   FernObject* fern3;
   FernObject* fern4;
-  PalmTreeObject *palmTree1; 
-  PalmTreeObject* palmTree2;
-  PalmTreeObject* palmTree3;
-  PalmTreeObject* palmTree4;
   CampfireObject *campfire;
   BlockObject* block;
 
+  // scenery generated by scatterScenery()
+  GameObjectsList palmTrees;
+  GameObjectsList scatteredFerns;
+  GameObjectsList scatteredStones;
+  GameObjectsList scatteredRocks;
+  EntityStore palmTreeSpheres;  // bounding spheres of the palm trees for checkTreeCollisions()
+  std::vector<uint64_t> palmTreeHits;  // hit mask of checkTreeCollisions(), kept between the calls
+
   GameObjectsList targets;
-  GameObjectsList missiles;
+  EntityStore missiles;       // structure of arrays, see entities.h
+  SphereGrid colliders;       // targets and scenery hit by the missiles, see projectiles.h
+  std::vector<TargetObject*> colliderTargets;  // targets by COLLIDER_INDEX() of their collider ids
   GameObjectsList ufos;
   
 
@@ -111,6 +146,13 @@ std::unordered_map<std::string, float> readConfig(const std::string& filename) {
 	// Reading campfire configuration
 	configValues["Campfire.size"] = reader.GetReal("Campfire", "size", CAMPFIRE_SIZE);
 
+	// Reading scenery placement configuration
+	configValues["Scatter.seed"] = (float)reader.GetInteger("Scatter", "seed", SCATTER_SEED);
+
+	// Reading impostor configuration
+	configValues["Impostor.distance"] = reader.GetReal("Impostor", "distance", IMPOSTOR_DISTANCE);
+	configValues["Impostor.fade"] = reader.GetReal("Impostor", "fade", IMPOSTOR_FADE_BAND);
+
 	return configValues;
 }
 
@@ -134,46 +176,18 @@ void reloadConfig() {
 	gameObjects.fern2->size = configValues["Fern.size"];
 
 	gameObjects.campfire->size = configValues["Cat.size"];
+
+	// the map is empty when config.ini cannot be read => keep the defaults
+	if (configValues.count("Impostor.distance") > 0) {
+		gameState.impostorDistance = configValues["Impostor.distance"];
+		gameState.impostorFade = configValues["Impostor.fade"];
+	}
 }
 
 
 // END OF CONFIG PARSING
 // ---------------------------------------------------------------------------------------
 
-//----------------------------------------------------------------------------------------
-// START OF COLLISION HELPER FUNCTIONS
-/// Checks whether a given point is inside a sphere or not.
-/**
-\param[in]  point      Point to be tested.
-\param[in]  center     Center of the sphere.
-\param[in]  radius     Radius of the sphere.
-\return                True if the point lies inside the sphere, otherwise false.
-*/
-bool pointInSphere(const glm::vec3& point, const glm::vec3& center, float radius) {
-	if (glm::distance(point, center) <= radius)
-		return true;
-	else
-	return false;
-}
-
-/// Checks if there is intersection between two given spheres or not.
-/**
-\param[in]  center1    First sphere center.
-\param[in]  radius1    First sphere radius.
-\param[in]  center2    Second sphere center.
-\param[in]  radius2    Second sphere radius.
-\return                True if the spheres overlap, otherwise false.
-*/
-bool spheresIntersection(const glm::vec3& center1, float radius1, const glm::vec3& center2, float radius2) {
-	//   check whether given spheres are intersecting each other or not
-	if (glm::distance(center1, center2) < radius1 + radius2)
-		return true;
-	else
-		return false;
-}
-// END OF COLLISION HELPER FUNCTIONS
-//----------------------------------------------------------------------------------------
-
 //----------------------------------------------------------------------------------------
 // START OF TELEPORT + GENERATE RANDOM POSITION FUNCTIONS
 
@@ -187,8 +201,8 @@ glm::vec3 generateRandomPosition(void) {
 		// position is generated randomly
 		// coordinates are in range -1.0f ... 1.0f
 		newPosition = glm::vec3(
-			(float)(2.0 * (rand() / (double)RAND_MAX) - 1.0),
-			(float)(2.0 * (rand() / (double)RAND_MAX) - 1.0),
+			2.0f * simulationRandom() - 1.0f,
+			2.0f * simulationRandom() - 1.0f,
 			-2.0f
 		);
 		invalidPosition = pointInSphere(newPosition, gameObjects.penguin->position, 3.0f * PENGUIN_SIZE);
@@ -201,8 +215,8 @@ glm::vec3 generateRandomPosition(void) {
 void teleport(void) {
 	// generate new space ship position randomly
 	gameObjects.penguin->position = glm::vec3(
-		(float)(2.0 * (rand() / (double)RAND_MAX) - 1.0),
-		(float)(2.0 * (rand() / (double)RAND_MAX) - 1.0),
+		2.0f * simulationRandom() - 1.0f,
+		2.0f * simulationRandom() - 1.0f,
 		0.0f
 	);
 }
@@ -231,23 +245,27 @@ TargetObject* createTarget(void) {
 
 void createMissile(const glm::vec3& missilePosition, const glm::vec3& missileDirection, float& missileLaunchTime) {
 
-	float currentTime = 0.001f * (float)glutGet(GLUT_ELAPSED_TIME); // milliseconds => seconds
+	float currentTime = gameState.elapsedTime;
 	if (currentTime - missileLaunchTime < MISSILE_LAUNCH_TIME_DELAY)
 		return;
 
+	// the arrays are allocated for PROJECTILE_CAPACITY missiles by restartGame()
+	if (entityCount(gameObjects.missiles) >= PROJECTILE_CAPACITY)
+		return;
+
 	missileLaunchTime = currentTime;
 
-	MissileObject* newMissile = new MissileObject;
+	MissileObject newMissile;
 
-	newMissile->destroyed = false;
-	newMissile->startTime = gameState.elapsedTime;
-	newMissile->currentTime = newMissile->startTime;
-	newMissile->size = MISSILE_SIZE;
-	newMissile->speed = MISSILE_SPEED;
-	newMissile->position = missilePosition;
-	newMissile->direction = glm::normalize(missileDirection);
+	newMissile.destroyed = false;
+	newMissile.startTime = gameState.elapsedTime;
+	newMissile.currentTime = newMissile.startTime;
+	newMissile.size = MISSILE_SIZE;
+	newMissile.speed = MISSILE_SPEED;
+	newMissile.position = missilePosition;
+	newMissile.direction = glm::normalize(missileDirection);
 
-	gameObjects.missiles.push_back(newMissile);
+	createEntity(gameObjects.missiles, newMissile);
 }
 
 BannerObject* createBanner(void) {
@@ -287,6 +305,110 @@ void cleanUpObjects(void) {
 	}
 }
 
+void cleanUpScenery(void) {
+
+	while (!gameObjects.palmTrees.empty()) {
+		delete (PalmTreeObject*)gameObjects.palmTrees.back();
+		gameObjects.palmTrees.pop_back();
+	}
+	clearEntities(gameObjects.palmTreeSpheres);
+	while (!gameObjects.scatteredFerns.empty()) {
+		delete (FernObject*)gameObjects.scatteredFerns.back();
+		gameObjects.scatteredFerns.pop_back();
+	}
+	while (!gameObjects.scatteredStones.empty()) {
+		delete (StoneObject*)gameObjects.scatteredStones.back();
+		gameObjects.scatteredStones.pop_back();
+	}
+	while (!gameObjects.scatteredRocks.empty()) {
+		delete (RockObject*)gameObjects.scatteredRocks.back();
+		gameObjects.scatteredRocks.pop_back();
+	}
+}
+
+// Fills the terrain with palm trees, ferns, stones and rocks. Hand placed objects must be initialized before.
+void generateScenery(unsigned int seed) {
+
+	gameState.sceneryVersion++;
+
+	cleanUpScenery();
+
+	// layers are placed in this order => trees get the space first
+	const ScatterLayer layers[] = {
+		{ SCATTER_PALM_TREE, PALM_TREE_MIN_DISTANCE, PALM_TREE_EXCLUSION, PALM_TREE_DENSITY },
+		{ SCATTER_STONE,     STONE_MIN_DISTANCE,     STONE_EXCLUSION,     STONE_DENSITY },
+		{ SCATTER_ROCK,      ROCK_MIN_DISTANCE,      ROCK_EXCLUSION,      ROCK_DENSITY },
+		{ SCATTER_FERN,      FERN_MIN_DISTANCE,      FERN_EXCLUSION,      FERN_DENSITY },
+	};
+
+	// keep the hand placed objects free
+	std::vector<glm::vec3> reserved;
+	reserved.push_back(glm::vec3(glm::vec2(gameObjects.penguin->position), 2.0f * gameObjects.penguin->size));
+	reserved.push_back(glm::vec3(glm::vec2(gameObjects.campfire->position), 2.0f * gameObjects.campfire->size));
+	reserved.push_back(glm::vec3(glm::vec2(gameObjects.cat->position), gameObjects.cat->size));
+	reserved.push_back(glm::vec3(glm::vec2(gameObjects.rock->position), gameObjects.rock->size));
+	reserved.push_back(glm::vec3(glm::vec2(gameObjects.stone->position), gameObjects.stone->size));
+	reserved.push_back(glm::vec3(glm::vec2(gameObjects.block->position), 0.5f * gameObjects.block->size));
+	reserved.push_back(glm::vec3(glm::vec2(gameObjects.fern1->position), 0.5f * gameObjects.fern1->size));
+	reserved.push_back(glm::vec3(glm::vec2(gameObjects.fern2->position), 0.5f * gameObjects.fern2->size));
+	reserved.push_back(glm::vec3(glm::vec2(gameObjects.fern3->position), 0.5f * gameObjects.fern3->size));
+	reserved.push_back(glm::vec3(glm::vec2(gameObjects.fern4->position), 0.5f * gameObjects.fern4->size));
+
+	std::vector<ScatterPoint> points = scatterScenery(
+		layers, sizeof(layers) / sizeof(layers[0]),
+		glm::vec2(-SCATTER_AREA), glm::vec2(SCATTER_AREA),
+		reserved, seed
+	);
+
+	for (size_t i = 0; i < points.size(); i++) {
+		const glm::vec2& position = points[i].position;
+
+		switch (points[i].type) {
+		case SCATTER_PALM_TREE: {
+			if (gameObjects.palmTrees.size() >= PALM_TREE_COUNT_MAX)
+				break;
+			PalmTreeObject* palmTree = new PalmTreeObject;
+			palmTree->position = glm::vec3(position, getTerrainHeight(position.x, position.y) + PALM_TREE_BASE_HEIGHT);
+			palmTree->size = PALM_TREE_SIZE;
+			palmTree->destroyed = false;
+			gameObjects.palmTrees.push_back(palmTree);
+			break;
+		}
+		case SCATTER_FERN: {
+			FernObject* fern = new FernObject;
+			fern->position = glm::vec3(position, getTerrainHeight(position.x, position.y) + FERN_BASE_HEIGHT);
+			fern->size = FERN_SIZE;
+			fern->destroyed = false;
+			gameObjects.scatteredFerns.push_back(fern);
+			break;
+		}
+		case SCATTER_STONE: {
+			StoneObject* stone = new StoneObject;
+			stone->position = glm::vec3(position, getTerrainHeight(position.x, position.y) + STONE_BASE_HEIGHT);
+			stone->size = ROCK_SIZE;
+			stone->destroyed = false;
+			gameObjects.scatteredStones.push_back(stone);
+			break;
+		}
+		case SCATTER_ROCK: {
+			RockObject* rock = new RockObject;
+			rock->position = glm::vec3(position, getTerrainHeight(position.x, position.y) + ROCK_BASE_HEIGHT);
+			rock->size = ROCK_SIZE;
+			rock->destroyed = false;
+			gameObjects.scatteredRocks.push_back(rock);
+			break;
+		}
+		}
+	}
+
+	// the trees do not move - their spheres are packed once for the batch test
+	for (GameObjectsList::iterator it = gameObjects.palmTrees.begin(); it != gameObjects.palmTrees.end(); ++it)
+		createEntity(gameObjects.palmTreeSpheres, *(PalmTreeObject*)(*it));
+
+	if (gameObjects.palmTrees.size() < PALM_TREE_COUNT_MIN)
+		std::cout << "generateScenery(): only " << gameObjects.palmTrees.size() << " palm trees fit into the scene" << std::endl;
+}
+
 bool checkValiditySize(float size) {
     return size > 0.1f && size < 2.0f;
 }
@@ -310,7 +432,7 @@ void restartGame(void) {
     // Read the configuration
     auto configValues = readConfig("config.ini");
 
-	gameState.elapsedTime = 0.001f * (float)glutGet(GLUT_ELAPSED_TIME); // milliseconds => seconds
+	gameState.elapsedTime = gameState.tick * SIMULATION_TIMESTEP;
 
 	// init terrain
 	if (gameObjects.terrain == NULL)
@@ -334,13 +456,9 @@ void restartGame(void) {
 
 	std::cout << "Elapsed Time" << gameState.elapsedTime << std::endl;
 
-	// init sparrow
-	if (gameObjects.sparrow == NULL)
-		gameObjects.sparrow = new SparrowObject;
-
-	gameObjects.sparrow->position = glm::vec3(0.0f, 0.0f, 0.1f);
-	gameObjects.sparrow->currentAngle = 0.0f;
-	gameObjects.sparrow->size = SPARROW_SIZE;
+	// init sparrows
+	int sparrowCount = SPARROW_COUNT_MIN + int(decorationRandom() * (SPARROW_COUNT_MAX - SPARROW_COUNT_MIN + 1));
+	initializeFlock(gameObjects.sparrows, std::min(sparrowCount, SPARROW_COUNT_MAX), gameState.elapsedTime);
 
 	// init cat
 	if (gameObjects.cat == NULL)
@@ -376,35 +494,6 @@ void restartGame(void) {
 	gameObjects.stone->direction = glm::vec3(-0.1f, 0.7f, 0.12f);
 	gameObjects.stone->size = ROCK_SIZE;
 
-	// init palm tree
-	if (gameObjects.palmTree1 == NULL)
-		gameObjects.palmTree1 = new PalmTreeObject;
-
-	gameObjects.palmTree1->position = glm::vec3(0.45f, 0.3f, 0.26f);
-	gameObjects.palmTree1->size = PALM_TREE_SIZE;
-	gameObjects.palmTree1->destroyed = false;
-
-	if (gameObjects.palmTree2 == NULL)
-		gameObjects.palmTree2 = new PalmTreeObject;
-
-	gameObjects.palmTree2->position = glm::vec3(0.45f, 0.65f, 0.26f);
-	gameObjects.palmTree2->size = PALM_TREE_SIZE;
-	gameObjects.palmTree2->destroyed = false;
-
-	if (gameObjects.palmTree3 == NULL)
-		gameObjects.palmTree3 = new PalmTreeObject;
-
-	gameObjects.palmTree3->position = glm::vec3(-0.65f, 0.3f, 0.26f);
-	gameObjects.palmTree3->size = PALM_TREE_SIZE;
-	gameObjects.palmTree3->destroyed = false;
-
-	if (gameObjects.palmTree4 == NULL)
-		gameObjects.palmTree4 = new PalmTreeObject;
-
-	gameObjects.palmTree4->position = glm::vec3(-0.65f, 0.65f, 0.26f);
-	gameObjects.palmTree4->size = PALM_TREE_SIZE;
-	gameObjects.palmTree4->destroyed = false;
-
 	// init fern
 	if (gameObjects.fern1 == NULL)
 		gameObjects.fern1 = new FernObject;
@@ -464,6 +553,16 @@ void restartGame(void) {
 	);
 	gameObjects.block->direction = glm::normalize(gameObjects.block->direction);
 
+	// palm trees, ferns, stones and rocks are placed procedurally around the objects above
+	generateScenery((unsigned int)configValues["Scatter.seed"]);
+
+	// distance of the mesh/impostor switch of the trees
+	gameState.impostorDistance = IMPOSTOR_DISTANCE;
+	gameState.impostorFade = IMPOSTOR_FADE_BAND;
+	if (configValues.count("Impostor.distance") > 0) {
+		gameState.impostorDistance = configValues["Impostor.distance"];
+		gameState.impostorFade = configValues["Impostor.fade"];
+	}
 
 	// init target
 	for (int i = 0; i<TARGET_COUNT_MIN; i++) {
@@ -472,18 +571,21 @@ void restartGame(void) {
 		gameObjects.targets.push_back(newTarget);
 	}
 
-	if(gameState.cameraState == true) {
-		gameState.cameraState = false;
-		glutPassiveMotionFunc(NULL);
-	}
 	gameState.cameraElevationAngle = 0.0f;
 
 	// reset key map
-	for(int i=0; i<KEYS_COUNT; i++)
+	for(int i=0; i<KEYS_COUNT; i++) {
 		gameState.keyMap[i] = false;
+		gameState.keyPressTime[i] = 0.0f;
+		gameState.keyHeldTime[i] = 0.0f;
+	}
 
 	gameState.gameOver = false;
-	//   gameState.missileLaunchTime = -MISSILE_LAUNCH_TIME_DELAY;
+
+	// missiles - the pool is allocated once, launching does not allocate
+	clearEntities(gameObjects.missiles);
+	reserveEntities(gameObjects.missiles, PROJECTILE_CAPACITY);
+	gameState.missileLaunchTime = -MISSILE_LAUNCH_TIME_DELAY;
 	//   gameState.ufoMissileLaunchTime = -MISSILE_LAUNCH_TIME_DELAY;
 }
 
@@ -495,6 +597,12 @@ void restartGame(void) {
 
 void insertExplosion(const glm::vec3 &position) {
 
+	// GPU particles - no object on the CPU side at all
+	if (particlesAvailable()) {
+		spawnExplosionParticles(position, BILLBOARD_SIZE, gameState.elapsedTime);
+		return;
+	}
+
 	ExplosionObject* newExplosion = new ExplosionObject;
 
 	newExplosion->speed = 0.0f;
@@ -519,32 +627,16 @@ void insertExplosion(const glm::vec3 &position) {
 
 //------------------------------------------------------------------cameraState--------------------
 // START OF MANIPULATING PENGUIN VIEW (Top Down View)
+// Tests the penguin at a new position against all palm trees at once (SSE2/AVX2, see collision.h).
 bool checkTreeCollisions(glm::vec3 tempPos) {
-	if (gameObjects.palmTree1->destroyed == false) {
-		if (spheresIntersection(tempPos, gameObjects.penguin->size, gameObjects.palmTree1->position, gameObjects.palmTree1->size) == true) {
-			//gameObjects.penguin->position -= glm::vec3(0.05, 0.05, 0);
-			return true;
-		}
-	}
-	if (gameObjects.palmTree2->destroyed == false) {
-		if (spheresIntersection(tempPos, gameObjects.penguin->size, gameObjects.palmTree2->position, gameObjects.palmTree2->size) == true) {
-
-			//gameObjects.penguin->position -= glm::vec3(0.05, 0.05, 0);
-			return true;
-		}
-	}
-	if (gameObjects.palmTree3->destroyed == false) {
-		if (spheresIntersection(tempPos, gameObjects.penguin->size, gameObjects.palmTree3->position, gameObjects.palmTree3->size) == true) {
-			//gameObjects.penguin->position -= glm::vec3(0.05, 0.05, 0);
-			return true;
-		}
-	}
-	if (gameObjects.palmTree4->destroyed == false) {
-		if (spheresIntersection(tempPos, gameObjects.penguin->size, gameObjects.palmTree4->position, gameObjects.palmTree4->size) == true) {
-			//gameObjects.penguin->position -= glm::vec3(0.05, 0.05, 0);
-			return true;
-		}
-	}
+	const EntityStore& trees = gameObjects.palmTreeSpheres;
+	std::vector<uint64_t>& hitMask = gameObjects.palmTreeHits;
+	hitMask.resize((entityCount(trees) + 63) / 64);  // allocates only when the palm trees are added
+
+	size_t hits = spheresIntersectionBatch(tempPos, gameObjects.penguin->size,
+		trees.positionX.data(), trees.positionY.data(), trees.positionZ.data(), trees.size.data(),
+		entityCount(trees), hitMask.data());
+	return hits > 0;
 }
 
 void increaseBirdSpeed(float deltaSpeed = PENGUIN_SPEED_INCREMENT) {
@@ -562,19 +654,26 @@ void increaseBirdHeight(float deltaLength = PENGUIN_LENGTH_INCREMENT) {
 	gameObjects.penguin->position.z = gameObjects.penguin->position.z + deltaLength;
 }
 
+// keeps the position at least PENGUIN_HEIGHT_MIN above the terrain
+glm::vec3 clampToGround(glm::vec3 position) {
+	position.z = std::max(position.z, getTerrainHeight(position.x, position.y) + PENGUIN_HEIGHT_MIN);
+	return position;
+}
+
 void decreaseBirdHeight(float deltaLength = PENGUIN_LENGTH_INCREMENT) {
-	gameObjects.penguin->position.z = std::max(gameObjects.penguin->position.z - deltaLength, PENGUIN_HEIGHT_MIN);
+	gameObjects.penguin->position.z -= deltaLength;
+	gameObjects.penguin->position = clampToGround(gameObjects.penguin->position);
 }
 
 void moveBirdForward(float deltaLength = PENGUIN_LENGTH_INCREMENT) {
-	glm::vec3 tempPos = gameObjects.penguin->position + deltaLength * gameObjects.penguin->direction;
+	glm::vec3 tempPos = clampToGround(gameObjects.penguin->position + deltaLength * gameObjects.penguin->direction);
 	if (!gameObjects.penguin->destroyed && !checkTreeCollisions(tempPos)) {
 		gameObjects.penguin->position = tempPos;
 	} 
 }
 
 void moveBirdBackward(float deltaLength = PENGUIN_LENGTH_INCREMENT) {
-	glm::vec3 tempPos = gameObjects.penguin->position - deltaLength * gameObjects.penguin->direction;
+	glm::vec3 tempPos = clampToGround(gameObjects.penguin->position - deltaLength * gameObjects.penguin->direction);
 	if (!gameObjects.penguin->destroyed && !checkTreeCollisions(tempPos)) {
 		gameObjects.penguin->position = tempPos;
 	}
@@ -612,34 +711,11 @@ void turnBirdRight(float deltaAngle) {
 //----------------------------------------------------------------------------------------
 // START OF DRAWWINDOWCONTENTS FUNCTION
 
-void drawWindowContents() {
+// Sets the view and projection matrices of the camera of a snapshot (cameraState).
+// Used for the drawing and for the picking, the click selects what is drawn under the cursor.
+void computeCameraMatrices(const RenderSnapshot& snapshot, glm::mat4& viewMatrix, glm::mat4& projectionMatrix) {
 
-	// setup parallel projection
-	glm::mat4 orthoProjectionMatrix = glm::ortho(
-		-SCENE_WIDTH, SCENE_WIDTH,
-		-SCENE_HEIGHT, SCENE_HEIGHT,
-		-10.0f*SCENE_DEPTH, 10.0f*SCENE_DEPTH
-		);
-	// static viewpoint - top view
-	glm::mat4 orthoTopViewMatrix = glm::lookAt(
-		glm::vec3(0.0f, 0.0f, 1.0f),
-		glm::vec3(0.0f, 0.0f, 0.0f),
-		glm::vec3(0.0f, 1.0f, 0.0f)
-		);
-
-	// static viewpoint - side view
-	glm::mat4 orthoSideViewSMatrix = glm::lookAt(
-		glm::vec3(0.0f, 1.0f, 1.0f),
-		glm::vec3(0.0f, 0.0f, 0.0f),
-		glm::vec3(0.0f, 1.0f, 0.0f)
-	);
-
-	// setup camera & projection transform
-	glm::mat4 viewMatrix = orthoTopViewMatrix;
-	glm::mat4 projectionMatrix = orthoProjectionMatrix;
-
-	// setup camera angles here
-	if (gameState.cameraState == 0) { // top camera
+	if (snapshot.cameraState == 0) { // top camera
 
 		glm::vec3 cameraPosition = glm::vec3(-1.0, 1.0, 1.0);
 		glm::vec3 cameraUpVector = glm::vec3(0.0f, 0.0f, 1.0f);
@@ -648,7 +724,7 @@ void drawWindowContents() {
 		glm::vec3 cameraViewDirection = glm::vec3(1.0, -1.0, -1.0);
 
 		glm::vec3 rotationAxis = glm::cross(cameraViewDirection, glm::vec3(0.0f, 0.0f, 1.0f));
-		glm::mat4 cameraTransform = glm::rotate(glm::mat4(1.0f), glm::radians(gameState.cameraElevationAngle), rotationAxis);
+		glm::mat4 cameraTransform = glm::rotate(glm::mat4(1.0f), glm::radians(snapshot.cameraElevationAngle), rotationAxis);
 
 		cameraUpVector = glm::vec3(cameraTransform * glm::vec4(cameraUpVector, 0.0f));
 		cameraViewDirection = glm::vec3(cameraTransform * glm::vec4(cameraViewDirection, 0.0f));
@@ -664,16 +740,16 @@ void drawWindowContents() {
 		projectionMatrix = glm::perspective(glm::radians(60.0f), gameState.windowWidth / (float)gameState.windowHeight, 0.1f, 10.0f);
 	}
 
-	if (gameState.cameraState == 1) { // penguin camera
+	if (snapshot.cameraState == 1) { // penguin camera
 
-		glm::vec3 cameraPosition = gameObjects.penguin->position;
+		glm::vec3 cameraPosition = snapshot.penguin.position;
 		glm::vec3 cameraUpVector = glm::vec3(0.0f, 0.0f, 1.0f);
 		glm::vec3 cameraCenter;
 
-		glm::vec3 cameraViewDirection = gameObjects.penguin->direction;
+		glm::vec3 cameraViewDirection = snapshot.penguin.direction;
 
 		glm::vec3 rotationAxis = glm::cross(cameraViewDirection, cameraUpVector); // glm::vec3(0.0f, 0.0f, 1.0f)
-		glm::mat4 cameraTransform = glm::rotate(glm::mat4(1.0f), glm::radians(gameState.cameraElevationAngle), rotationAxis);
+		glm::mat4 cameraTransform = glm::rotate(glm::mat4(1.0f), glm::radians(snapshot.cameraElevationAngle), rotationAxis);
 
 		cameraUpVector = glm::vec3(cameraTransform * glm::vec4(cameraUpVector, 0.0f));
 		cameraViewDirection = glm::vec3(cameraTransform * glm::vec4(cameraViewDirection, 0.0f));
@@ -689,7 +765,7 @@ void drawWindowContents() {
 		projectionMatrix = glm::perspective(glm::radians(60.0f), gameState.windowWidth / (float)gameState.windowHeight, 0.1f, 10.0f);
 	}
 
-	if (gameState.cameraState == 2) { // side camera
+	if (snapshot.cameraState == 2) { // side camera
 
 		glm::vec3 cameraPosition = glm::vec3(0.5, 0.5, 1.0);
 		glm::vec3 cameraUpVector = glm::vec3(0.0f, 0.0f, 1.0f);
@@ -698,7 +774,7 @@ void drawWindowContents() {
 		glm::vec3 cameraViewDirection = glm::vec3(-1.0, 0.0, -1.0);
 
 		glm::vec3 rotationAxis = glm::cross(cameraViewDirection, glm::vec3(0.0f, 0.0f, 1.0f));
-		glm::mat4 cameraTransform = glm::rotate(glm::mat4(1.0f), glm::radians(gameState.cameraElevationAngle), rotationAxis);
+		glm::mat4 cameraTransform = glm::rotate(glm::mat4(1.0f), glm::radians(snapshot.cameraElevationAngle), rotationAxis);
 
 		cameraUpVector = glm::vec3(cameraTransform * glm::vec4(cameraUpVector, 0.0f));
 		cameraViewDirection = glm::vec3(cameraTransform * glm::vec4(cameraViewDirection, 0.0f));
@@ -713,27 +789,65 @@ void drawWindowContents() {
 
 		projectionMatrix = glm::perspective(glm::radians(60.0f), gameState.windowWidth / (float)gameState.windowHeight, 0.1f, 10.0f);
 	}
+}
+
+// Draws the scene as it was at the end of one simulation step.
+void drawWindowContents(const RenderSnapshot& snapshot) {
+
+	// setup parallel projection
+	glm::mat4 orthoProjectionMatrix = glm::ortho(
+		-SCENE_WIDTH, SCENE_WIDTH,
+		-SCENE_HEIGHT, SCENE_HEIGHT,
+		-10.0f*SCENE_DEPTH, 10.0f*SCENE_DEPTH
+		);
+	// static viewpoint - top view
+	glm::mat4 orthoTopViewMatrix = glm::lookAt(
+		glm::vec3(0.0f, 0.0f, 1.0f),
+		glm::vec3(0.0f, 0.0f, 0.0f),
+		glm::vec3(0.0f, 1.0f, 0.0f)
+		);
+
+	// static viewpoint - side view
+	glm::mat4 orthoSideViewSMatrix = glm::lookAt(
+		glm::vec3(0.0f, 1.0f, 1.0f),
+		glm::vec3(0.0f, 0.0f, 0.0f),
+		glm::vec3(0.0f, 1.0f, 0.0f)
+	);
+
+	// setup camera & projection transform
+	glm::mat4 viewMatrix = orthoTopViewMatrix;
+	glm::mat4 projectionMatrix = orthoProjectionMatrix;
+
+	computeCameraMatrices(snapshot, viewMatrix, projectionMatrix);
+
+	// stream the terrain chunks around the penguin
+	updateTerrainChunks(snapshot.penguin.position);
+	setImpostorDistances(snapshot.impostorDistance, snapshot.impostorFade);
 
 	// setting up sun
 	glUseProgram(shaderProgram.program);
 	//oricode
-	glUniform1f(shaderProgram.timeLocation, gameState.elapsedTime);
+	glUniform1f(shaderProgram.timeLocation, snapshot.elapsedTime);
+	glUniform3fv(shaderProgram.windLocation, 1, glm::value_ptr(WIND_STRENGTH * WIND_DIRECTION));
 
-	glUniform3fv(shaderProgram.reflectorPositionLocation, 1, glm::value_ptr(gameObjects.penguin->position - 0.1f * gameObjects.penguin->direction)); // light pos
-	glUniform3fv(shaderProgram.reflectorDirectionLocation, 1, glm::value_ptr(gameObjects.penguin->direction)); // light facing direction
+	glUniform3fv(shaderProgram.reflectorPositionLocation, 1, glm::value_ptr(snapshot.penguin.position - 0.1f * snapshot.penguin.direction)); // light pos
+	glUniform3fv(shaderProgram.reflectorDirectionLocation, 1, glm::value_ptr(snapshot.penguin.direction)); // light facing direction
 
-	glUniform1i(shaderProgram.pointLightLoc, pointEnable);
+	glUniform1i(shaderProgram.pointLightLoc, snapshot.pointEnable);
 	glUniform3fv(shaderProgram.pointLightPosLoc, 1, glm::value_ptr(pointLightPos));
 	glUniform3fv(shaderProgram.pointLightAmbientLoc, 1, glm::value_ptr(pointLightAmbient));
 	glUniform3fv(shaderProgram.pointLightSpecularLoc, 1, glm::value_ptr(pointLightSpecular));
 
-	glUniform1f(shaderProgram.fogOnLinearLoc, fogLinearToggleInput);
-	glUniform1f(shaderProgram.fogOnExpLoc, fogExpToggleInput);
-    glUniform1f(shaderProgram.fogOnNearLoc, fogNearValue);
-    glUniform1f(shaderProgram.fogOnDensityLoc, fogDensityValue);
+	glUniform1f(shaderProgram.fogOnLinearLoc, snapshot.fogLinear);
+	glUniform1f(shaderProgram.fogOnExpLoc, snapshot.fogExp);
+    glUniform1f(shaderProgram.fogOnNearLoc, snapshot.fogNear);
+    glUniform1f(shaderProgram.fogOnDensityLoc, snapshot.fogDensity);
 
 	glUseProgram(0);
 
+	// the impostors of the distant trees get the same fog as the meshes
+	setImpostorFog(snapshot.fogLinear, snapshot.fogExp, snapshot.fogNear, snapshot.fogDensity);
+
 
 
 	/*glUniform3fv(shaderProgram.reflectorPositionLocation, 1, glm::value_ptr(gameObjects.balloon->position));
@@ -743,91 +857,191 @@ void drawWindowContents() {
 	glUseProgram(0);*/
 
 
-	// drawing object functions here
-	drawPenguin(gameObjects.penguin, viewMatrix, projectionMatrix);
-	drawTerrain(gameObjects.terrain, viewMatrix, projectionMatrix);
-	drawSparrow(gameObjects.sparrow, viewMatrix, projectionMatrix);
+	// drawing object functions here - the snapshot is only read, the simulation thread fills the next one
+	const RenderSnapshot& objects = snapshot;
 
-	drawCat(gameObjects.cat, viewMatrix, projectionMatrix);
-	drawRock(gameObjects.rock, viewMatrix, projectionMatrix);
-	drawStone(gameObjects.stone, viewMatrix, projectionMatrix);
+	drawPenguin(&objects.penguin, viewMatrix, projectionMatrix);
+	drawTerrain(&objects.terrain, viewMatrix, projectionMatrix);
+	drawSparrows(objects.sparrows, viewMatrix, projectionMatrix);
 
-	drawPalmTree(gameObjects.palmTree1, viewMatrix, projectionMatrix);
-	drawPalmTree(gameObjects.palmTree2, viewMatrix, projectionMatrix);
-	drawPalmTree(gameObjects.palmTree3, viewMatrix, projectionMatrix);
-	drawPalmTree(gameObjects.palmTree4, viewMatrix, projectionMatrix);
+	drawCat(&objects.cat, viewMatrix, projectionMatrix);
+	drawRock(&objects.rock, viewMatrix, projectionMatrix);
+	drawStone(&objects.stone, viewMatrix, projectionMatrix);
 
-	drawCampfire(gameObjects.campfire, viewMatrix, projectionMatrix);
-	drawBlock(gameObjects.block, viewMatrix, projectionMatrix);
+	// draw procedurally placed scenery
+	std::vector<const PalmTreeObject*> palmTrees;
+	for (size_t i = 0; i < objects.palmTrees.size(); i++)
+		palmTrees.push_back(&objects.palmTrees[i]);
+	drawPalmTrees(palmTrees, viewMatrix, projectionMatrix);
+	for (size_t i = 0; i < objects.scatteredFerns.size(); i++)
+		drawFern(&objects.scatteredFerns[i], viewMatrix, projectionMatrix);
+	for (size_t i = 0; i < objects.scatteredStones.size(); i++)
+		drawStone(&objects.scatteredStones[i], viewMatrix, projectionMatrix);
+	for (size_t i = 0; i < objects.scatteredRocks.size(); i++)
+		drawRock(&objects.scatteredRocks[i], viewMatrix, projectionMatrix);
+
+	drawCampfire(&objects.campfire, viewMatrix, projectionMatrix);
+	drawBlock(&objects.block, viewMatrix, projectionMatrix);
+
+	// the objects are picked by a ray cast in mouseCallback(), no ids are written to the stencil buffer
+	for (size_t i = 0; i < objects.targets.size(); i++)
+		drawTarget(&objects.targets[i], viewMatrix, projectionMatrix);
+
+	for (int i = 0; i < 4; i++)
+		drawFern(&objects.ferns[i], viewMatrix, projectionMatrix);
 
-	glEnable(GL_STENCIL_TEST);
-	glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
 	CHECK_GL_ERROR();
 
-	int id = 0;
-	for (GameObjectsList::iterator it = gameObjects.targets.begin(); it != gameObjects.targets.end(); ++it) {
-		glStencilFunc(GL_ALWAYS, id + 1, -1);
-		CHECK_GL_ERROR();
+	// draw missiles
+	for (size_t i = 0; i < objects.missiles.size(); i++)
+		drawMissile(&objects.missiles[i], viewMatrix, projectionMatrix);
 
-		TargetObject* target = (TargetObject*)(*it);
-		drawTarget(target, viewMatrix, projectionMatrix);
+	// draw skybox
+	drawSkybox(viewMatrix, projectionMatrix);
 
-		id++;
+	// draw explosions with depth test disabled
+	glDisable(GL_DEPTH_TEST);
+
+	updateParticles(snapshot.elapsedTime, snapshot.particleCount);
+	drawParticles(viewMatrix, projectionMatrix, snapshot.elapsedTime);
+
+	// billboard explosions (used when the particle system is not available) - one draw call
+	std::vector<const ExplosionObject*> explosions;
+	for (size_t i = 0; i < objects.explosions.size(); i++)
+		explosions.push_back(&objects.explosions[i]);
+	drawExplosions(explosions, viewMatrix, projectionMatrix, snapshot.elapsedTime);
+	glEnable(GL_DEPTH_TEST);
+
+	if (snapshot.gameOver == true) {
+		// draw game over banner
+		if (snapshot.hasBanner)
+			drawBanner(&objects.banner, orthoTopViewMatrix, orthoProjectionMatrix);
 	}
+}
+
+// END OF DRAWWINDOWCONTENTS FUNCTION
+//----------------------------------------------------------------------------------------
 
-	// disable stencil test
-	glDisable(GL_STENCIL_TEST);
+//----------------------------------------------------------------------------------------
+// START OF SIMULATION THREAD FUNCTIONS
+
+// finished simulation steps, written by the simulation thread and drawn by the window thread
+TripleBuffer<RenderSnapshot> renderSnapshots;
+
+std::thread simulationThread;
+std::atomic<bool> simulationRunning(false);
+std::atomic<bool> simulationFinished(false); // the replay is over, the window thread leaves the main loop
+
+bool simulationStep(void);
+
+// Copies everything the drawing needs into a free snapshot and hands it to the drawing.
+void publishSnapshot(void) {
+
+	RenderSnapshot& snapshot = renderSnapshots.writeBuffer();
+
+	snapshot.tick = gameState.tick;
+	snapshot.elapsedTime = gameState.elapsedTime;
+	snapshot.particleCount = queuedParticleCount();
+	snapshot.cameraState = gameState.cameraState;
+	snapshot.cameraElevationAngle = gameState.cameraElevationAngle;
+	snapshot.gameOver = gameState.gameOver;
+
+	snapshot.pointEnable = pointEnable;
+	snapshot.fogLinear = fogLinearToggleInput;
+	snapshot.fogExp = fogExpToggleInput;
+	snapshot.fogNear = fogNearValue;
+	snapshot.fogDensity = fogDensityValue;
+	snapshot.impostorDistance = gameState.impostorDistance;
+	snapshot.impostorFade = gameState.impostorFade;
+
+	snapshot.terrain = *gameObjects.terrain;
+	snapshot.penguin = *gameObjects.penguin;
+	copyFlock(gameObjects.sparrows, snapshot.sparrows);
+	snapshot.cat = *gameObjects.cat;
+	snapshot.rock = *gameObjects.rock;
+	snapshot.stone = *gameObjects.stone;
+	snapshot.ferns[0] = *gameObjects.fern1;
+	snapshot.ferns[1] = *gameObjects.fern2;
+	snapshot.ferns[2] = *gameObjects.fern3;
+	snapshot.ferns[3] = *gameObjects.fern4;
+	snapshot.campfire = *gameObjects.campfire;
+	snapshot.block = *gameObjects.block;
+
+	snapshot.hasBanner = (gameObjects.bannerObject != NULL);
+	if (snapshot.hasBanner)
+		snapshot.banner = *gameObjects.bannerObject;
+
+	// thousands of objects which do not move - copied once per generateScenery() into every snapshot
+	if (snapshot.sceneryVersion != gameState.sceneryVersion) {
+		copyObjectList(gameObjects.palmTrees, snapshot.palmTrees);
+		copyObjectList(gameObjects.scatteredFerns, snapshot.scatteredFerns);
+		copyObjectList(gameObjects.scatteredStones, snapshot.scatteredStones);
+		copyObjectList(gameObjects.scatteredRocks, snapshot.scatteredRocks);
+		snapshot.sceneryVersion = gameState.sceneryVersion;
+	}
 
-	glEnable(GL_STENCIL_TEST);
-	glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
+	copyObjectList(gameObjects.targets, snapshot.targets);
+	copyEntities(gameObjects.missiles, snapshot.missiles);
+	copyObjectList(gameObjects.explosions, snapshot.explosions);
 
-	glStencilFunc(GL_ALWAYS, 2, 0xFF);
-	drawFern(gameObjects.fern1, viewMatrix, projectionMatrix);
-	glDisable(GL_STENCIL_TEST);
+	renderSnapshots.publish();
+}
 
-	glEnable(GL_STENCIL_TEST);
-	glStencilFunc(GL_ALWAYS, 3, 0xFF);
-	drawFern(gameObjects.fern2, viewMatrix, projectionMatrix);
-	glDisable(GL_STENCIL_TEST);
+// Runs the fixed steps of the scene update on its own thread, the drawing never waits for it.
+void simulationLoop(void) {
 
-	glEnable(GL_STENCIL_TEST); 
-	glStencilFunc(GL_ALWAYS, 4, 0xFF);
-	drawFern(gameObjects.fern3, viewMatrix, projectionMatrix);
-	glDisable(GL_STENCIL_TEST);
+	std::chrono::steady_clock::duration timestep = std::chrono::milliseconds(SIMULATION_TIMESTEP_MS);
+	std::chrono::steady_clock::time_point nextStep = std::chrono::steady_clock::now();
 
-	glEnable(GL_STENCIL_TEST);
-	glStencilFunc(GL_ALWAYS, 5, 0xFF);
-	drawFern(gameObjects.fern4, viewMatrix, projectionMatrix);
-	glDisable(GL_STENCIL_TEST);
+	while (simulationRunning.load()) {
+		nextStep += timestep;
+		std::this_thread::sleep_until(nextStep);
 
-	CHECK_GL_ERROR();
+		if (simulationStep() == false) {
+			simulationFinished.store(true);
+			return;
+		}
+		publishSnapshot();
 
-	// draw missiles
-	for (GameObjectsList::iterator it = gameObjects.missiles.begin(); it != gameObjects.missiles.end(); ++it) {
-		MissileObject* missile = (MissileObject *)(*it);
-		drawMissile(missile, viewMatrix, projectionMatrix);
+		// more than one step behind (a stall, a debugger) - continue from now instead of catching up
+		if (std::chrono::steady_clock::now() - nextStep > timestep)
+			nextStep = std::chrono::steady_clock::now();
 	}
+}
 
-	// draw skybox
-	drawSkybox(viewMatrix, projectionMatrix);
+void startSimulationThread(void) {
+	simulationRunning.store(true);
+	simulationThread = std::thread(simulationLoop);
+}
 
-	// draw explosions with depth test disabled
-	glDisable(GL_DEPTH_TEST);
+void stopSimulationThread(void) {
+	simulationRunning.store(false);
+	if (simulationThread.joinable())
+		simulationThread.join();
+}
 
-	for (GameObjectsList::iterator it = gameObjects.explosions.begin(); it != gameObjects.explosions.end(); ++it) {
-		ExplosionObject* explosion = (ExplosionObject *)(*it);
-		drawExplosion(explosion, viewMatrix, projectionMatrix);
-	}
-	glEnable(GL_DEPTH_TEST);
+void passiveMouseMotionCallback(int mouseX, int mouseY);
 
-	if (gameState.gameOver == true) {
-		// draw game over banner
-		if (gameObjects.bannerObject != NULL)
-			drawBanner(gameObjects.bannerObject, orthoTopViewMatrix, orthoProjectionMatrix);
+// Switches the mouse look on in the first person view - GLUT is only called from the window thread.
+void updateMouseLook(int cameraState) {
+
+	static bool mouseLook = false;
+	bool wanted = (cameraState == 1 && gameState.windowless == false && isReplaying() == false);
+
+	if (wanted == mouseLook)
+		return;
+	mouseLook = wanted;
+
+	if (mouseLook) {
+		glutPassiveMotionFunc(passiveMouseMotionCallback);
+		glutWarpPointer(gameState.windowWidth / 2, gameState.windowHeight / 2);
+	}
+	else {
+		glutPassiveMotionFunc(NULL);
 	}
 }
 
-// END OF DRAWWINDOWCONTENTS FUNCTION
+// END OF SIMULATION THREAD FUNCTIONS
 //----------------------------------------------------------------------------------------
 
 //----------------------------------------------------------------------------------------
@@ -836,14 +1050,25 @@ void drawWindowContents() {
 // Called to update the display. You should call glutSwapBuffers after all of your
 // rendering to display what you rendered.
 void displayCallback() {
+
+	// the newest finished simulation step - the last one is drawn again if the simulation did not finish another
+	renderSnapshots.update();
+	const RenderSnapshot& snapshot = renderSnapshots.readBuffer();
+
+	updateMouseLook(snapshot.cameraState);
+
 	GLbitfield mask = GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT;
 	mask |= GL_STENCIL_BUFFER_BIT;
 
 	glClear(mask);
 
-	drawWindowContents();
+	drawWindowContents(snapshot);
 
-	glutSwapBuffers();
+	// screenshot or video frame, read a few frames later without waiting for the GPU
+	captureFrame(gameState.windowWidth, gameState.windowHeight);
+
+	if (gameState.windowless == false)
+		glutSwapBuffers();
 }
 
 // Called whenever the window is resized. The new window size is given, in pixels.
@@ -888,6 +1113,59 @@ void checkCollisions(void) {
 	
 }
 
+// Sweeps the missiles over this step against the targets and the scenery (projectiles.h).
+// The hit targets are removed, every hit inserts an explosion where the missile touched.
+void collideMissiles(float elapsedTime) {
+
+	// rebuilt every step from a few tens of spheres - the targets are removed when hit
+	SphereGrid& colliders = gameObjects.colliders;
+	clearSphereGrid(colliders);
+	gameObjects.colliderTargets.clear();
+
+	const GameObjectsList* lists[] = { &gameObjects.targets, &gameObjects.palmTrees, &gameObjects.scatteredStones, &gameObjects.scatteredRocks };
+	const unsigned int categories[] = { COLLIDER_TARGET, COLLIDER_PALM_TREE, COLLIDER_STONE, COLLIDER_ROCK };
+
+	for (int list = 0; list < 4; list++) {
+		unsigned int index = 0;
+		for (GameObjectsList::const_iterator it = lists[list]->begin(); it != lists[list]->end(); ++it, ++index) {
+			const Object* object = (const Object*)(*it);
+			if (object->destroyed == true)
+				continue;
+
+			// the hit targets are found by their ids, the scenery is not changed by the hits
+			if (categories[list] == COLLIDER_TARGET) {
+				addGridSphere(colliders, object->position, object->size, COLLIDER_ID(COLLIDER_TARGET, gameObjects.colliderTargets.size()));
+				gameObjects.colliderTargets.push_back((TargetObject*)(*it));
+			}
+			else {
+				addGridSphere(colliders, object->position, object->size, COLLIDER_ID(categories[list], index));
+			}
+		}
+	}
+	buildSphereGrid(colliders);
+
+	std::vector<ProjectileHit> hits;
+	sweepProjectiles(gameObjects.missiles, colliders, elapsedTime, hits);
+
+	for (size_t i = 0; i < hits.size(); i++) {
+		if (COLLIDER_CATEGORY(hits[i].colliderId) == COLLIDER_TARGET)
+			gameObjects.colliderTargets[COLLIDER_INDEX(hits[i].colliderId)]->destroyed = true;
+		insertExplosion(hits[i].position);
+	}
+
+	// remove the hit targets
+	GameObjectsList::iterator it = gameObjects.targets.begin();
+	while (it != gameObjects.targets.end()) {
+		if (((TargetObject*)(*it))->destroyed == true) {
+			delete (TargetObject*)(*it);
+			it = gameObjects.targets.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+}
+
 void updateObjects(float elapsedTime) {
 
 	// update penguin 
@@ -897,30 +1175,10 @@ void updateObjects(float elapsedTime) {
 	// check the new position and wrap it if it is necessary
 	gameObjects.penguin->position = checkBounds(gameObjects.penguin->position, gameObjects.penguin->size);
 
-	// update missiles
-	GameObjectsList::iterator it = gameObjects.missiles.begin();
-	while (it != gameObjects.missiles.end()) {
-		MissileObject* missile = (MissileObject*)(*it);
-
-		// update missile
-		float timeDelta = elapsedTime - missile->currentTime;
+	// update missiles - swept against the colliders before they move, the hit ones are removed
+	collideMissiles(elapsedTime);
+	updateMissileEntities(gameObjects.missiles, elapsedTime);
 
-		missile->currentTime = elapsedTime;
-		missile->position += timeDelta * missile->speed * missile->direction;
-
-		// check the new position and wrap it if it is necessary
-		missile->position = checkBounds(missile->position, missile->size);
-
-		if ((missile->currentTime - missile->startTime)*missile->speed > MISSILE_MAX_DISTANCE)
-			missile->destroyed = true;
-
-		if (missile->destroyed == true) {
-			it = gameObjects.missiles.erase(it);
-		}
-		else {
-			++it;
-		}
-	}
 	// update ufos
 	// it = gameObjects.ufos.begin();
 	// while (it != gameObjects.ufos.end()) {
@@ -946,57 +1204,104 @@ void updateObjects(float elapsedTime) {
 	// }
 	
 	// update explosion billboards
-	it = gameObjects.explosions.begin();
-	while (it != gameObjects.explosions.end()) {
-		ExplosionObject* explosion = (ExplosionObject*)(*it);
+	updateExplosionsParallel(gameObjects.explosions, elapsedTime);
 
-		// update explosion
-		explosion->currentTime = elapsedTime;
+	
+}
 
-		if (explosion->currentTime > explosion->startTime + explosion->textureFrames*explosion->frameDuration)
-			explosion->destroyed = true;
+// Marks a key pressed at the arrival of the applied input event.
+void pressKey(int key) {
+	if (gameState.keyMap[key] == false) {
+		gameState.keyMap[key] = true;
+		gameState.keyPressTime[key] = gameState.inputTime;
+	}
+}
 
-		if (explosion->destroyed == true) {
-			it = gameObjects.explosions.erase(it);
-		}
-		else {
-			++it;
-		}
+// Marks a key released at the arrival of the applied input event, the time it was held is kept.
+void releaseKey(int key) {
+	if (gameState.keyMap[key] == true) {
+		gameState.keyMap[key] = false;
+		gameState.keyHeldTime[key] += std::max(gameState.inputTime - gameState.keyPressTime[key], 0.0f);
 	}
+}
 
-	
+// Part of the step a key was held (0 ... 1), a press shorter than the step counts as well.
+// Starts the next step - the keys still pressed count from its start.
+float takeKeyHeldTime(int key) {
+	float held = gameState.keyHeldTime[key];
+	if (gameState.keyMap[key] == true)
+		held += 1.0f - gameState.keyPressTime[key];
+
+	gameState.keyPressTime[key] = 0.0f;
+	gameState.keyHeldTime[key] = 0.0f;
+	return held;
 }
 
-// Callback responsible for the scene update
-void timerCallback(int) {
+// wall clock time the replay was started at, used to report the run time
+std::chrono::steady_clock::time_point replayStartTime;
 
-	// update scene time
-	gameState.elapsedTime = 0.001f * (float)glutGet(GLUT_ELAPSED_TIME); // milliseconds => seconds
+void applyInputEvent(const InputEvent& event);
 
-	// call appropriate actions according to the currently pressed keys in key map
-	// (combinations of keys are supported but not used in this implementation)
-	if (gameState.keyMap[KEY_D] == true) 
-		turnBirdRight(PENGUIN_VIEW_ANGLE_DELTA);
-	
-	if (gameState.keyMap[KEY_A] == true) 
-		turnBirdLeft(PENGUIN_VIEW_ANGLE_DELTA);
-	
-	if (gameState.keyMap[KEY_W] == true) {
-		 moveBirdForward();
-	}
-	if (gameState.keyMap[KEY_S] == true) {
-		 moveBirdBackward();
+// Prints the length of the replayed run and quits the application.
+void finishReplay(void) {
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - replayStartTime).count();
+
+	std::cout << "Replay finished: " << gameState.tick << " ticks in " << seconds << " s ("
+		<< 1000.0 * seconds / std::max(gameState.tick, 1u) << " ms per tick)" << std::endl;
+
+	stopReplay();
+}
+
+// One fixed step of the scene update. Returns false when the replay is over.
+bool simulationStep(void) {
+
+	// the input which arrived during the last step - recorded with the tick it is applied in
+	// and the time within the step, the keys are held for the same part of the step in the replay
+	InputEvent event;
+	if (isReplaying()) {
+		while (nextReplayEvent(gameState.tick, event))
+			applyInputEvent(event);
+
+		if (replayFinished(gameState.tick)) {
+			finishReplay();
+			return false;
+		}
 	}
-	if (gameState.keyMap[KEY_UP_ARROW] == true)
-		increaseBirdSpeed();
-	if (gameState.keyMap[KEY_DOWN_ARROW] == true)
-		decreaseBirdSpeed();
-	if (gameState.keyMap[KEY_Q] == true) {
-		increaseBirdHeight();
+	else {
+		closeInputStep();
+		while (nextQueuedInputEvent(event)) {
+			event.tick = gameState.tick;
+			recordInputEvent(event);
+			applyInputEvent(event);
+		}
 	}
-	if (gameState.keyMap[KEY_E] == true)
-		decreaseBirdHeight();
-	
+
+	// update scene time - fixed step, independent of the wall clock
+	gameState.tick++;
+	gameState.elapsedTime = gameState.tick * SIMULATION_TIMESTEP;
+
+	// move by the part of the step the keys were held - a short press moves a bit, a held key
+	// moves by the full increments (combinations of keys are supported but not used)
+	float keyHeld[KEYS_COUNT];
+	for (int key = 0; key < KEYS_COUNT; key++)
+		keyHeld[key] = takeKeyHeldTime(key);
+
+	if (keyHeld[KEY_D] > 0.0f)
+		turnBirdRight(keyHeld[KEY_D] * PENGUIN_VIEW_ANGLE_DELTA);
+	if (keyHeld[KEY_A] > 0.0f)
+		turnBirdLeft(keyHeld[KEY_A] * PENGUIN_VIEW_ANGLE_DELTA);
+	if (keyHeld[KEY_W] > 0.0f)
+		moveBirdForward(keyHeld[KEY_W] * PENGUIN_LENGTH_INCREMENT);
+	if (keyHeld[KEY_S] > 0.0f)
+		moveBirdBackward(keyHeld[KEY_S] * PENGUIN_LENGTH_INCREMENT);
+	if (keyHeld[KEY_UP_ARROW] > 0.0f)
+		increaseBirdSpeed(keyHeld[KEY_UP_ARROW] * PENGUIN_SPEED_INCREMENT);
+	if (keyHeld[KEY_DOWN_ARROW] > 0.0f)
+		decreaseBirdSpeed(keyHeld[KEY_DOWN_ARROW] * PENGUIN_SPEED_INCREMENT);
+	if (keyHeld[KEY_Q] > 0.0f)
+		increaseBirdHeight(keyHeld[KEY_Q] * PENGUIN_LENGTH_INCREMENT);
+	if (keyHeld[KEY_E] > 0.0f)
+		decreaseBirdHeight(keyHeld[KEY_E] * PENGUIN_LENGTH_INCREMENT);
 
 	// if (gameState.keyMap[KEY_EXPLODE1] == true){
 	// 	GameObjectsList::iterator it = gameObjects.aircraft.begin();
@@ -1009,22 +1314,15 @@ void timerCallback(int) {
 		gameObjects.bannerObject->currentTime = gameState.elapsedTime;
 	}
 
-	//update sparrow
-	gameObjects.sparrow->currentAngle = fmod((gameObjects.sparrow->currentAngle + 5.0f) , 360.0f);
-	float rad_angle = glm::radians(gameObjects.sparrow->currentAngle);
-	gameObjects.sparrow->position = glm::vec3(0.5f * sin(rad_angle), 0.5f * cos(rad_angle), 0.5f);
-	
-	gameObjects.sparrow->currentTime = gameState.elapsedTime;
-
-	// Check the new position and wrap it if necessary
-	gameObjects.sparrow->position = checkBounds(gameObjects.sparrow->position, gameObjects.sparrow->size);
+	// update sparrows - the flock keeps itself within the scene
+	updateFlock(gameObjects.sparrows, gameState.elapsedTime);
 
 	// update objects in the scene
 	updateObjects(gameState.elapsedTime);
 
 
-	// space pressed -> launch missile
-	if (gameState.keyMap[KEY_SPACE] == true) {
+	// space pressed in this step, even shortly -> launch missile
+	if (keyHeld[KEY_SPACE] > 0.0f) {
 		// missile position and direction
 		glm::vec3 missilePosition = gameObjects.penguin->position;
 		glm::vec3 missileDirection = gameObjects.penguin->direction;
@@ -1059,21 +1357,47 @@ void timerCallback(int) {
 		}
 	}
 
+	return true;
+}
+
+// Callback responsible for the redrawing - the scene is updated by the simulation thread
+void timerCallback(int) {
+
+	if (simulationFinished.load()) {
+		glutLeaveMainLoop();
+		return;
+	}
+
 	// set timeCallback next invocation
-	glutTimerFunc(33, timerCallback, 0);
+	glutTimerFunc(SIMULATION_TIMESTEP_MS, timerCallback, 0);
 
 	glutPostRedisplay();
 }
 
+// Live input is handed to the simulation thread, which records and applies it.
+// It is ignored when a recording is replayed.
+void queueLiveInput(int type, int key, int x = 0, int y = 0) {
+	if (isReplaying() == false)
+		queueInputEvent(type, key, x, y);
+}
+
+// Tilts the first person camera by the mouse movement (pixels, up is positive).
+void handleCameraTilt(int offset) {
+
+	float cameraElevationAngleDelta = 0.5f * offset;
+
+	if (fabs(gameState.cameraElevationAngle + cameraElevationAngleDelta) < CAMERA_ELEVATION_MAX)
+		gameState.cameraElevationAngle += cameraElevationAngleDelta;
+}
+
 // Called when mouse is moving while no mouse buttons are pressed.
 void passiveMouseMotionCallback(int mouseX, int mouseY) {
 
 	if (mouseY != gameState.windowHeight / 2) {
 
-		float cameraElevationAngleDelta = 0.5f * (gameState.windowHeight - mouseY - gameState.windowHeight / 2);
+		int offset = gameState.windowHeight - mouseY - gameState.windowHeight / 2;
 
-		if (fabs(gameState.cameraElevationAngle + cameraElevationAngleDelta) < CAMERA_ELEVATION_MAX)
-			gameState.cameraElevationAngle += cameraElevationAngleDelta;
+		queueLiveInput(INPUT_CAMERA_TILT, 0, 0, offset);
 
 		// set mouse pointer to the window center
 		glutWarpPointer(gameState.windowWidth / 2, gameState.windowHeight / 2);
@@ -1082,40 +1406,34 @@ void passiveMouseMotionCallback(int mouseX, int mouseY) {
 	}
 }
 
-// Called whenever a key on the keyboard was pressed. The key is given by the "keyPressed"
-// parameter, which is in ASCII. It's often a good idea to have the escape key (ASCII value 27)
-// to call glutLeaveMainLoop() to exit the program.
-void keyboardCallback(unsigned char keyPressed, int mouseX, int mouseY) {
+void handleKeyDown(unsigned char keyPressed) {
 
 	switch (keyPressed) {
 	case 'w':
-		gameState.keyMap[KEY_W] = true;
+		pressKey(KEY_W);
 		break;
 	case 'a':
-		gameState.keyMap[KEY_A] = true;
+		pressKey(KEY_A);
 		break;
 	case 's':
-		gameState.keyMap[KEY_S] = true;
+		pressKey(KEY_S);
 		break;
 	case 'd':
-		gameState.keyMap[KEY_D] = true;
+		pressKey(KEY_D);
 		break;
 	case 'q':
-		gameState.keyMap[KEY_Q] = true;
+		pressKey(KEY_Q);
 		break;
 	case 'e':
-		gameState.keyMap[KEY_E] = true;
-		break;
-	case 27: // escape
-		glutLeaveMainLoop();
+		pressKey(KEY_E);
 		break;
 	case 'r': // restart game
 		restartGame();
 		break;
-	//case ' ': // launch missile
-	//	if (gameState.gameOver != true)
-	//		gameState.keyMap[KEY_SPACE] = true;
-	//	break;
+	case ' ': // launch missile
+		if (gameState.gameOver != true)
+			pressKey(KEY_SPACE);
+		break;
 	case 't': // teleport space ship
 		if (gameState.gameOver != true)
 			teleport();
@@ -1127,18 +1445,12 @@ void keyboardCallback(unsigned char keyPressed, int mouseX, int mouseY) {
 			gameState.cameraState = 2;
 		else
 			gameState.cameraState = 0;
-		if (gameState.cameraState == 1) {
-			glutPassiveMotionFunc(passiveMouseMotionCallback);
-			glutWarpPointer(gameState.windowWidth / 2, gameState.windowHeight / 2);
-		}
-		else {
-			glutPassiveMotionFunc(NULL);
-		}
+		// the mouse look follows the camera of the drawn snapshot, see updateMouseLook()
 		break;
 	case 'b': { // insert explosion randomly
 		glm::vec3 explosionPosition = glm::vec3(
-			(float)(2.0 * (rand() / (double)RAND_MAX) - 1.0),
-			(float)(2.0 * (rand() / (double)RAND_MAX) - 1.0),
+			2.0f * simulationRandom() - 1.0f,
+			2.0f * simulationRandom() - 1.0f,
 			0.0f
 			);
 		insertExplosion(explosionPosition);
@@ -1147,7 +1459,7 @@ void keyboardCallback(unsigned char keyPressed, int mouseX, int mouseY) {
 
 	case 'p': {
 		printf("point light enabled");
-		gameState.keyMap[KEY_P] = true;
+		pressKey(KEY_P);
 		if (pointEnable == 0) { pointEnable = 1; }
 		else { pointEnable = 0; }
 		std::cout << "point enable : " << pointEnable << std::endl;
@@ -1155,7 +1467,7 @@ void keyboardCallback(unsigned char keyPressed, int mouseX, int mouseY) {
 	}
 	case 'o': {
 		std::cout << "Reloading config file" << std::endl;
-		gameState.keyMap[KEY_O] = true;
+		pressKey(KEY_O);
 		reloadConfig();
 		break;
 	}
@@ -1165,38 +1477,60 @@ void keyboardCallback(unsigned char keyPressed, int mouseX, int mouseY) {
 	}
 }
 
-// Called whenever a key on the keyboard was released. The key is given by
-// the "keyReleased" parameter, which is in ASCII. 
-void keyboardUpCallback(unsigned char keyReleased, int mouseX, int mouseY) {
+// Called whenever a key on the keyboard was pressed. The key is given by the "keyPressed"
+// parameter, which is in ASCII. It's often a good idea to have the escape key (ASCII value 27)
+// to call glutLeaveMainLoop() to exit the program.
+void keyboardCallback(unsigned char keyPressed, int mouseX, int mouseY) {
+
+	// escape quits the replay as well
+	if (keyPressed == 27) {
+		glutLeaveMainLoop();
+		return;
+	}
+
+	// capture is not a part of the recorded input - it works in the replay too
+	if (keyPressed == 'g') {
+		requestScreenshot();
+		return;
+	}
+	if (keyPressed == 'v') {
+		toggleCaptureRecording();
+		return;
+	}
+
+	queueLiveInput(INPUT_KEY_DOWN, keyPressed);
+}
+
+void handleKeyUp(unsigned char keyReleased) {
 
 	switch (keyReleased) {
 	case ' ':
-		gameState.keyMap[KEY_SPACE] = false;
+		releaseKey(KEY_SPACE);
 		break;
 	case 'w':
-		gameState.keyMap[KEY_W] = false;
+		releaseKey(KEY_W);
 		break;
 	case 'a':
-		gameState.keyMap[KEY_A] = false;
+		releaseKey(KEY_A);
 		break;
 	case 's':
-		gameState.keyMap[KEY_S] = false;
+		releaseKey(KEY_S);
 		break;
 	case 'd':
-		gameState.keyMap[KEY_D] = false;
+		releaseKey(KEY_D);
 		break;
 	case 'q':
-		gameState.keyMap[KEY_Q] = false;
+		releaseKey(KEY_Q);
 		break;
 	case 'e':
-		gameState.keyMap[KEY_E] = false;
+		releaseKey(KEY_E);
 		break;
 	case 'p': {
-		gameState.keyMap[KEY_P] = false;
+		releaseKey(KEY_P);
 		break;
 	}
 	case 'o': {
-		gameState.keyMap[KEY_O] = false;
+		releaseKey(KEY_O);
 		break;
 	}
 
@@ -1205,34 +1539,39 @@ void keyboardUpCallback(unsigned char keyReleased, int mouseX, int mouseY) {
 	}
 }
 
-// The special keyboard callback is triggered when keyboard function or directional
-// keys are pressed.
-void specialKeyboardCallback(int specKeyPressed, int mouseX, int mouseY) {
+// Called whenever a key on the keyboard was released. The key is given by
+// the "keyReleased" parameter, which is in ASCII. 
+void keyboardUpCallback(unsigned char keyReleased, int mouseX, int mouseY) {
+
+	queueLiveInput(INPUT_KEY_UP, keyReleased);
+}
+
+void handleSpecialKeyDown(int specKeyPressed) {
 
 	if (gameState.gameOver == true)
 		return;
 
 	switch (specKeyPressed) {
 	case GLUT_KEY_RIGHT:
-		gameState.keyMap[KEY_RIGHT_ARROW] = true;
+		pressKey(KEY_RIGHT_ARROW);
 		break;
 	case GLUT_KEY_LEFT:
-		gameState.keyMap[KEY_LEFT_ARROW] = true;
+		pressKey(KEY_LEFT_ARROW);
 		break;
 	case GLUT_KEY_UP:
-		gameState.keyMap[KEY_UP_ARROW] = true;
+		pressKey(KEY_UP_ARROW);
 		break;
 	case GLUT_KEY_DOWN:
-		gameState.keyMap[KEY_DOWN_ARROW] = true;
+		pressKey(KEY_DOWN_ARROW);
 		break;
 	case GLUT_KEY_F2:
-		gameState.keyMap[KEY_UP_HEIGHT] = true;
+		pressKey(KEY_UP_HEIGHT);
 		break;
 	case GLUT_KEY_F1:
-		gameState.keyMap[KEY_DOWN_HEIGHT] = true;
+		pressKey(KEY_DOWN_HEIGHT);
 		break;
 	case GLUT_KEY_F7:
-		gameState.keyMap[KEY_EXPLODE1] = true;
+		pressKey(KEY_EXPLODE1);
 		break;
 	default:
 		; // printf("Unrecognized special key pressed\n");
@@ -1240,76 +1579,166 @@ void specialKeyboardCallback(int specKeyPressed, int mouseX, int mouseY) {
 }
 
 // The special keyboard callback is triggered when keyboard function or directional
-// keys are released.
-void specialKeyboardUpCallback(int specKeyReleased, int mouseX, int mouseY) {
+// keys are pressed.
+void specialKeyboardCallback(int specKeyPressed, int mouseX, int mouseY) {
+
+	queueLiveInput(INPUT_SPECIAL_DOWN, specKeyPressed);
+}
+
+void handleSpecialKeyUp(int specKeyReleased) {
 
 	if (gameState.gameOver == true)
 		return;
 
 	switch (specKeyReleased) {
 	case GLUT_KEY_RIGHT:
-		gameState.keyMap[KEY_RIGHT_ARROW] = false;
+		releaseKey(KEY_RIGHT_ARROW);
 		break;
 	case GLUT_KEY_LEFT:
-		gameState.keyMap[KEY_LEFT_ARROW] = false;
+		releaseKey(KEY_LEFT_ARROW);
 		break;
 	case GLUT_KEY_UP:
-		gameState.keyMap[KEY_UP_ARROW] = false;
+		releaseKey(KEY_UP_ARROW);
 		break;
 	case GLUT_KEY_DOWN:
-		gameState.keyMap[KEY_DOWN_ARROW] = false;
+		releaseKey(KEY_DOWN_ARROW);
 		break;
 	case GLUT_KEY_F2:
-		gameState.keyMap[KEY_UP_HEIGHT] = false;
+		releaseKey(KEY_UP_HEIGHT);
 		break;
 	case GLUT_KEY_F1:
-		gameState.keyMap[KEY_DOWN_HEIGHT] = false;
+		releaseKey(KEY_DOWN_HEIGHT);
 		break;
 	case GLUT_KEY_F7:
-		gameState.keyMap[KEY_EXPLODE1] = false;
+		releaseKey(KEY_EXPLODE1);
 		break;
 	default:
 		; // printf("Unrecognized special key released\n");
 	}
 }
 
+// The special keyboard callback is triggered when keyboard function or directional
+// keys are released.
+void specialKeyboardUpCallback(int specKeyReleased, int mouseX, int mouseY) {
+
+	queueLiveInput(INPUT_SPECIAL_UP, specKeyReleased);
+}
+
+// Bounding spheres of the objects which react to a click, ids made by PICK_ID().
+// Taken from the drawn snapshot - the click selects what the user sees.
+std::vector<PickTarget> collectPickTargets(const RenderSnapshot& snapshot) {
+
+	std::vector<PickTarget> targets;
+	PickTarget pickTarget;
+
+	for (size_t index = 0; index < snapshot.targets.size(); index++) {
+		const TargetObject& target = snapshot.targets[index];
+		if (target.destroyed == false) {
+			pickTarget.id = PICK_ID(PICK_TARGET, index);
+			pickTarget.center = target.position;
+			pickTarget.radius = target.size;
+			targets.push_back(pickTarget);
+		}
+	}
+
+	for (unsigned int index = 0; index < 4; index++) {
+		pickTarget.id = PICK_ID(PICK_FERN, index);
+		pickTarget.center = snapshot.ferns[index].position;
+		pickTarget.radius = snapshot.ferns[index].size;
+		targets.push_back(pickTarget);
+	}
+
+	for (size_t index = 0; index < snapshot.scatteredFerns.size(); index++) {
+		pickTarget.id = PICK_ID(PICK_SCATTERED_FERN, index);
+		pickTarget.center = snapshot.scatteredFerns[index].position;
+		pickTarget.radius = snapshot.scatteredFerns[index].size;
+		targets.push_back(pickTarget);
+	}
+
+	return targets;
+}
+
+// Reacts to a click on the object with a given id (PICK_NONE is the background).
+void handlePick(unsigned int id) {
+
+	unsigned int index = PICK_INDEX(id);
+
+	switch (PICK_CATEGORY(id)) {
+	case PICK_TARGET:
+		printf("Target object %u was clicked\n", index);
+		break;
+	case PICK_FERN: {
+		FernObject* ferns[] = { gameObjects.fern1, gameObjects.fern2, gameObjects.fern3, gameObjects.fern4 };
+		if (index < 4 && ferns[index] != NULL) {
+			printf("Fern %u object was clicked\n", index + 1);
+			insertExplosion(ferns[index]->position);
+		}
+		break;
+	}
+	case PICK_SCATTERED_FERN:
+		if (index < gameObjects.scatteredFerns.size()) {
+			GameObjectsList::iterator it = gameObjects.scatteredFerns.begin();
+			std::advance(it, index);
+			printf("Scattered fern %u was clicked\n", index);
+			insertExplosion(((FernObject*)(*it))->position);
+		}
+		break;
+	default:
+		printf("Clicked on background\n");
+	}
+}
+
 // When a user presses and releases mouse buttons in the window, each press
 // and each release generates a mouse callback.
 void mouseCallback(int buttonPressed, int buttonState, int mouseX, int mouseY) {
 
 	if ((buttonPressed == GLUT_LEFT_BUTTON) && (buttonState == GLUT_DOWN)) {
 
-		// stores value from the stencil buffer (byte)
-		unsigned char id = 0;
-		glReadPixels(mouseX, WINDOW_HEIGHT - mouseY, 1, 1, GL_STENCIL_INDEX, GL_UNSIGNED_BYTE, &id);
+		// ray through the clicked pixel against the bounding spheres - the GPU is not waited for
+		const RenderSnapshot& snapshot = renderSnapshots.readBuffer();
+		glm::mat4 viewMatrix(1.0f);
+		glm::mat4 projectionMatrix(1.0f);
+		computeCameraMatrices(snapshot, viewMatrix, projectionMatrix);
 
-		
+		Ray ray = screenPointToRay(mouseX, mouseY, gameState.windowWidth, gameState.windowHeight, viewMatrix, projectionMatrix);
+		unsigned int id = pickObject(ray, collectPickTargets(snapshot));
 
-		// the buffer was initially cleared to zeros
-		if (id == 0) {
-			// background was clicked
-			printf("Clicked on background\n");
-		}
-		else if (id == 1) {
-			printf("Target object was clicked");
-		}
-		else if (id == 2) {
-			printf("Fern 1 object was clicked");
-			insertExplosion(gameObjects.fern1->position);
-		}
-		else if (id == 3) {
-			printf("Fern 2 object was clicked");
-			insertExplosion(gameObjects.fern2->position);
-		}
-		else if (id == 4) {
-			printf("Fern 3 object was clicked");
-			insertExplosion(gameObjects.fern3->position);
-		}
-		else if (id == 5) {
-			printf("Fern 4 object was clicked");
-			insertExplosion(gameObjects.fern4->position);
-		}
+		// the picked object is recorded, not the mouse position - the replay does not depend on the window
+		queueLiveInput(INPUT_PICK, id & 0xFFFF, id >> 16);
+	}
+}
+
+void handleMenu(int menuID, int menuItemID);
+
+// Applies one recorded event the same way as the live input callbacks.
+void applyInputEvent(const InputEvent& event) {
 
+	gameState.inputTime = event.time / INPUT_STEP_FRACTION;
+
+	switch (event.type) {
+	case INPUT_KEY_DOWN:
+		handleKeyDown((unsigned char)event.key);
+		break;
+	case INPUT_KEY_UP:
+		handleKeyUp((unsigned char)event.key);
+		break;
+	case INPUT_SPECIAL_DOWN:
+		handleSpecialKeyDown(event.key);
+		break;
+	case INPUT_SPECIAL_UP:
+		handleSpecialKeyUp(event.key);
+		break;
+	case INPUT_CAMERA_TILT:
+		handleCameraTilt(event.y);
+		break;
+	case INPUT_PICK:
+		handlePick(((unsigned int)(unsigned short)event.x << 16) | event.key);
+		break;
+	case INPUT_MENU:
+		handleMenu(event.key, event.x);
+		break;
+	default:
+		;
 	}
 }
 
@@ -1319,11 +1748,26 @@ void mouseCallback(int buttonPressed, int buttonState, int mouseX, int mouseY) {
 //----------------------------------------------------------------------------------------
 // START OF MAIN APPLICATION FUNCTIONS
 
+// seed of the simulation random generator, replaced by the recorded one in the replay
+unsigned int simulationSeed = (unsigned int)time(NULL);
+
+// output of the screenshots and of the recorded video (--capture, --capture-pipe, --capture-format)
+std::string captureDirectory = "captures";
+std::string capturePipeCommand;
+int captureFormat = CAPTURE_FORMAT_PNG;
+bool captureAllFrames = false; // --offscreen records every frame
+
+// threads of the simulation update including the main one (--threads), 0 = one per core
+unsigned int jobThreadCount = 0;
+
 // Called after the window and OpenGL are initialized. Called exactly once, before the main loop.
 void initializeApplication() {
 
-	// initialize random seed
-	srand((unsigned int)time(NULL));
+	// initialize random seed - the replay uses the recorded one
+	seedSimulationRandom(simulationSeed);
+
+	// worker threads of the parallel update
+	initializeJobSystem(jobThreadCount);
 
 	// initialize OpenGL
 	glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
@@ -1334,7 +1778,7 @@ void initializeApplication() {
 
 	// initialize shaders
 	initializeShaderPrograms();
-	// create geometry for all models used
+	// create geometry for all models used and the terrain heightfield
 	initializeModels();
 
 	gameObjects.penguin = NULL;
@@ -1344,25 +1788,205 @@ void initializeApplication() {
 	testCurve(evaluateCurveSegment, evaluateCurveSegment_1stDerivative);
 
 	restartGame();
+	publishSnapshot();
+
+	initializeCapture(captureDirectory, capturePipeCommand, captureFormat);
+
+	// the replay is timed from here - loading of the models is not part of the run
+	if (isReplaying())
+		replayStartTime = std::chrono::steady_clock::now();
 }
 
 void finalizeApplication(void) {
 
+	// the simulation thread uses the objects below
+	stopSimulationThread();
+
+	stopRecording(gameState.tick);
+	cleanupCapture();
+	cleanupJobSystem();
+
 	cleanUpObjects();
+	cleanUpScenery();
 
 	delete gameObjects.penguin;
 	gameObjects.penguin = NULL;
 
 	// delete buffers - space ship, sparrow, missile, ufo, banner, and explosion
 	cleanupModels();
+	cleanupHeightfield();
 
 	// delete shaders
 	cleanupShaderPrograms();
 }
 
+#ifdef FOREST_OFFSCREEN
+// set by startOffscreen() when there is no EGL display or driver - the golden test is skipped then
+bool offscreenUnavailable = false;
+
+// Creates the offscreen context and framebuffer and initializes the application in it.
+bool startOffscreen(int width, int height) {
+
+	if (initializeOffscreenContext(pgr::OGL_VER_MAJOR, pgr::OGL_VER_MINOR) != true) {
+		offscreenUnavailable = true;
+		return false;
+	}
+
+	if (!pgr::initialize(pgr::OGL_VER_MAJOR, pgr::OGL_VER_MINOR) || initializeOffscreenFramebuffer(width, height) != true) {
+		std::cerr << "startOffscreen(): OpenGL initialization failed." << std::endl;
+		cleanupOffscreen();
+		return false;
+	}
+
+	gameState.windowless = true;
+	reshapeCallback(width, height);
+	initializeApplication();
+	return true;
+}
+
+// Draws the scene without a window, one simulation step per frame, and prints the frame times.
+// With a replay and without --frames it runs until the end of the replay.
+int runOffscreen(int width, int height, int frames) {
+
+	if (startOffscreen(width, height) != true)
+		return 1;
+
+	if (frames < 0 || (frames == 0 && isReplaying() == false))
+		frames = isReplaying() ? 0 : OFFSCREEN_DEFAULT_FRAMES;
+
+	if (captureAllFrames)
+		toggleCaptureRecording();
+
+	std::cout << "Offscreen " << width << "x" << height << " on " << getOffscreenRenderer() << std::endl;
+
+	std::vector<double> frameTimes;
+	for (int frame = 0; frames == 0 || frame < frames; frame++) {
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+		if (simulationStep() == false)
+			break;
+		publishSnapshot();
+		displayCallback();
+		glFinish(); // the frame is measured including the rasterization
+
+		frameTimes.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+	}
+
+	if (!frameTimes.empty()) {
+		std::vector<double> sorted = frameTimes;
+		std::sort(sorted.begin(), sorted.end());
+		double total = 0.0;
+		for (size_t i = 0; i < sorted.size(); i++)
+			total += sorted[i];
+
+		std::cout << "frames: " << sorted.size() << ", mean " << total / sorted.size() << " ms ("
+			<< 1000.0 * sorted.size() / total << " fps), median " << sorted[sorted.size() / 2]
+			<< " ms, p99 " << sorted[std::min(sorted.size() - 1, sorted.size() * 99 / 100)]
+			<< " ms, max " << sorted.back() << " ms" << std::endl;
+	}
+
+	finalizeApplication();
+	cleanupOffscreen();
+	return 0;
+}
+
+// Renders the scene at a fixed simulation time from every camera with every fog and light setting
+// and compares the images with the references in the directory (or replaces them with update).
+// Returns 0 if all images match, 1 on a difference or a missing reference and GOLDEN_SKIP_CODE
+// if there is no EGL display or driver to render with.
+int runGoldenImages(int width, int height, const std::string& directory, bool update) {
+
+	// the same scenery and missiles in every run
+	simulationSeed = GOLDEN_SEED;
+
+	if (startOffscreen(width, height) != true)
+		return offscreenUnavailable ? GOLDEN_SKIP_CODE : 1;
+
+	std::cout << "Golden images " << width << "x" << height << " on " << getOffscreenRenderer() << std::endl;
+
+	// the penguin fires a missile so that the explosions and missiles are on the images
+	gameState.keyMap[KEY_SPACE] = true;
+	for (unsigned int tick = 0; tick < GOLDEN_TICKS; tick++)
+		simulationStep();
+	gameState.keyMap[KEY_SPACE] = false;
+
+	const char* fogNames[] = { "off", "linear", "exp" };
+	std::vector<unsigned char> rgba;
+	int failed = 0;
+	int missing = 0;
+
+	for (int camera = 0; camera < 3; camera++) {
+		for (int fog = 0; fog < 3; fog++) {
+			for (int light = 0; light < 2; light++) {
+				gameState.cameraState = camera;
+				fogLinearToggleInput = (fog == 1);
+				fogExpToggleInput = (fog == 2);
+				pointEnable = light;
+
+				publishSnapshot();
+				displayCallback();
+				readOffscreenPixels(rgba);
+
+				Image image;
+				image.width = width;
+				image.height = height;
+				image.pixels.resize(3 * size_t(width) * height);
+				for (size_t p = 0; p < size_t(width) * height; p++) {
+					image.pixels[3 * p + 0] = rgba[4 * p + 0];
+					image.pixels[3 * p + 1] = rgba[4 * p + 1];
+					image.pixels[3 * p + 2] = rgba[4 * p + 2];
+				}
+
+				std::string name = "camera" + std::to_string(camera) + "_fog-" + fogNames[fog] + "_light" + std::to_string(light);
+				std::string fileName = directory + "/" + name + ".ppm";
+
+				if (update) {
+					if (saveImage(fileName, image) != true)
+						failed++;
+					continue;
+				}
+
+				Image reference;
+				if (loadImage(fileName, reference) != true) {
+					std::cout << name << ": FAILED, no reference" << std::endl;
+					missing++;
+					continue;
+				}
+
+				ImageDifference difference;
+				Image diffImage;
+				bool sameSize = compareImages(reference, image, GOLDEN_THRESHOLD, difference, &diffImage);
+				bool passed = sameSize && difference.differentPixels <= size_t(GOLDEN_MAX_DIFFERENT * width * height);
+
+				std::cout << name << ": " << (passed ? "ok" : "FAILED") << ", different pixels " << difference.differentPixels
+					<< ", max difference " << difference.maxDelta << std::endl;
+
+				if (passed == false) {
+					// the rendered image and the difference are stored next to the reference for the inspection
+					if (sameSize)
+						saveImage(directory + "/" + name + ".diff.ppm", diffImage);
+					saveImage(directory + "/" + name + ".actual.ppm", image);
+					failed++;
+				}
+			}
+		}
+	}
+
+	finalizeApplication();
+	cleanupOffscreen();
+
+	// a missing reference is a failure - the test must not pass without anything to compare
+	if (missing > 0)
+		std::cout << "References are missing in \"" << directory << "\", create them with --golden-update." << std::endl;
+	if (failed > 0 || missing > 0)
+		return 1;
+	return 0;
+}
+#endif
+
 // ---------------------------------------
 // START OF MENU FUNCTIONS
-void menuCamera(int menuItemID) {
+void handleMenuCamera(int menuItemID) {
 
 	switch (menuItemID) {
 	case 1: // Top View
@@ -1375,10 +1999,9 @@ void menuCamera(int menuItemID) {
 		gameState.cameraState = 2;
 		break;
 	}
-	glutPostRedisplay();
 }
 
-void menuFog(int menuItemID) {
+void handleMenuFog(int menuItemID) {
 
 	switch (menuItemID) {
 	case 1:
@@ -1398,10 +2021,9 @@ void menuFog(int menuItemID) {
 		fogExpToggleInput = false;
 		break;
 	}
-	glutPostRedisplay();
 }
 
-void menuLight(int menuItemID) { //movement of plane
+void handleMenuLight(int menuItemID) { //movement of plane
 
 	switch (menuItemID) {
 	case 0:
@@ -1411,10 +2033,9 @@ void menuLight(int menuItemID) { //movement of plane
 		pointEnable = 0;
 		break;
 	}
-	glutPostRedisplay();
 }
 
-void menu(int menuItemID) {
+void handleMenuMain(int menuItemID) {
 
 	switch (menuItemID) {
 
@@ -1426,12 +2047,126 @@ void menu(int menuItemID) {
 		break;
 	}
 }
+
+void handleMenu(int menuID, int menuItemID) {
+
+	switch (menuID) {
+	case INPUT_MENU_MAIN:
+		handleMenuMain(menuItemID);
+		break;
+	case INPUT_MENU_CAMERA:
+		handleMenuCamera(menuItemID);
+		break;
+	case INPUT_MENU_FOG:
+		handleMenuFog(menuItemID);
+		break;
+	case INPUT_MENU_LIGHT:
+		handleMenuLight(menuItemID);
+		break;
+	}
+}
+
+// menu callbacks - the choice is recorded like the keys
+void menuCamera(int menuItemID) {
+	queueLiveInput(INPUT_MENU, INPUT_MENU_CAMERA, menuItemID);
+}
+
+void menuFog(int menuItemID) {
+	queueLiveInput(INPUT_MENU, INPUT_MENU_FOG, menuItemID);
+}
+
+void menuLight(int menuItemID) {
+	queueLiveInput(INPUT_MENU, INPUT_MENU_LIGHT, menuItemID);
+}
+
+void menu(int menuItemID) {
+	queueLiveInput(INPUT_MENU, INPUT_MENU_MAIN, menuItemID);
+}
 // END OF MENU FUNCTIONS
 // ---------------------------------------
 
 
 int main(int argc, char** argv) {
 
+  // --record <file> stores the input of the run, --replay <file> runs it again
+  // --offscreen <width>x<height> draws without a window, --frames <n> number of the drawn frames
+  int offscreenWidth = 0;
+  int offscreenHeight = 0;
+  int offscreenFrames = -1;
+  // --threads <n> number of the threads updating the simulation
+  // --capture <dir>, --capture-pipe <command> and --capture-format png|ppm set the output of G and V
+  // (with --offscreen every frame is recorded)
+  // --golden <dir> compares the offscreen images with the references, --golden-update stores them
+  std::string goldenDirectory;
+  bool goldenUpdate = false;
+
+  for (int i = 1; i < argc; i++) {
+    std::string option = argv[i];
+    if (option == "--golden-update") {
+      goldenUpdate = true;
+      continue;
+    }
+    if (i + 1 >= argc)
+      break;
+
+    if (option == "--record") {
+      if (startRecording(argv[++i], simulationSeed) != true)
+        return 1;
+    }
+    else if (option == "--replay") {
+      if (startReplay(argv[++i], simulationSeed) != true)
+        return 1;
+    }
+    else if (option == "--offscreen") {
+      if (sscanf(argv[++i], "%dx%d", &offscreenWidth, &offscreenHeight) != 2 || offscreenWidth <= 0 || offscreenHeight <= 0) {
+        std::cerr << "main(): --offscreen expects <width>x<height>, e.g. 1080x1080." << std::endl;
+        return 1;
+      }
+    }
+    else if (option == "--frames") {
+      offscreenFrames = atoi(argv[++i]);
+    }
+    else if (option == "--golden") {
+      goldenDirectory = argv[++i];
+    }
+    else if (option == "--threads") {
+      jobThreadCount = (unsigned int)atoi(argv[++i]);
+    }
+    else if (option == "--capture") {
+      captureDirectory = argv[++i];
+      captureAllFrames = true;
+    }
+    else if (option == "--capture-pipe") {
+      capturePipeCommand = argv[++i];
+      captureAllFrames = true;
+    }
+    else if (option == "--capture-format") {
+      std::string format = argv[++i];
+      if (format != "png" && format != "ppm") {
+        std::cerr << "main(): --capture-format expects png or ppm." << std::endl;
+        return 1;
+      }
+      captureFormat = (format == "ppm") ? CAPTURE_FORMAT_PPM : CAPTURE_FORMAT_PNG;
+    }
+  }
+
+  if (goldenDirectory.empty() == false) {
+    if (offscreenWidth <= 0)
+      offscreenWidth = offscreenHeight = GOLDEN_SIZE;
+#ifdef FOREST_OFFSCREEN
+    return runGoldenImages(offscreenWidth, offscreenHeight, goldenDirectory, goldenUpdate);
+#endif
+  }
+
+  if (offscreenWidth > 0) {
+#ifdef FOREST_OFFSCREEN
+    return runOffscreen(offscreenWidth, offscreenHeight, offscreenFrames);
+#else
+    std::cerr << "main(): Built without the offscreen backend (EGL)." << std::endl;
+    return 1;
+#endif
+  }
+
   // initialize windowing system
   glutInit(&argc, argv);
 
@@ -1460,7 +2195,7 @@ int main(int argc, char** argv) {
 
   glutMouseFunc(mouseCallback);
 
-  glutTimerFunc(33, timerCallback, 0); // Timer callback repeats every 33 ms. In this callback, we update all objects in the scene (their pos etc)
+  glutTimerFunc(SIMULATION_TIMESTEP_MS, timerCallback, 0); // Timer callback repeats every 33 ms. In this callback, we update all objects in the scene (their pos etc)
 
   // initialize PGR framework (GL, DevIl, etc.)
   if(!pgr::initialize(pgr::OGL_VER_MAJOR, pgr::OGL_VER_MINOR))
@@ -1502,6 +2237,9 @@ int main(int argc, char** argv) {
 
   initializeApplication(); // All shaders will be laoded here
 
+  // the scene is updated on its own thread from now on, the callbacks only draw and queue the input
+  startSimulationThread();
+
 
 #ifndef __APPLE__
   glutCloseFunc(finalizeApplication);
@@ -1512,6 +2250,9 @@ int main(int argc, char** argv) {
   glutMainLoop(); // starts the main loop of the app => endless loop. 
   // When the glut library enters it, the app will wait for user input (e.g mouseclick) => the corresponding callback function is called
 
+  // left by escape or by the end of the replay
+  stopSimulationThread();
+
   return 0;
 }
 
@@ -0,0 +1,106 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    objects.h
+ * \author  Sean Phay
+ * \date    2023
+ * \brief   Objects of the scene (position, size, speed, etc.) - no OpenGL state.
+ */
+//----------------------------------------------------------------------------------------
+
+#ifndef __OBJECTS_H
+#define __OBJECTS_H
+
+#include <list>
+#include <glm/glm.hpp>
+
+// parameters of individual objects in the scene (e.g. position, size, speed, etc.)
+typedef struct _Object {
+  glm::vec3 position;
+  glm::vec3 direction;
+  float     speed;
+  float     size;
+
+  bool destroyed;
+
+  float startTime;
+  float currentTime;
+
+} Object;
+
+typedef struct TerrainObject : public Object {
+
+} TerrainObject;
+
+typedef struct PenguinObject : public Object {
+
+	float viewAngle; // in degrees
+
+} PenguinObject;
+
+typedef struct SparrowObject : public Object {
+
+	float rotationSpeed;
+	float currentAngle;
+
+} SparrowObject;
+
+typedef struct CatObject : public Object { 
+
+} CatObject;
+
+typedef struct RockObject : public Object { 
+
+} RockObject;
+
+typedef struct FernObject : public Object {
+
+} FernObject;
+
+typedef struct StoneObject : public Object { 
+
+} StoneObject;
+
+typedef struct TargetObject : public Object {
+	glm::vec3 initPosition;
+	float rotationSpeed;
+
+} TargetObject;
+
+typedef struct PalmTreeObject : public Object { 
+
+} PalmTreeObject;
+
+typedef struct CampfireObject : public Object {
+
+} CampfireObject;
+
+typedef struct BlockObject : public Object {
+
+} BlockObject;
+
+typedef struct MissileObject : public Object {
+
+} MissileObject;
+
+typedef struct UfoObject : public Object {
+
+  float     rotationSpeed;
+  glm::vec3 initPosition;
+
+} UfoObject;
+
+typedef struct ExplosionObject : public Object {
+
+  int    textureFrames;
+  float  frameDuration;
+
+} ExplosionObject;
+
+typedef struct BannerObject : public Object {
+
+} BannerObject;
+
+// list of the objects of one type, items are pointers to the *Object structures
+typedef std::list<void *> GameObjectsList;
+
+#endif // __OBJECTS_H
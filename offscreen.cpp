@@ -0,0 +1,176 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    offscreen.cpp
+ * \author  Sean Phay
+ * \date    2023
+ * \brief   OpenGL context without a window (EGL surfaceless, e.g. Mesa llvmpipe).
+ */
+//----------------------------------------------------------------------------------------
+
+#include <cstring>
+#include <iostream>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include "pgr.h"
+#include "offscreen.h"
+
+EGLDisplay offscreenDisplay = EGL_NO_DISPLAY;
+EGLContext offscreenContext = EGL_NO_CONTEXT;
+
+GLuint offscreenFramebuffer = 0;
+GLuint offscreenColorBuffer = 0;
+GLuint offscreenDepthStencilBuffer = 0;
+int offscreenWidth = 0;
+int offscreenHeight = 0;
+
+bool hasExtension(const char* extensions, const char* name) {
+  if (extensions == NULL)
+    return false;
+
+  size_t length = strlen(name);
+  for (const char* found = strstr(extensions, name); found != NULL; found = strstr(found + length, name)) {
+    bool starts = (found == extensions || found[-1] == ' ');
+    bool ends = (found[length] == ' ' || found[length] == '\0');
+    if (starts && ends)
+      return true;
+  }
+  return false;
+}
+
+bool initializeOffscreenContext(int majorVersion, int minorVersion) {
+
+  // surfaceless platform - no X server, no DRM device needed
+  const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+  if (hasExtension(clientExtensions, "EGL_MESA_platform_surfaceless")) {
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+      (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (getPlatformDisplay != NULL)
+      offscreenDisplay = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+  }
+  if (offscreenDisplay == EGL_NO_DISPLAY)
+    offscreenDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+  EGLint eglMajor = 0, eglMinor = 0;
+  if (offscreenDisplay == EGL_NO_DISPLAY || eglInitialize(offscreenDisplay, &eglMajor, &eglMinor) != EGL_TRUE) {
+    std::cerr << "initializeOffscreenContext(): Cannot initialize EGL." << std::endl;
+    return false;
+  }
+
+  if (!hasExtension(eglQueryString(offscreenDisplay, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context")) {
+    std::cerr << "initializeOffscreenContext(): EGL_KHR_surfaceless_context is not supported." << std::endl;
+    cleanupOffscreen();
+    return false;
+  }
+
+  if (eglBindAPI(EGL_OPENGL_API) != EGL_TRUE) {
+    std::cerr << "initializeOffscreenContext(): Desktop OpenGL is not supported by EGL." << std::endl;
+    cleanupOffscreen();
+    return false;
+  }
+
+  // the default surface type is a window, the surfaceless platform offers pbuffer configs only
+  const EGLint configAttributes[] = {
+    EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+    EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+    EGL_NONE
+  };
+  EGLConfig config;
+  EGLint configCount = 0;
+  if (eglChooseConfig(offscreenDisplay, configAttributes, &config, 1, &configCount) != EGL_TRUE || configCount == 0) {
+    std::cerr << "initializeOffscreenContext(): No EGL config for OpenGL." << std::endl;
+    cleanupOffscreen();
+    return false;
+  }
+
+  // the same context as requested from GLUT - forward compatible
+  const EGLint contextAttributes[] = {
+    EGL_CONTEXT_MAJOR_VERSION_KHR, majorVersion,
+    EGL_CONTEXT_MINOR_VERSION_KHR, minorVersion,
+    EGL_CONTEXT_FLAGS_KHR, EGL_CONTEXT_OPENGL_FORWARD_COMPATIBLE_BIT_KHR,
+    EGL_NONE
+  };
+  offscreenContext = eglCreateContext(offscreenDisplay, config, EGL_NO_CONTEXT, contextAttributes);
+  if (offscreenContext == EGL_NO_CONTEXT) {
+    std::cerr << "initializeOffscreenContext(): Cannot create OpenGL " << majorVersion << "." << minorVersion << " context." << std::endl;
+    cleanupOffscreen();
+    return false;
+  }
+
+  if (eglMakeCurrent(offscreenDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, offscreenContext) != EGL_TRUE) {
+    std::cerr << "initializeOffscreenContext(): Cannot make the context current." << std::endl;
+    cleanupOffscreen();
+    return false;
+  }
+
+  return true;
+}
+
+bool initializeOffscreenFramebuffer(int width, int height) {
+
+  offscreenWidth = width;
+  offscreenHeight = height;
+
+  glGenRenderbuffers(1, &offscreenColorBuffer);
+  glBindRenderbuffer(GL_RENDERBUFFER, offscreenColorBuffer);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+  // stencil is used for picking of the objects
+  glGenRenderbuffers(1, &offscreenDepthStencilBuffer);
+  glBindRenderbuffer(GL_RENDERBUFFER, offscreenDepthStencilBuffer);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+  glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+  glGenFramebuffers(1, &offscreenFramebuffer);
+  glBindFramebuffer(GL_FRAMEBUFFER, offscreenFramebuffer);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, offscreenColorBuffer);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, offscreenDepthStencilBuffer);
+
+  if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+    std::cerr << "initializeOffscreenFramebuffer(): Framebuffer " << width << "x" << height << " is not complete." << std::endl;
+    return false;
+  }
+
+  // stays bound - the scene is drawn into it instead of the window
+  glViewport(0, 0, width, height);
+  return true;
+}
+
+void readOffscreenPixels(std::vector<unsigned char>& pixels) {
+
+  const size_t rowBytes = 4 * size_t(offscreenWidth);
+  std::vector<unsigned char> flipped(rowBytes * offscreenHeight);
+
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, offscreenFramebuffer);
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glReadPixels(0, 0, offscreenWidth, offscreenHeight, GL_RGBA, GL_UNSIGNED_BYTE, flipped.data());
+
+  // OpenGL rows go from the bottom
+  pixels.resize(flipped.size());
+  for (int y = 0; y < offscreenHeight; y++)
+    memcpy(&pixels[y * rowBytes], &flipped[(offscreenHeight - 1 - y) * rowBytes], rowBytes);
+}
+
+std::string getOffscreenRenderer() {
+  const GLubyte* renderer = glGetString(GL_RENDERER);
+  return renderer != NULL ? std::string((const char*)renderer) : std::string("unknown");
+}
+
+void cleanupOffscreen() {
+
+  if (offscreenContext != EGL_NO_CONTEXT) {
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &offscreenFramebuffer);
+    glDeleteRenderbuffers(1, &offscreenColorBuffer);
+    glDeleteRenderbuffers(1, &offscreenDepthStencilBuffer);
+    offscreenFramebuffer = offscreenColorBuffer = offscreenDepthStencilBuffer = 0;
+
+    eglMakeCurrent(offscreenDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(offscreenDisplay, offscreenContext);
+    offscreenContext = EGL_NO_CONTEXT;
+  }
+
+  if (offscreenDisplay != EGL_NO_DISPLAY) {
+    eglTerminate(offscreenDisplay);
+    offscreenDisplay = EGL_NO_DISPLAY;
+  }
+}
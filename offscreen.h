@@ -0,0 +1,54 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    offscreen.h
+ * \author  Sean Phay
+ * \date    2023
+ * \brief   OpenGL context without a window (EGL surfaceless, e.g. Mesa llvmpipe).
+ */
+//----------------------------------------------------------------------------------------
+
+#ifndef __OFFSCREEN_H
+#define __OFFSCREEN_H
+
+#include <string>
+#include <vector>
+
+//**************************************************************************************************
+/// Creates an OpenGL context which is not bound to any window and makes it current.
+/**
+ Uses the EGL surfaceless platform, so it needs neither a display server nor a GPU
+ (Mesa falls back to llvmpipe). Set LIBGL_ALWAYS_SOFTWARE=1 to force the software rasterizer.
+ Replaces glutInit() + glutCreateWindow(), pgr::initialize() is called after it as usual.
+
+ \param[in]  majorVersion  Required OpenGL version (pgr::OGL_VER_MAJOR).
+ \param[in]  minorVersion
+ \return                   True if the context is current.
+*/
+bool initializeOffscreenContext(int majorVersion, int minorVersion);
+
+//**************************************************************************************************
+/// Creates the framebuffer the scene is drawn into and binds it.
+/**
+ The framebuffer has the same buffers as the GLUT window (RGBA, depth and stencil).
+ Must be called after pgr::initialize() (needs the OpenGL functions).
+
+ \param[in]  width       Width in pixels.
+ \param[in]  height      Height in pixels.
+ \return                 True if the framebuffer is complete.
+*/
+bool initializeOffscreenFramebuffer(int width, int height);
+
+//**************************************************************************************************
+/// Reads the color buffer of the offscreen framebuffer.
+/**
+ \param[out] pixels      RGBA, 4 bytes per pixel, rows from the top of the image.
+*/
+void readOffscreenPixels(std::vector<unsigned char>& pixels);
+
+/// Name of the renderer of the context (GL_RENDERER), e.g. "llvmpipe".
+std::string getOffscreenRenderer();
+
+/// Releases the framebuffer and the context.
+void cleanupOffscreen();
+
+#endif // __OFFSCREEN_H
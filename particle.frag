@@ -0,0 +1,21 @@
+#version 140
+
+uniform sampler2D texSampler; // animated texture
+
+smooth in vec2 texCoord_v;    // fragment texture coordinates
+flat in int frame_v;          // frame of the animated texture
+
+out vec4 color_f;             // outgoing fragment color
+
+// there are 8 frames in the row, two rows total (the same texture as explosion.frag)
+uniform ivec2 pattern = ivec2(8, 2);
+
+void main() {
+
+  vec2 offset = vec2(1.0) / vec2(pattern);
+
+  vec2 texCoordBase = texCoord_v / vec2(pattern);
+  vec2 texCoord = texCoordBase + vec2(frame_v % pattern.x, frame_v / pattern.x) * offset;
+
+  color_f = texture(texSampler, texCoord);
+}
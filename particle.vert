@@ -0,0 +1,36 @@
+#version 140
+
+uniform mat4 PVmatrix;          // Projection * View --> world to clip coordinates
+uniform vec3 cameraRight;       // billboard axes (world coordinates)
+uniform vec3 cameraUp;
+uniform float time;             // current time in seconds
+uniform samplerBuffer particles; // 3 texels per particle, see particle_update.vert
+
+in vec3 position;               // corner of the unit quad
+in vec2 texCoord;               // texture coordinates of the corner
+
+smooth out vec2 texCoord_v;     // outgoing vertex texture coordinates
+flat out int frame_v;           // frame of the animated texture
+
+void main() {
+
+  vec4 positionSize  = texelFetch(particles, 3 * gl_InstanceID + 0);
+  vec4 velocityStart = texelFetch(particles, 3 * gl_InstanceID + 1);
+  vec4 lifeFrames    = texelFetch(particles, 3 * gl_InstanceID + 2);
+
+  float age = time - velocityStart.w;
+  texCoord_v = texCoord;
+
+  // dead particle => all corners at one point outside the clip volume
+  if (age < 0.0 || age >= lifeFrames.x) {
+    gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+    frame_v = 0;
+    return;
+  }
+
+  // camera facing quad - the same billboard as the explosions
+  vec3 corner = positionSize.xyz + positionSize.w * (position.x * cameraRight + position.y * cameraUp);
+  gl_Position = PVmatrix * vec4(corner, 1.0);
+
+  frame_v = min(int(age / lifeFrames.y), int(lifeFrames.z) - 1);
+}
@@ -0,0 +1,32 @@
+#version 140
+
+// transform feedback pass - one vertex = one particle, nothing is rasterized
+
+uniform float time;             // current time in seconds
+uniform float deltaTime;        // time step of the simulation
+uniform vec3  gravity;          // acceleration of the sparks
+uniform float drag;             // fraction of the velocity lost per second
+
+in vec4 positionSize;           // xyz = position, w = half size of the sprite
+in vec4 velocityStart;          // xyz = velocity, w = start time
+in vec4 lifeFrames;             // x = lifetime, y = frame duration, z = number of frames
+
+out vec4 positionSize_tf;
+out vec4 velocityStart_tf;
+out vec4 lifeFrames_tf;
+
+void main() {
+
+  positionSize_tf  = positionSize;
+  velocityStart_tf = velocityStart;
+  lifeFrames_tf    = lifeFrames;
+
+  float age = time - velocityStart.w;
+
+  // only the living particles move, dead slots wait for a new spawn
+  if (age >= 0.0 && age < lifeFrames.x) {
+    vec3 velocity = velocityStart.xyz * max(0.0, 1.0 - drag * deltaTime) + gravity * deltaTime;
+    positionSize_tf.xyz  = positionSize.xyz + velocity * deltaTime;
+    velocityStart_tf.xyz = velocity;
+  }
+}
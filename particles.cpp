@@ -0,0 +1,397 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    particles.cpp
+ * \author  Sean Phay
+ * \date    2023
+ * \brief   GPU particle system - explosions and sparks simulated by transform feedback.
+ */
+//----------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include "pgr.h"
+#include "particles.h"
+#include "data.h"
+
+// ----------------------------------------------------------------------------------------
+// START OF PARTICLE DATA
+
+// one particle in the GPU buffers = 3 x vec4 (see particle_update.vert)
+const int PARTICLE_FLOATS = 12;
+
+struct ParticleUpdateProgram {
+  GLuint program;               // = 0;
+  // vertex attributes locations
+  GLint positionSizeLocation;   // = -1;
+  GLint velocityStartLocation;  // = -1;
+  GLint lifeFramesLocation;     // = -1;
+  // uniforms locations
+  GLint timeLocation;           // = -1;
+  GLint deltaTimeLocation;      // = -1;
+  GLint gravityLocation;        // = -1;
+  GLint dragLocation;           // = -1;
+} particleUpdateProgram;
+
+struct ParticleDrawProgram {
+  GLuint program;               // = 0;
+  // vertex attributes locations
+  GLint posLocation;            // = -1;
+  GLint texCoordLocation;       // = -1;
+  // uniforms locations
+  GLint PVmatrixLocation;       // = -1;
+  GLint cameraRightLocation;    // = -1;
+  GLint cameraUpLocation;       // = -1;
+  GLint timeLocation;           // = -1;
+  GLint particlesLocation;      // = -1;
+  GLint texSamplerLocation;     // = -1;
+} particleDrawProgram;
+
+struct ParticleSystem {
+  bool   initialized;
+  GLuint texture;               // sprite texture (not owned)
+
+  // ping-pong buffers: the update pass reads buffers[current] and writes the other one
+  GLuint buffers[2];
+  GLuint updateArrays[2];       // vertex arrays of the update pass, one per source buffer
+  GLuint bufferTextures[2];     // texture buffers reading the particles in the draw pass
+  int    current;
+
+  GLuint quadBuffer;            // unit quad of the sprites
+  GLuint quadArray;
+
+  int    nextSlot;              // ring cursor - slot of the next spawned particle
+  int    usedSlots;             // slots ever used => number of simulated and drawn instances
+  float  lastTime;
+
+  std::vector<float> pending;   // ring of the queued spawns, PARTICLE_CAPACITY slots of PARTICLE_FLOATS
+  size_t pendingWritten;        // spawns ever queued, the spawn number n is in the slot n % PARTICLE_CAPACITY
+  size_t pendingRead;           // spawns ever taken by updateParticles() or overwritten by newer ones
+  std::vector<float> uploading; // spawns taken from pending by the last update, in their order
+  std::mutex pendingMutex;      // spawns come from the simulation thread
+  std::mt19937 random;
+} particleSystem;
+
+// END OF PARTICLE DATA
+// ----------------------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------------------
+// START OF PARTICLE FUNCTIONS
+
+// pgr::createProgram() links right away, transform feedback varyings must be set before linking
+GLuint createTransformFeedbackProgram(const char* vertexShaderFile, const char* varyings[], int varyingsCount) {
+
+  GLuint shader = pgr::createShaderFromFile(GL_VERTEX_SHADER, vertexShaderFile);
+  if (shader == 0)
+    return 0;
+
+  GLuint program = glCreateProgram();
+  glAttachShader(program, shader);
+  glTransformFeedbackVaryings(program, varyingsCount, varyings, GL_INTERLEAVED_ATTRIBS);
+  glLinkProgram(program);
+
+  GLint status = GL_FALSE;
+  glGetProgramiv(program, GL_LINK_STATUS, &status);
+  if (status == GL_FALSE) {
+    char log[1024];
+    glGetProgramInfoLog(program, sizeof(log), NULL, log);
+    std::cerr << "Transform feedback program linking failed: " << log << std::endl;
+    pgr::deleteProgramAndShaders(program);
+    return 0;
+  }
+  return program;
+}
+
+bool initializeParticles(GLuint texture) {
+
+  particleSystem.initialized = false;
+  particleSystem.texture = texture;
+
+  // simulation program
+  const char* varyings[] = { "positionSize_tf", "velocityStart_tf", "lifeFrames_tf" };
+  particleUpdateProgram.program = createTransformFeedbackProgram("particle_update.vert", varyings, 3);
+  if (particleUpdateProgram.program == 0)
+    return false;
+
+  particleUpdateProgram.positionSizeLocation  = glGetAttribLocation(particleUpdateProgram.program, "positionSize");
+  particleUpdateProgram.velocityStartLocation = glGetAttribLocation(particleUpdateProgram.program, "velocityStart");
+  particleUpdateProgram.lifeFramesLocation    = glGetAttribLocation(particleUpdateProgram.program, "lifeFrames");
+  particleUpdateProgram.timeLocation      = glGetUniformLocation(particleUpdateProgram.program, "time");
+  particleUpdateProgram.deltaTimeLocation = glGetUniformLocation(particleUpdateProgram.program, "deltaTime");
+  particleUpdateProgram.gravityLocation   = glGetUniformLocation(particleUpdateProgram.program, "gravity");
+  particleUpdateProgram.dragLocation      = glGetUniformLocation(particleUpdateProgram.program, "drag");
+
+  // drawing program
+  std::vector<GLuint> shaderList;
+  shaderList.push_back(pgr::createShaderFromFile(GL_VERTEX_SHADER, "particle.vert"));
+  shaderList.push_back(pgr::createShaderFromFile(GL_FRAGMENT_SHADER, "particle.frag"));
+  particleDrawProgram.program = pgr::createProgram(shaderList);
+  if (particleDrawProgram.program == 0) {
+    pgr::deleteProgramAndShaders(particleUpdateProgram.program);
+    return false;
+  }
+
+  particleDrawProgram.posLocation      = glGetAttribLocation(particleDrawProgram.program, "position");
+  particleDrawProgram.texCoordLocation = glGetAttribLocation(particleDrawProgram.program, "texCoord");
+  particleDrawProgram.PVmatrixLocation    = glGetUniformLocation(particleDrawProgram.program, "PVmatrix");
+  particleDrawProgram.cameraRightLocation = glGetUniformLocation(particleDrawProgram.program, "cameraRight");
+  particleDrawProgram.cameraUpLocation    = glGetUniformLocation(particleDrawProgram.program, "cameraUp");
+  particleDrawProgram.timeLocation        = glGetUniformLocation(particleDrawProgram.program, "time");
+  particleDrawProgram.particlesLocation   = glGetUniformLocation(particleDrawProgram.program, "particles");
+  particleDrawProgram.texSamplerLocation  = glGetUniformLocation(particleDrawProgram.program, "texSampler");
+
+  // particle buffers - zero lifetime => every slot starts dead
+  std::vector<float> zeros(PARTICLE_CAPACITY * PARTICLE_FLOATS, 0.0f);
+
+  glGenBuffers(2, particleSystem.buffers);
+  glGenVertexArrays(2, particleSystem.updateArrays);
+  glGenTextures(2, particleSystem.bufferTextures);
+
+  for (int i = 0; i < 2; i++) {
+    glBindBuffer(GL_ARRAY_BUFFER, particleSystem.buffers[i]);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * zeros.size(), &zeros[0], GL_DYNAMIC_COPY);
+
+    glBindVertexArray(particleSystem.updateArrays[i]);
+    glEnableVertexAttribArray(particleUpdateProgram.positionSizeLocation);
+    glVertexAttribPointer(particleUpdateProgram.positionSizeLocation, 4, GL_FLOAT, GL_FALSE, PARTICLE_FLOATS * sizeof(float), 0);
+    glEnableVertexAttribArray(particleUpdateProgram.velocityStartLocation);
+    glVertexAttribPointer(particleUpdateProgram.velocityStartLocation, 4, GL_FLOAT, GL_FALSE, PARTICLE_FLOATS * sizeof(float), (void*)(4 * sizeof(float)));
+    glEnableVertexAttribArray(particleUpdateProgram.lifeFramesLocation);
+    glVertexAttribPointer(particleUpdateProgram.lifeFramesLocation, 4, GL_FLOAT, GL_FALSE, PARTICLE_FLOATS * sizeof(float), (void*)(8 * sizeof(float)));
+
+    glBindTexture(GL_TEXTURE_BUFFER, particleSystem.bufferTextures[i]);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, particleSystem.buffers[i]);
+  }
+  glBindTexture(GL_TEXTURE_BUFFER, 0);
+  glBindVertexArray(0);
+
+  // sprite quad - the same as the explosion billboard
+  glGenVertexArrays(1, &particleSystem.quadArray);
+  glBindVertexArray(particleSystem.quadArray);
+
+  glGenBuffers(1, &particleSystem.quadBuffer);
+  glBindBuffer(GL_ARRAY_BUFFER, particleSystem.quadBuffer);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(explosionVertexData), explosionVertexData, GL_STATIC_DRAW);
+
+  glEnableVertexAttribArray(particleDrawProgram.posLocation);
+  glVertexAttribPointer(particleDrawProgram.posLocation, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), 0);
+  glEnableVertexAttribArray(particleDrawProgram.texCoordLocation);
+  glVertexAttribPointer(particleDrawProgram.texCoordLocation, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
+
+  glBindVertexArray(0);
+  CHECK_GL_ERROR();
+
+  particleSystem.current = 0;
+  particleSystem.nextSlot = 0;
+  particleSystem.usedSlots = 0;
+  particleSystem.lastTime = -1.0f;
+  particleSystem.pending.assign(PARTICLE_CAPACITY * PARTICLE_FLOATS, 0.0f);
+  particleSystem.uploading.reserve(PARTICLE_CAPACITY * PARTICLE_FLOATS);
+  particleSystem.pendingWritten = 0;
+  particleSystem.pendingRead = 0;
+  particleSystem.random.seed(PARTICLE_SEED);
+  particleSystem.initialized = true;
+
+  return true;
+}
+
+void cleanupParticles() {
+
+  if (particleSystem.initialized == false)
+    return;
+
+  pgr::deleteProgramAndShaders(particleUpdateProgram.program);
+  pgr::deleteProgramAndShaders(particleDrawProgram.program);
+
+  glDeleteTextures(2, particleSystem.bufferTextures);
+  glDeleteVertexArrays(2, particleSystem.updateArrays);
+  glDeleteBuffers(2, particleSystem.buffers);
+  glDeleteVertexArrays(1, &particleSystem.quadArray);
+  glDeleteBuffers(1, &particleSystem.quadBuffer);
+
+  particleSystem.pending.clear();
+  particleSystem.uploading.clear();
+  particleSystem.pendingWritten = 0;
+  particleSystem.pendingRead = 0;
+  particleSystem.initialized = false;
+}
+
+bool particlesAvailable() {
+  return particleSystem.initialized;
+}
+
+void spawnParticle(const ParticleSpawn& particle) {
+
+  const float data[PARTICLE_FLOATS] = {
+    particle.position.x, particle.position.y, particle.position.z, particle.size,
+    particle.velocity.x, particle.velocity.y, particle.velocity.z, particle.startTime,
+    particle.lifetime, particle.frameDuration, float(PARTICLE_FRAMES), 0.0f
+  };
+
+  std::lock_guard<std::mutex> lock(particleSystem.pendingMutex);
+  if (particleSystem.pending.empty())
+    return;
+
+  // more spawns than slots in one frame => the newest overwrites the oldest, only the last ones would survive anyway
+  if (particleSystem.pendingWritten - particleSystem.pendingRead >= size_t(PARTICLE_CAPACITY))
+    particleSystem.pendingRead++;
+
+  size_t slot = particleSystem.pendingWritten % PARTICLE_CAPACITY;
+  std::copy(data, data + PARTICLE_FLOATS, particleSystem.pending.begin() + PARTICLE_FLOATS * slot);
+  particleSystem.pendingWritten++;
+}
+
+size_t queuedParticleCount() {
+  std::lock_guard<std::mutex> lock(particleSystem.pendingMutex);
+  return particleSystem.pendingWritten;
+}
+
+void spawnExplosionParticles(const glm::vec3& position, float size, float time) {
+
+  std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+  // the explosion itself - one animated sprite, 16 frames
+  ParticleSpawn explosion;
+  explosion.position = position;
+  explosion.velocity = glm::vec3(0.0f);
+  explosion.size = size;
+  explosion.startTime = time;
+  explosion.frameDuration = 0.1f;
+  explosion.lifetime = PARTICLE_FRAMES * explosion.frameDuration;
+  spawnParticle(explosion);
+
+  // sparks flying apart, mostly upwards
+  for (int i = 0; i < PARTICLE_SPARKS_PER_EXPLOSION; i++) {
+    float angle = 2.0f * float(M_PI) * unit(particleSystem.random);
+    float elevation = 0.2f + 0.8f * unit(particleSystem.random);
+    float speed = PARTICLE_SPARK_SPEED * (0.5f + unit(particleSystem.random));
+
+    ParticleSpawn spark;
+    spark.position = position;
+    spark.velocity = speed * glm::vec3(cos(angle) * (1.0f - elevation), sin(angle) * (1.0f - elevation), elevation);
+    spark.size = 0.1f * size;
+    spark.startTime = time;
+    spark.lifetime = 0.6f + 0.8f * unit(particleSystem.random);
+    spark.frameDuration = spark.lifetime / PARTICLE_FRAMES;
+    spawnParticle(spark);
+  }
+}
+
+void updateParticles(float time, size_t queuedUntil) {
+
+  if (particleSystem.initialized == false)
+    return;
+
+  float deltaTime = (particleSystem.lastTime < 0.0f) ? 0.0f : glm::clamp(time - particleSystem.lastTime, 0.0f, 0.1f);
+  particleSystem.lastTime = time;
+
+  GLuint source = particleSystem.buffers[particleSystem.current];
+  GLuint target = particleSystem.buffers[1 - particleSystem.current];
+
+  // take the spawns of the drawn step and the steps before it, the newer ones wait for their snapshot
+  particleSystem.uploading.clear();
+  {
+    std::lock_guard<std::mutex> lock(particleSystem.pendingMutex);
+    size_t end = std::min(queuedUntil, particleSystem.pendingWritten);
+
+    while (particleSystem.pendingRead < end) {
+      size_t slot = particleSystem.pendingRead % PARTICLE_CAPACITY;
+      size_t count = std::min(end - particleSystem.pendingRead, size_t(PARTICLE_CAPACITY) - slot);
+      particleSystem.uploading.insert(particleSystem.uploading.end(),
+        particleSystem.pending.begin() + PARTICLE_FLOATS * slot,
+        particleSystem.pending.begin() + PARTICLE_FLOATS * (slot + count));
+      particleSystem.pendingRead += count;
+    }
+  }
+
+  // new particles overwrite the oldest slots of the source buffer
+  int spawnCount = int(particleSystem.uploading.size() / PARTICLE_FLOATS);
+  if (spawnCount > 0) {
+    glBindBuffer(GL_ARRAY_BUFFER, source);
+
+    int written = 0;
+    while (written < spawnCount) {
+      int count = std::min(spawnCount - written, PARTICLE_CAPACITY - particleSystem.nextSlot);
+      glBufferSubData(GL_ARRAY_BUFFER,
+        sizeof(float) * PARTICLE_FLOATS * particleSystem.nextSlot,
+        sizeof(float) * PARTICLE_FLOATS * count,
+        &particleSystem.uploading[PARTICLE_FLOATS * written]);
+
+      particleSystem.nextSlot += count;
+      particleSystem.usedSlots = std::max(particleSystem.usedSlots, particleSystem.nextSlot);
+      if (particleSystem.nextSlot == PARTICLE_CAPACITY)
+        particleSystem.nextSlot = 0;
+      written += count;
+    }
+  }
+
+  if (particleSystem.usedSlots == 0)
+    return;
+
+  // simulation - source buffer => vertex shader => transform feedback => target buffer
+  glUseProgram(particleUpdateProgram.program);
+  glUniform1f(particleUpdateProgram.timeLocation, time);
+  glUniform1f(particleUpdateProgram.deltaTimeLocation, deltaTime);
+  glUniform3f(particleUpdateProgram.gravityLocation, 0.0f, 0.0f, -PARTICLE_GRAVITY);
+  glUniform1f(particleUpdateProgram.dragLocation, PARTICLE_DRAG);
+
+  glEnable(GL_RASTERIZER_DISCARD);
+  glBindVertexArray(particleSystem.updateArrays[particleSystem.current]);
+  glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, target);
+
+  glBeginTransformFeedback(GL_POINTS);
+  glDrawArrays(GL_POINTS, 0, particleSystem.usedSlots);
+  glEndTransformFeedback();
+
+  glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+  glBindVertexArray(0);
+  glDisable(GL_RASTERIZER_DISCARD);
+  glUseProgram(0);
+  CHECK_GL_ERROR();
+
+  // slots above usedSlots are still zero in both buffers => no copy needed
+  particleSystem.current = 1 - particleSystem.current;
+}
+
+void drawParticles(const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix, float time) {
+
+  if (particleSystem.initialized == false || particleSystem.usedSlots == 0)
+    return;
+
+  // billboard axes - rows of the view rotation, the same as in drawExplosions()
+  glm::vec3 cameraRight(viewMatrix[0][0], viewMatrix[1][0], viewMatrix[2][0]);
+  glm::vec3 cameraUp(viewMatrix[0][1], viewMatrix[1][1], viewMatrix[2][1]);
+  glm::mat4 PVmatrix = projectionMatrix * viewMatrix;
+
+  glEnable(GL_BLEND);
+  glBlendFunc(GL_ONE, GL_ONE);
+
+  glUseProgram(particleDrawProgram.program);
+  glUniformMatrix4fv(particleDrawProgram.PVmatrixLocation, 1, GL_FALSE, glm::value_ptr(PVmatrix));
+  glUniform3fv(particleDrawProgram.cameraRightLocation, 1, glm::value_ptr(cameraRight));
+  glUniform3fv(particleDrawProgram.cameraUpLocation, 1, glm::value_ptr(cameraUp));
+  glUniform1f(particleDrawProgram.timeLocation, time);
+  glUniform1i(particleDrawProgram.texSamplerLocation, 0);
+  glUniform1i(particleDrawProgram.particlesLocation, 1);
+
+  glActiveTexture(GL_TEXTURE1);
+  glBindTexture(GL_TEXTURE_BUFFER, particleSystem.bufferTextures[particleSystem.current]);
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, particleSystem.texture);
+
+  glBindVertexArray(particleSystem.quadArray);
+  glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, explosionNumQuadVertices, particleSystem.usedSlots);
+  glBindVertexArray(0);
+
+  glActiveTexture(GL_TEXTURE1);
+  glBindTexture(GL_TEXTURE_BUFFER, 0);
+  glActiveTexture(GL_TEXTURE0);
+
+  glUseProgram(0);
+  glDisable(GL_BLEND);
+  CHECK_GL_ERROR();
+}
+
+// END OF PARTICLE FUNCTIONS
+// ----------------------------------------------------------------------------------------
@@ -0,0 +1,69 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    particles.h
+ * \author  Sean Phay
+ * \date    2023
+ * \brief   GPU particle system - explosions and sparks simulated by transform feedback.
+ */
+//----------------------------------------------------------------------------------------
+
+#ifndef __PARTICLES_H
+#define __PARTICLES_H
+
+#include "render.h"
+
+// one particle to be added to the system
+typedef struct _ParticleSpawn {
+  glm::vec3 position;
+  glm::vec3 velocity;
+  float     size;           // half size of the sprite
+  float     startTime;      // seconds, the same clock as passed to updateParticles()
+  float     lifetime;       // seconds
+  float     frameDuration;  // seconds per frame of the explosion texture
+} ParticleSpawn;
+
+//**************************************************************************************************
+/// Compiles the particle shaders and allocates PARTICLE_CAPACITY particles on the GPU.
+/**
+ \param[in]  texture     Animated texture of the sprites (explosion texture, 8x2 frames).
+ \return                 False if the system cannot be used => explosions fall back to billboards.
+*/
+bool initializeParticles(GLuint texture);
+
+/// Releases the particle buffers and shaders.
+void cleanupParticles();
+
+/// True if the particle system was initialized successfully.
+bool particlesAvailable();
+
+/// Queues one particle, it is uploaded by updateParticles() (may be called from another thread).
+void spawnParticle(const ParticleSpawn& particle);
+
+/// Number of the particles ever queued - stored with the snapshot, see updateParticles().
+size_t queuedParticleCount();
+
+/// Queues an explosion - one animated sprite and PARTICLE_SPARKS_PER_EXPLOSION sparks flying apart.
+void spawnExplosionParticles(const glm::vec3& position, float size, float time);
+
+//**************************************************************************************************
+/// Uploads the queued particles and advances the simulation on the GPU (transform feedback pass).
+/**
+ Particles live in a ring of slots, a new particle takes the slot of the oldest one. Only the
+ particles queued before the drawn snapshot was published are uploaded, the ones spawned by
+ later simulation steps wait, so no particle starts after the time it is drawn at.
+
+ \param[in]  time        Time of the drawn snapshot in seconds.
+ \param[in]  queuedUntil queuedParticleCount() when the drawn snapshot was published.
+*/
+void updateParticles(float time, size_t queuedUntil);
+
+//**************************************************************************************************
+/// Draws all live particles by one instanced, additively blended draw call.
+/**
+ \param[in]  viewMatrix       View matrix of the camera.
+ \param[in]  projectionMatrix Projection matrix of the camera.
+ \param[in]  time             Current time in seconds.
+*/
+void drawParticles(const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix, float time);
+
+#endif // __PARTICLES_H
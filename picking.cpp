@@ -0,0 +1,59 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    picking.cpp
+ * \author  Sean Phay
+ * \date    2023
+ * \brief   Selection of the clicked object by a ray cast on the CPU (no reading of the framebuffer).
+ */
+//----------------------------------------------------------------------------------------
+
+#include <cfloat>
+#include <cmath>
+#include "picking.h"
+
+Ray screenPointToRay(int x, int y, int width, int height, const glm::mat4& view, const glm::mat4& projection) {
+
+  // center of the pixel in normalized device coordinates, y goes up
+  float ndcX = 2.0f * (x + 0.5f) / width - 1.0f;
+  float ndcY = 1.0f - 2.0f * (y + 0.5f) / height;
+
+  glm::mat4 inverseMatrix = glm::inverse(projection * view);
+  glm::vec4 nearPoint = inverseMatrix * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+  glm::vec4 farPoint = inverseMatrix * glm::vec4(ndcX, ndcY, 1.0f, 1.0f);
+
+  Ray ray;
+  ray.origin = glm::vec3(nearPoint) / nearPoint.w;
+  ray.direction = glm::normalize(glm::vec3(farPoint) / farPoint.w - ray.origin);
+  return ray;
+}
+
+float raySphereDistance(const Ray& ray, const glm::vec3& center, float radius) {
+
+  // |origin + t * direction - center| = radius, direction has unit length
+  glm::vec3 toCenter = center - ray.origin;
+  float projection = glm::dot(toCenter, ray.direction);
+  float distance2 = glm::dot(toCenter, toCenter) - projection * projection;
+  float radius2 = radius * radius;
+
+  if (distance2 > radius2)
+    return -1.0f;
+
+  // the nearer intersection - the ray starting inside the sphere misses it
+  return projection - std::sqrt(radius2 - distance2);
+}
+
+unsigned int pickObject(const Ray& ray, const std::vector<PickTarget>& targets) {
+
+  unsigned int closestId = PICK_NONE;
+  float closestDistance = FLT_MAX;
+
+  for (size_t i = 0; i < targets.size(); i++) {
+    float distance = raySphereDistance(ray, targets[i].center, targets[i].radius);
+
+    if (distance >= 0.0f && distance < closestDistance) {
+      closestDistance = distance;
+      closestId = targets[i].id;
+    }
+  }
+  return closestId;
+}
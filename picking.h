@@ -0,0 +1,64 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    picking.h
+ * \author  Sean Phay
+ * \date    2023
+ * \brief   Selection of the clicked object by a ray cast on the CPU (no reading of the framebuffer).
+ */
+//----------------------------------------------------------------------------------------
+
+#ifndef __PICKING_H
+#define __PICKING_H
+
+#include <vector>
+#include <glm/glm.hpp>
+
+// 32-bit object ids - category (one of PICK_* in data.h) in the top 8 bits, index in the rest
+#define PICK_ID(category, index) (((unsigned int)(category) << 24) | ((unsigned int)(index) & 0xFFFFFFu))
+#define PICK_CATEGORY(id)        ((unsigned int)(id) >> 24)
+#define PICK_INDEX(id)           ((unsigned int)(id) & 0xFFFFFFu)
+#define PICK_NONE                0u  // nothing was hit (the background)
+
+// half-line from the eye through a pixel
+typedef struct _Ray {
+  glm::vec3 origin;
+  glm::vec3 direction;  // unit length
+} Ray;
+
+// object which can be clicked, bounded by a sphere
+typedef struct _PickTarget {
+  unsigned int id;
+  glm::vec3    center;
+  float        radius;
+} PickTarget;
+
+//**************************************************************************************************
+/// Computes the ray going through a pixel of the window.
+/**
+ Uses the same matrices the scene is drawn with, so the ray hits what is visible under the cursor.
+
+ \param[in]  x, y        Pixel in window coordinates (GLUT - y goes from the top).
+ \param[in]  width       Window size.
+ \param[in]  height
+ \param[in]  view        View matrix of the frame.
+ \param[in]  projection  Projection matrix of the frame.
+ \return                 Ray starting at the near plane.
+*/
+Ray screenPointToRay(int x, int y, int width, int height, const glm::mat4& view, const glm::mat4& projection);
+
+/// Distance along the ray to the first intersection with a sphere, negative if there is none.
+float raySphereDistance(const Ray& ray, const glm::vec3& center, float radius);
+
+//**************************************************************************************************
+/// Finds the closest object hit by the ray.
+/**
+ Tests the bounding spheres of all objects, which costs a few nanoseconds per object and does not
+ touch the GPU. An object whose sphere contains the origin of the ray is not picked.
+
+ \param[in]  ray         Ray of the click.
+ \param[in]  targets     Objects which can be picked.
+ \return                 Id of the closest hit object or PICK_NONE.
+*/
+unsigned int pickObject(const Ray& ray, const std::vector<PickTarget>& targets);
+
+#endif // __PICKING_H
@@ -0,0 +1,281 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    projectiles.cpp
+ * \author  Sean Phay
+ * \date    2023
+ * \brief   Swept collisions of the projectiles with the targets and the scenery through a grid.
+ */
+//----------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cmath>
+#include "projectiles.h"
+#include "collision.h"
+#include "jobs.h"
+#include "data.h"
+
+// ----------------------------------------------------------------------------------------
+// START OF HELPER FUNCTIONS
+
+// no hit of a projectile in this step
+const unsigned int NO_SPHERE = 0xFFFFFFFFu;
+
+// relative distance from the scene border still taken as the border when a sweep is split
+const float WRAP_TOLERANCE = 1e-5f;
+
+// cell coordinate of a position, the positions outside the grid belong to its border cells
+static inline int gridCellCoordinate(const SphereGrid& grid, float x) {
+  int cell = int(std::floor((x - grid.gridOrigin) * grid.invCellSize));
+  return std::min(std::max(cell, 0), grid.gridSize - 1);
+}
+
+// first contact of a swept sphere with the spheres begin ... end-1 of the cell arrays
+// sweptSphereIntersection() without branches, lane by lane => the loop is vectorized
+static void sweepCellRange(
+  const float* __restrict centerX, const float* __restrict centerY, const float* __restrict centerZ,
+  const float* __restrict radii, size_t begin, size_t end,
+  const glm::vec3& start, const glm::vec3& motion, float radius,
+  float* __restrict laneFraction, unsigned int* __restrict laneEntry
+) {
+  const float a = glm::dot(motion, motion);
+  const float invA = a > 0.0f ? 1.0f / a : 0.0f;
+
+  for (size_t j = begin; j < end; j += PROJECTILE_LANES) {
+    for (size_t lane = 0; lane < PROJECTILE_LANES; lane++) {
+      // the lanes past the end are masked out (the arrays are padded, see buildSphereGrid())
+      const size_t entry = j + lane;
+      const float offsetX = start.x - centerX[entry];
+      const float offsetY = start.y - centerY[entry];
+      const float offsetZ = start.z - centerZ[entry];
+      const float reach = radius + radii[entry];
+
+      const float c = offsetX * offsetX + offsetY * offsetY + offsetZ * offsetZ - reach * reach;
+      const float b = offsetX * motion.x + offsetY * motion.y + offsetZ * motion.z;
+      const float discriminant = b * b - a * c;
+      const float t = (-b - std::sqrt(std::max(discriminant, 0.0f))) * invA;
+
+      // overlapping at the start, or approaching and touching within the step
+      const bool hit = entry < end && (c <= 0.0f || (b < 0.0f && discriminant >= 0.0f && t <= 1.0f));
+      const float fraction = c <= 0.0f ? 0.0f : t;
+      const bool closer = hit && fraction < laneFraction[lane];
+
+      laneFraction[lane] = closer ? fraction : laneFraction[lane];
+      laneEntry[lane] = closer ? (unsigned int)entry : laneEntry[lane];
+    }
+  }
+}
+
+// closest sphere hit by a sphere moving from start to start + motion, NO_SPHERE if none
+// fraction [out] part of the motion done at the contact
+static unsigned int sweepSegment(const SphereGrid& grid, const glm::vec3& start, const glm::vec3& motion, float radius, float& fraction) {
+  const glm::vec3 end = start + motion;
+
+  // cells overlapped by the bounding square of the swept sphere
+  const int minX = gridCellCoordinate(grid, std::min(start.x, end.x) - radius);
+  const int maxX = gridCellCoordinate(grid, std::max(start.x, end.x) + radius);
+  const int minY = gridCellCoordinate(grid, std::min(start.y, end.y) - radius);
+  const int maxY = gridCellCoordinate(grid, std::max(start.y, end.y) + radius);
+
+  // closest contact of every lane, a sphere listed in several cells gives the same fraction every time
+  float laneFraction[PROJECTILE_LANES];
+  unsigned int laneEntry[PROJECTILE_LANES];
+  for (size_t lane = 0; lane < PROJECTILE_LANES; lane++) {
+    laneFraction[lane] = 2.0f;
+    laneEntry[lane] = 0;
+  }
+
+  for (int cy = minY; cy <= maxY; cy++) {
+    // the cells of one row are contiguous in the arrays => one range for all of them
+    const unsigned int rowBegin = grid.cellStart[cy * grid.gridSize + minX];
+    const unsigned int rowEnd = grid.cellStart[cy * grid.gridSize + maxX + 1];
+    sweepCellRange(grid.cellCenterX.data(), grid.cellCenterY.data(), grid.cellCenterZ.data(), grid.cellRadius.data(),
+      rowBegin, rowEnd, start, motion, radius, laneFraction, laneEntry);
+  }
+
+  unsigned int sphere = NO_SPHERE;
+  fraction = 2.0f;
+  for (size_t lane = 0; lane < PROJECTILE_LANES; lane++) {
+    if (laneFraction[lane] < fraction) {
+      fraction = laneFraction[lane];
+      sphere = grid.cellSpheres[laneEntry[lane]];
+    }
+  }
+  return sphere;
+}
+
+// part of the motion from start until the sphere leaves the scene (wrapped by checkBoundsBatch()),
+// 1.0f or more when it stays inside
+static float sceneExitFraction(const glm::vec3& start, const glm::vec3& motion, float halfWidth, float halfHeight) {
+  float exit = 2.0f;
+  if (motion.x > 0.0f && start.x <= halfWidth)
+    exit = std::min(exit, (halfWidth - start.x) / motion.x);
+  if (motion.x < 0.0f && start.x >= -halfWidth)
+    exit = std::min(exit, (-halfWidth - start.x) / motion.x);
+  if (motion.y > 0.0f && start.y <= halfHeight)
+    exit = std::min(exit, (halfHeight - start.y) / motion.y);
+  if (motion.y < 0.0f && start.y >= -halfHeight)
+    exit = std::min(exit, (-halfHeight - start.y) / motion.y);
+  return exit;
+}
+
+// closest sphere hit by the projectiles begin ... end-1 in this step
+// the step is swept in pieces split where the projectile wraps to the other side of the scene
+static void sweepProjectileRange(const EntityStore& projectiles, const SphereGrid& grid, size_t begin, size_t end, float elapsedTime,
+  unsigned int* hitSphere, glm::vec3* hitPosition) {
+
+  for (size_t i = begin; i < end; i++) {
+    hitSphere[i] = NO_SPHERE;
+    if (projectiles.destroyed[i])
+      continue;
+
+    const float step = (elapsedTime - projectiles.currentTime[i]) * projectiles.speed[i];
+    const float radius = projectiles.size[i];
+    const glm::vec3 motion = step * glm::vec3(projectiles.directionX[i], projectiles.directionY[i], projectiles.directionZ[i]);
+    const float halfWidth = SCENE_WIDTH + radius;
+    const float halfHeight = SCENE_HEIGHT + radius;
+
+    glm::vec3 start(projectiles.positionX[i], projectiles.positionY[i], projectiles.positionZ[i]);
+    float remaining = 1.0f;
+
+    // one wrap per axis at most - the step is shorter than the scene, a piece may be empty at the border
+    for (int piece = 0; piece < 4 && remaining > 0.0f; piece++) {
+      const float exit = std::min(sceneExitFraction(start, motion, halfWidth, halfHeight), remaining);
+      const glm::vec3 pieceMotion = exit * motion;
+
+      float fraction;
+      hitSphere[i] = sweepSegment(grid, start, pieceMotion, radius, fraction);
+      if (hitSphere[i] != NO_SPHERE) {
+        hitPosition[i] = start + fraction * pieceMotion;
+        break;
+      }
+
+      start += pieceMotion;
+      remaining -= exit;
+      if (remaining <= 0.0f)
+        break;
+
+      // continue from the other side of the scene, where checkBoundsBatch() puts the projectile
+      // (the border reached by the piece, up to the rounding of its end)
+      if (std::fabs(start.x) >= halfWidth * (1.0f - WRAP_TOLERANCE))
+        start.x = start.x > 0.0f ? -halfWidth : halfWidth;
+      if (std::fabs(start.y) >= halfHeight * (1.0f - WRAP_TOLERANCE))
+        start.y = start.y > 0.0f ? -halfHeight : halfHeight;
+    }
+  }
+}
+
+// END OF HELPER FUNCTIONS
+// ----------------------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------------------
+// START OF SPHERE GRID FUNCTIONS
+
+void clearSphereGrid(SphereGrid& grid) {
+  grid.centerX.clear();
+  grid.centerY.clear();
+  grid.centerZ.clear();
+  grid.radius.clear();
+  grid.sphereId.clear();
+  grid.cellSpheres.clear();
+}
+
+void addGridSphere(SphereGrid& grid, const glm::vec3& center, float radius, unsigned int id) {
+  grid.centerX.push_back(center.x);
+  grid.centerY.push_back(center.y);
+  grid.centerZ.push_back(center.z);
+  grid.radius.push_back(radius);
+  grid.sphereId.push_back(id);
+}
+
+void buildSphereGrid(SphereGrid& grid) {
+
+  grid.gridSize = std::max(1, int(std::ceil(2.0f * SCENE_WIDTH / PROJECTILE_CELL_SIZE)));
+  grid.gridOrigin = -SCENE_WIDTH;
+  grid.invCellSize = 1.0f / PROJECTILE_CELL_SIZE;
+
+  const size_t cells = size_t(grid.gridSize) * grid.gridSize;
+  grid.cellStart.assign(cells + 1, 0);
+
+  // first pass - number of the spheres in every cell
+  for (size_t s = 0; s < grid.sphereId.size(); s++) {
+    const int minX = gridCellCoordinate(grid, grid.centerX[s] - grid.radius[s]);
+    const int maxX = gridCellCoordinate(grid, grid.centerX[s] + grid.radius[s]);
+    const int minY = gridCellCoordinate(grid, grid.centerY[s] - grid.radius[s]);
+    const int maxY = gridCellCoordinate(grid, grid.centerY[s] + grid.radius[s]);
+
+    for (int cy = minY; cy <= maxY; cy++)
+      for (int cx = minX; cx <= maxX; cx++)
+        grid.cellStart[cy * grid.gridSize + cx + 1]++;
+  }
+
+  for (size_t c = 0; c < cells; c++)
+    grid.cellStart[c + 1] += grid.cellStart[c];
+
+  // second pass - the spheres into their cells
+  std::vector<unsigned int> next(grid.cellStart.begin(), grid.cellStart.end() - 1);
+  grid.cellSpheres.resize(grid.cellStart[cells]);
+
+  for (size_t s = 0; s < grid.sphereId.size(); s++) {
+    const int minX = gridCellCoordinate(grid, grid.centerX[s] - grid.radius[s]);
+    const int maxX = gridCellCoordinate(grid, grid.centerX[s] + grid.radius[s]);
+    const int minY = gridCellCoordinate(grid, grid.centerY[s] - grid.radius[s]);
+    const int maxY = gridCellCoordinate(grid, grid.centerY[s] + grid.radius[s]);
+
+    for (int cy = minY; cy <= maxY; cy++)
+      for (int cx = minX; cx <= maxX; cx++)
+        grid.cellSpheres[next[cy * grid.gridSize + cx]++] = (unsigned int)s;
+  }
+
+  // copies of the spheres in the cell order - a cell is read as contiguous arrays,
+  // padded by PROJECTILE_LANES entries for the whole registers read by the tests
+  const size_t entries = grid.cellSpheres.size();
+  grid.cellCenterX.assign(entries + PROJECTILE_LANES, 0.0f);
+  grid.cellCenterY.assign(entries + PROJECTILE_LANES, 0.0f);
+  grid.cellCenterZ.assign(entries + PROJECTILE_LANES, 0.0f);
+  grid.cellRadius.assign(entries + PROJECTILE_LANES, 0.0f);
+  for (size_t k = 0; k < entries; k++) {
+    grid.cellCenterX[k] = grid.centerX[grid.cellSpheres[k]];
+    grid.cellCenterY[k] = grid.centerY[grid.cellSpheres[k]];
+    grid.cellCenterZ[k] = grid.centerZ[grid.cellSpheres[k]];
+    grid.cellRadius[k] = grid.radius[grid.cellSpheres[k]];
+  }
+}
+
+// END OF SPHERE GRID FUNCTIONS
+// ----------------------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------------------
+// START OF PROJECTILE FUNCTIONS
+
+void sweepProjectiles(EntityStore& projectiles, const SphereGrid& grid, float elapsedTime, std::vector<ProjectileHit>& hits) {
+
+  const size_t count = entityCount(projectiles);
+  hits.clear();
+
+  if (count == 0 || grid.sphereId.empty())
+    return;
+
+  std::vector<unsigned int> hitSphere(count);
+  std::vector<glm::vec3> hitPosition(count);
+
+  parallelFor(count, SIMULATION_CHUNK_SIZE, [&](size_t begin, size_t end) {
+    sweepProjectileRange(projectiles, grid, begin, end, elapsedTime, hitSphere.data(), hitPosition.data());
+  });
+
+  // serial - the hits are reported in the same order with any number of threads
+  for (size_t i = 0; i < count; i++) {
+    if (hitSphere[i] == NO_SPHERE)
+      continue;
+
+    ProjectileHit hit;
+    hit.projectile = entityHandle(projectiles, i);
+    hit.colliderId = grid.sphereId[hitSphere[i]];
+    hit.position = hitPosition[i];
+    hits.push_back(hit);
+
+    projectiles.destroyed[i] = 1;
+  }
+}
+
+// END OF PROJECTILE FUNCTIONS
+// ----------------------------------------------------------------------------------------
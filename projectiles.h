@@ -0,0 +1,77 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    projectiles.h
+ * \author  Sean Phay
+ * \date    2023
+ * \brief   Swept collisions of the projectiles with the targets and the scenery through a grid.
+ */
+//----------------------------------------------------------------------------------------
+
+#ifndef __PROJECTILES_H
+#define __PROJECTILES_H
+
+#include <vector>
+#include "entities.h"
+
+// 32-bit collider ids - category (one of COLLIDER_* in data.h) in the top 8 bits, index in the rest
+#define COLLIDER_ID(category, index) (((unsigned int)(category) << 24) | ((unsigned int)(index) & 0xFFFFFFu))
+#define COLLIDER_CATEGORY(id)        ((unsigned int)(id) >> 24)
+#define COLLIDER_INDEX(id)           ((unsigned int)(id) & 0xFFFFFFu)
+
+// spheres tested at once by a projectile - one AVX register of floats
+const size_t PROJECTILE_LANES = 8;
+
+//**************************************************************************************************
+/// Static spheres sorted into the cells of a uniform grid (the broad phase).
+/**
+ The grid covers the scene in x and y with cells of PROJECTILE_CELL_SIZE, a sphere is listed in
+ every cell its bounding square overlaps. A projectile then tests only the spheres listed in the
+ cells its step passes through instead of all of them.
+*/
+typedef struct _SphereGrid {
+  FloatArray centerX, centerY, centerZ;
+  FloatArray radius;
+  std::vector<unsigned int> sphereId;     // collider id of every sphere, given by addGridSphere()
+
+  int   gridSize;                         // cells along each side of the grid
+  float gridOrigin;                       // lower x and y of the grid
+  float invCellSize;
+  std::vector<unsigned int> cellStart;    // first entry of every cell in cellSpheres, gridSize^2 + 1 entries
+  std::vector<unsigned int> cellSpheres;  // indices of the spheres listed cell by cell
+  FloatArray cellCenterX, cellCenterY, cellCenterZ;  // the listed spheres copied in the same order,
+  FloatArray cellRadius;                             // longer by PROJECTILE_LANES unused entries
+} SphereGrid;
+
+/// Removes all spheres (the memory is kept for the next build).
+void clearSphereGrid(SphereGrid& grid);
+
+/// Adds a sphere, it is found by the tests after the next buildSphereGrid().
+void addGridSphere(SphereGrid& grid, const glm::vec3& center, float radius, unsigned int id);
+
+/// Sorts the added spheres into the cells (counting sort, two passes over the spheres).
+void buildSphereGrid(SphereGrid& grid);
+
+// first contact of a projectile with a sphere of the grid
+typedef struct _ProjectileHit {
+  EntityHandle projectile;
+  unsigned int colliderId;  // id of the hit sphere (see COLLIDER_ID())
+  glm::vec3    position;    // center of the projectile at the contact
+} ProjectileHit;
+
+//**************************************************************************************************
+/// Tests the steps of the projectiles from their current times to elapsedTime against the grid.
+/**
+ Every projectile sweeps its sphere along the segment it flies in this step (sweptSphereIntersection())
+ against the spheres in the cells of the segment, so even a fast projectile hits a thin target.
+ A projectile leaving the scene sweeps the rest of its step from the other side, where it is wrapped to.
+ The projectiles are tested in parallel chunks, the hit ones are flagged destroyed and removed by
+ the next update. Call before the projectiles are moved (updateMissileEntities()).
+
+ \param[in,out] projectiles  Projectile entities, the already flagged ones are skipped.
+ \param[in]     grid         Built grid of the spheres the projectiles hit.
+ \param[in]     elapsedTime  Simulation time at the end of the step (seconds).
+ \param[out]    hits         First contact of every hitting projectile in the order of their indices.
+*/
+void sweepProjectiles(EntityStore& projectiles, const SphereGrid& grid, float elapsedTime, std::vector<ProjectileHit>& hits);
+
+#endif // __PROJECTILES_H
@@ -0,0 +1,80 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    projectiles_test.cpp
+ * \author  Sean Phay
+ * \date    2023
+ * \brief   Checks of the swept projectile collisions (no OpenGL needed), run by ctest.
+ */
+//----------------------------------------------------------------------------------------
+
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include "entities.h"
+#include "jobs.h"
+#include "projectiles.h"
+#include "data.h"
+
+// missile flying along the x axis, one step of the given length from time 0 to time 1
+EntityStore createMissile(float x, float step) {
+  Object missile;
+  missile.position = glm::vec3(x, 0.0f, 0.0f);
+  missile.direction = glm::vec3(step < 0.0f ? -1.0f : 1.0f, 0.0f, 0.0f);
+  missile.speed = std::fabs(step);
+  missile.size = 0.01f;
+  missile.destroyed = false;
+  missile.startTime = 0.0f;
+  missile.currentTime = 0.0f;
+
+  EntityStore store;
+  createEntity(store, missile);
+  return store;
+}
+
+// one sphere on the x axis
+void buildGrid(SphereGrid& grid, float x, float radius) {
+  clearSphereGrid(grid);
+  addGridSphere(grid, glm::vec3(x, 0.0f, 0.0f), radius, 7);
+  buildSphereGrid(grid);
+}
+
+bool check(const char* name, bool passed) {
+  std::cout << name << (passed ? ": OK" : ": FAILED") << std::endl;
+  return passed;
+}
+
+int main() {
+  SphereGrid grid;
+  std::vector<ProjectileHit> hits;
+  bool passed = true;
+
+  // leaves the scene at x = SCENE_WIDTH + size after 0.06, the rest of the step goes on from the other side
+  EntityStore wrapping = createMissile(0.95f, 0.2f);
+  buildGrid(grid, -0.9f, 0.03f);
+  sweepProjectiles(wrapping, grid, 1.0f, hits);
+  passed &= check("hit after crossing the edge",
+    hits.size() == 1 && hits[0].colliderId == 7 && std::fabs(hits[0].position.x + 0.94f) < 1e-4f);
+
+  // the unwrapped segment would end at 1.15 - nothing is hit outside the scene
+  EntityStore outside = createMissile(0.95f, 0.2f);
+  buildGrid(grid, 1.12f, 0.02f);
+  sweepProjectiles(outside, grid, 1.0f, hits);
+  passed &= check("no hit past the edge", hits.empty());
+
+  // the same missile going the other way crosses the -x edge
+  EntityStore backwards = createMissile(-0.95f, -0.2f);
+  buildGrid(grid, 0.9f, 0.03f);
+  sweepProjectiles(backwards, grid, 1.0f, hits);
+  passed &= check("hit after crossing the -x edge",
+    hits.size() == 1 && std::fabs(hits[0].position.x - 0.94f) < 1e-4f);
+
+  // a step inside the scene is swept in one piece
+  EntityStore inside = createMissile(0.0f, 0.2f);
+  buildGrid(grid, 0.15f, 0.03f);
+  sweepProjectiles(inside, grid, 1.0f, hits);
+  passed &= check("hit inside the scene",
+    hits.size() == 1 && std::fabs(hits[0].position.x - 0.11f) < 1e-4f);
+
+  cleanupJobSystem();
+  return passed ? 0 : 1;
+}
@@ -8,10 +8,17 @@
 //----------------------------------------------------------------------------------------
 
 #include <iostream>
+#include <fstream>
+#include <sstream>
 #include "pgr.h"
 #include "render.h"
 #include "data.h"
 #include "spline.h"
+#include "transform.h"
+#include "terrain.h"
+#include "heightfield.h"
+#include "impostor.h"
+#include "particles.h"
 
 // ----------------------------------------------------------------------------------------
 // START OF DEFINING OBJECT GEOMETRIES + FILE PATHS + SHADER PROGRAMS
@@ -35,6 +42,15 @@ MeshGeometry* explosionGeometry = NULL;
 MeshGeometry* skyboxGeometry = NULL;
 MeshGeometry* missileGeometry = NULL;
 
+// instances of the sparrows - two RGBA texels per bird read by lighting.vert (see drawSparrows())
+GLuint sparrowInstanceBuffer = 0;
+GLuint sparrowInstanceTexture = 0;
+
+// floats per vertex of the batched explosions: center, size, start time, frame duration, texture coordinates
+const int EXPLOSION_VERTEX_FLOATS = 8;
+
+ImpostorAtlas palmTreeImpostor = { 0, 0, 0 };
+
 const char* TERRAIN_MODEL_NAME = "data/terrain/terrain.obj";
 const char* PENGUIN_MODEL_NAME = "data/goose/PenguinBaseMesh.obj";
 const char* SPARROW_MODEL_NAME = "data/sparrow/Sparrow.obj";
@@ -59,14 +75,17 @@ struct ExplosionShaderProgram {
   // identifier for the shader program
   GLuint program;              // = 0;
   // vertex attributes locations
-  GLint posLocation;           // = -1;
+  GLint centerLocation;        // = -1;
+  GLint sizeLocation;          // = -1;
+  GLint startTimeLocation;     // = -1;
+  GLint frameDurationLocation; // = -1;
   GLint texCoordLocation;      // = -1;
   // uniforms locations
-  GLint PVMmatrixLocation;     // = -1;
-  GLint VmatrixLocation;       // = -1;
+  GLint PVmatrixLocation;      // = -1;
+  GLint cameraRightLocation;   // = -1;
+  GLint cameraUpLocation;      // = -1;
   GLint timeLocation;          // = -1;
   GLint texSamplerLocation;    // = -1;
-  GLint frameDurationLocation; // = -1;
 
 } explosionShaderProgram;
 
@@ -113,69 +132,17 @@ typedef struct animationShaderProgram {
 
 // ----------------------------------------------------------------------------------------
 // START OF DEFINING OBJECT GEOMETRIES + FILE PATHS + SHADER PROGRAMS
-/// Makes a given location to be valid position inside a scene.
-/**
- Checks whether a given location \a position is valid position inside a scene.
- Valid position coordinates are always in range -(SCENE_WIDTH+objectSize)...SCENE_WIDTH+objectSize,
- -(SCENE_HEIGHT+objectSize)...SCENE_HEIGHT+objectSize, and -(SCENE_DEPTH+objectSize)...SCENE_DEPTH+objectSize.
- \param[in]  position       Position (object center) to be checked and corrected.
- \param[in]  objectSize     Size of the object which position is tested.
- \return                    Valid position inside a scene.
-*/
-glm::vec3 checkBounds(const glm::vec3 &position, float objectSize) {
- glm::vec3 newPosition = position;
-
-  // wrap a given position (object center) to be inside a scene
-  // If x is negative and goes past the negative treshold, it should reappear on the positive side on the object space
-  // and vice versa
-  // The function fmod() is useful for this: => same as % but it can handle floating point numbers
-  // /
-  // you have to take into account the objectSize parameter
-
-     float halfSceneWidth = SCENE_WIDTH + objectSize;
-     float halfSceneHeight = SCENE_HEIGHT + objectSize;
-
-     // Wrap the x-coordinate within the scene width
-     newPosition.x = fmod(newPosition.x + halfSceneWidth, 2 * halfSceneWidth) - halfSceneWidth;
-
-     if (newPosition.x < -halfSceneWidth)
-         newPosition.x += 2 * halfSceneWidth;
-
-
-     // Wrap the y-coordinate within the scene height
-     newPosition.y = fmod(newPosition.y + halfSceneHeight, 2 * halfSceneHeight) - halfSceneHeight;
-
-     if (newPosition.y < -halfSceneHeight)
-         newPosition.y += 2 * halfSceneHeight;
-
-   if( abs(newPosition.x) > (SCENE_WIDTH+objectSize) || abs(newPosition.y) > (SCENE_HEIGHT+objectSize) ) {
-     printf("Coordinates out of the window, [x, y, z] = [%f, %f, %f]\n", newPosition.x, newPosition.y, newPosition.z);
-   }
-  return newPosition;
-}
-
 void setTransformUniforms(const glm::mat4 &modelMatrix, const glm::mat4 &viewMatrix, const glm::mat4 &projectionMatrix) {
 
-  glm::mat4 PVM = projectionMatrix * viewMatrix * modelMatrix;
-  glUniformMatrix4fv(shaderProgram.PVMmatrixLocation, 1, GL_FALSE, glm::value_ptr(PVM));
+  TransformMatrices matrices;
+  computeTransformMatrices(modelMatrix, viewMatrix, projectionMatrix, matrices);
+
+  glUniformMatrix4fv(shaderProgram.PVMmatrixLocation, 1, GL_FALSE, glm::value_ptr(matrices.PVM));
 
   glUniformMatrix4fv(shaderProgram.VmatrixLocation, 1, GL_FALSE, glm::value_ptr(viewMatrix));
   glUniformMatrix4fv(shaderProgram.MmatrixLocation, 1, GL_FALSE, glm::value_ptr(modelMatrix));
 
-  // just take 3x3 rotation part of the modelMatrix
-  // we presume the last row contains 0,0,0,1
-  const glm::mat4 modelRotationMatrix = glm::mat4(
-    modelMatrix[0],
-    modelMatrix[1],
-    modelMatrix[2],
-    glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)
-  );
-  glm::mat4 normalMatrix = glm::transpose(glm::inverse(modelRotationMatrix));
-
-  //or an alternative single-line method: 
-  //glm::mat4 normalMatrix = glm::transpose(glm::inverse(glm::mat4(glm::mat3(modelRotationMatrix))));
-
-  glUniformMatrix4fv(shaderProgram.normalMatrixLocation, 1, GL_FALSE, glm::value_ptr(normalMatrix));  // correct matrix for non-rigid transform
+  glUniformMatrix4fv(shaderProgram.normalMatrixLocation, 1, GL_FALSE, glm::value_ptr(matrices.normalMatrix));  // correct matrix for non-rigid transform
 }
 
 void setMaterialUniforms(const glm::vec3 &ambient, const glm::vec3 &diffuse, const glm::vec3 &specular, float shininess, GLuint texture) {
@@ -201,28 +168,35 @@ void setMaterialUniforms(const glm::vec3 &ambient, const glm::vec3 &diffuse, con
 
 // ----------------------------------------------------------------------------------------
 // START OF DRAWING FUNCTIONS 
-void drawTerrain(TerrainObject* terrain, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix) {
+void drawTerrain(const TerrainObject* terrain, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix) {
     glUseProgram(shaderProgram.program);
 
-    // prepare modelling transform matrix
+    // prepare modelling transform matrix - chunks are already scaled and placed in the world
     glm::mat4 modelMatrix = glm::translate(glm::mat4(1.0f), terrain->position);
-    modelMatrix = glm::rotate(modelMatrix, glm::radians(0.0f), glm::vec3(1, 0, 0));
-    modelMatrix = glm::scale(modelMatrix, glm::vec3(terrain->size, terrain->size, terrain->size));
 
     // send matrices to the vertex & fragment shader
     setTransformUniforms(modelMatrix, viewMatrix, projectionMatrix);
-    for (size_t i = 0; i < terrainGeometry.size(); i++) {
-        setMaterialUniforms(
-            terrainGeometry[i]->ambient,
-            terrainGeometry[i]->diffuse,
-            terrainGeometry[i]->specular,
-            terrainGeometry[i]->shininess,
-            terrainGeometry[i]->texture
-        );
 
-        // draw geometry
-        glBindVertexArray(terrainGeometry[i]->vertexArrayObject);
-        glDrawElements(GL_TRIANGLES, terrainGeometry[i]->numTriangles * 3, GL_UNSIGNED_INT, 0);
+    // only the chunks intersecting the view frustum are drawn
+    std::vector<const TerrainChunk*> visibleChunks;
+    getVisibleTerrainChunks(projectionMatrix * viewMatrix * modelMatrix, visibleChunks);
+
+    for (size_t c = 0; c < visibleChunks.size(); c++) {
+        const std::vector<MeshGeometry*>& geometry = visibleChunks[c]->geometry;
+
+        for (size_t i = 0; i < geometry.size(); i++) {
+            setMaterialUniforms(
+                geometry[i]->ambient,
+                geometry[i]->diffuse,
+                geometry[i]->specular,
+                geometry[i]->shininess,
+                geometry[i]->texture
+            );
+
+            // draw geometry
+            glBindVertexArray(geometry[i]->vertexArrayObject);
+            glDrawElements(GL_TRIANGLES, geometry[i]->numTriangles * 3, GL_UNSIGNED_INT, 0);
+        }
     }
     glBindVertexArray(0);
     glUseProgram(0);
@@ -230,7 +204,7 @@ void drawTerrain(TerrainObject* terrain, const glm::mat4& viewMatrix, const glm:
     return;
 };
 
-void drawPenguin(PenguinObject *penguin, const glm::mat4 & viewMatrix, const glm::mat4 & projectionMatrix) {
+void drawPenguin(const PenguinObject* penguin, const glm::mat4 & viewMatrix, const glm::mat4 & projectionMatrix) {
 
 	glUseProgram(shaderProgram.program);
 
@@ -261,7 +235,7 @@ void drawPenguin(PenguinObject *penguin, const glm::mat4 & viewMatrix, const glm
 	return;
 }
 
-void drawSparrow(SparrowObject* sparrow, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix) {
+void drawSparrow(const SparrowObject* sparrow, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix) {
 
     glUseProgram(shaderProgram.program);
 
@@ -293,7 +267,75 @@ void drawSparrow(SparrowObject* sparrow, const glm::mat4& viewMatrix, const glm:
     return;
 }
 
-void drawCat(CatObject *cat, const glm::mat4 & viewMatrix, const glm::mat4 & projectionMatrix) {
+void drawSparrows(const std::vector<SparrowObject>& sparrows, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix) {
+
+    if (sparrows.empty())
+        return;
+
+    // without the instancing one draw call per bird
+    if (shaderProgram.instancedLocation == -1 || sparrowInstanceTexture == 0) {
+        for (size_t i = 0; i < sparrows.size(); i++) {
+            SparrowObject sparrow = sparrows[i];
+            drawSparrow(&sparrow, viewMatrix, projectionMatrix);
+        }
+        return;
+    }
+
+    // position + size, cos + sin of the rotation of drawSparrow()
+    std::vector<float> instances(sparrows.size() * 8, 0.0f);
+    for (size_t i = 0; i < sparrows.size(); i++) {
+        float angle = glm::radians(180.0f - sparrows[i].currentAngle);
+        float* instance = &instances[8 * i];
+        instance[0] = sparrows[i].position.x;
+        instance[1] = sparrows[i].position.y;
+        instance[2] = sparrows[i].position.z;
+        instance[3] = sparrows[i].size;
+        instance[4] = cos(angle);
+        instance[5] = sin(angle);
+    }
+
+    // orphan the old buffer so the driver does not wait for the previous frame
+    glBindBuffer(GL_TEXTURE_BUFFER, sparrowInstanceBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, sizeof(float) * instances.size(), NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_TEXTURE_BUFFER, 0, sizeof(float) * instances.size(), &instances[0]);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    glUseProgram(shaderProgram.program);
+
+    // the instance transforms are the model matrices, Mmatrix stays the identity
+    setTransformUniforms(glm::mat4(1.0f), viewMatrix, projectionMatrix);
+    glUniform1i(shaderProgram.instancedLocation, 1);
+
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_BUFFER, sparrowInstanceTexture);
+    glActiveTexture(GL_TEXTURE0);
+
+    for (size_t i = 0; i < sparrowGeometry.size(); i++) {
+        setMaterialUniforms(
+            sparrowGeometry[i]->ambient,
+            sparrowGeometry[i]->diffuse,
+            sparrowGeometry[i]->specular,
+            sparrowGeometry[i]->shininess,
+            sparrowGeometry[i]->texture
+        );
+
+        // all birds in one draw call
+        glBindVertexArray(sparrowGeometry[i]->vertexArrayObject);
+        glDrawElementsInstanced(GL_TRIANGLES, sparrowGeometry[i]->numTriangles * 3, GL_UNSIGNED_INT, 0, GLsizei(sparrows.size()));
+    }
+    glBindVertexArray(0);
+
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glActiveTexture(GL_TEXTURE0);
+
+    glUniform1i(shaderProgram.instancedLocation, 0);
+    glUseProgram(0);
+
+    return;
+}
+
+void drawCat(const CatObject* cat, const glm::mat4 & viewMatrix, const glm::mat4 & projectionMatrix) {
 
 	glUseProgram(shaderProgram.program);
 
@@ -325,7 +367,7 @@ void drawCat(CatObject *cat, const glm::mat4 & viewMatrix, const glm::mat4 & pro
 	return;
 }
 
-void drawRock(RockObject *rock, const glm::mat4 & viewMatrix, const glm::mat4 & projectionMatrix) {
+void drawRock(const RockObject* rock, const glm::mat4 & viewMatrix, const glm::mat4 & projectionMatrix) {
 
 	glUseProgram(shaderProgram.program);
 
@@ -356,7 +398,7 @@ void drawRock(RockObject *rock, const glm::mat4 & viewMatrix, const glm::mat4 &
 	return;
 }
 
-void drawFern(FernObject* fern, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix) {
+void drawFern(const FernObject* fern, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix) {
 
     glUseProgram(shaderProgram.program);
 
@@ -387,7 +429,7 @@ void drawFern(FernObject* fern, const glm::mat4& viewMatrix, const glm::mat4& pr
     return;
 }
 
-void drawStone(StoneObject *stone, const glm::mat4 & viewMatrix, const glm::mat4 & projectionMatrix) {
+void drawStone(const StoneObject* stone, const glm::mat4 & viewMatrix, const glm::mat4 & projectionMatrix) {
 
 	glUseProgram(shaderProgram.program);
 
@@ -419,7 +461,7 @@ void drawStone(StoneObject *stone, const glm::mat4 & viewMatrix, const glm::mat4
 	return;
 }
 
-void drawTarget(TargetObject *target, const glm::mat4 & viewMatrix, const glm::mat4 & projectionMatrix) {
+void drawTarget(const TargetObject* target, const glm::mat4 & viewMatrix, const glm::mat4 & projectionMatrix) {
 
 	glUseProgram(shaderProgram.program);
 
@@ -450,7 +492,7 @@ void drawTarget(TargetObject *target, const glm::mat4 & viewMatrix, const glm::m
 	return;
 }
 
-void drawPalmTree(PalmTreeObject* palmTree, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix) {
+void drawPalmTree(const PalmTreeObject* palmTree, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix, float fade) {
 
     glUseProgram(shaderProgram.program);
 
@@ -462,6 +504,7 @@ void drawPalmTree(PalmTreeObject* palmTree, const glm::mat4& viewMatrix, const g
 
     // send matrices to the vertex & fragment shader
     setTransformUniforms(modelMatrix, viewMatrix, projectionMatrix);
+    glUniform1f(shaderProgram.fadeLocation, fade);
     for (size_t i = 0; i < palmTreeGeometry.size(); i++) {
         setMaterialUniforms(
             palmTreeGeometry[i]->ambient,
@@ -476,12 +519,37 @@ void drawPalmTree(PalmTreeObject* palmTree, const glm::mat4& viewMatrix, const g
         glDrawElements(GL_TRIANGLES, palmTreeGeometry[i]->numTriangles * 3, GL_UNSIGNED_INT, 0);
     }
     glBindVertexArray(0);
+    glUniform1f(shaderProgram.fadeLocation, 1.0f);
     glUseProgram(0);
 
     return;
 }
 
-void drawCampfire(CampfireObject* campfire, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix) {
+void drawPalmTrees(const std::vector<const PalmTreeObject*>& palmTrees, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix) {
+
+    glm::vec3 cameraPosition = glm::vec3(glm::inverse(viewMatrix)[3]);
+    std::vector<ImpostorInstance> impostors;
+
+    // near trees as meshes, far trees as impostors, both inside the cross-fade band
+    for (size_t i = 0; i < palmTrees.size(); i++) {
+        float fade = (palmTreeImpostor.texture != 0) ? getImpostorMeshFade(palmTrees[i]->position, cameraPosition) : 1.0f;
+
+        if (fade > 0.0f)
+            drawPalmTree(palmTrees[i], viewMatrix, projectionMatrix, fade);
+
+        if (fade < 1.0f) {
+            ImpostorInstance impostor;
+            impostor.position = palmTrees[i]->position;
+            impostor.size = palmTrees[i]->size;
+            impostor.meshFade = fade;
+            impostors.push_back(impostor);
+        }
+    }
+
+    drawImpostors(palmTreeImpostor, impostors, viewMatrix, projectionMatrix);
+}
+
+void drawCampfire(const CampfireObject* campfire, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix) {
 
     glUseProgram(shaderProgram.program);
 
@@ -512,7 +580,7 @@ void drawCampfire(CampfireObject* campfire, const glm::mat4& viewMatrix, const g
     return;
 }
 
-void drawBlock(BlockObject* block, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix) {
+void drawBlock(const BlockObject* block, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix) {
     glUseProgram(shaderProgram.program);
 
     // align block coordinate system to match its position and direction - see alignObject() function
@@ -549,7 +617,7 @@ void drawBlock(BlockObject* block, const glm::mat4& viewMatrix, const glm::mat4&
     return;
 }
 
-void drawMissile(MissileObject* missile, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix) {
+void drawMissile(const MissileObject* missile, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix) {
 
     glUseProgram(shaderProgram.program);
 
@@ -582,67 +650,59 @@ void drawMissile(MissileObject* missile, const glm::mat4& viewMatrix, const glm:
     return;
 }
 
-void drawExplosion(ExplosionObject* explosion, const glm::mat4 & viewMatrix, const glm::mat4 & projectionMatrix) {
-    
-  glEnable(GL_BLEND);
-  glBlendFunc(GL_ONE, GL_ONE);
-
-  glUseProgram(explosionShaderProgram.program);
-
-// version 1: inversion of the rotation part of the view matrix
+void drawExplosions(const std::vector<const ExplosionObject*>& explosions, const glm::mat4 & viewMatrix, const glm::mat4 & projectionMatrix, float time) {
 
-  // just take 3x3 rotation part of the view transform
-  glm::mat4 billboardRotationMatrix = glm::mat4(
-    viewMatrix[0],
-    viewMatrix[1],
-    viewMatrix[2],
-    glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)
-  );
-  // inverse view rotation
-  billboardRotationMatrix = glm::transpose(billboardRotationMatrix);
-
-  glm::mat4 matrix = glm::mat4(1.0f);
-  matrix = glm::translate(matrix, explosion->position);
-  matrix = glm::scale(matrix, glm::vec3(explosion->size));
-
-  matrix = matrix * billboardRotationMatrix; // make billboard to face the camera
-  glm::mat4 PVMmatrix = projectionMatrix * viewMatrix * matrix;
-
-  glUniformMatrix4fv(explosionShaderProgram.VmatrixLocation, 1, GL_FALSE, glm::value_ptr(viewMatrix));   // view
-
-// end of version 1: inversion of the rotation part of the view matrix
-
-// version 2: only translation in camera space
- 
-  //glm::mat4 viewTranslateMatrix = viewMatrix * glm::translate(glm::mat4(1.0f), explosion->position);
-  //glm::mat4 viewTranslateRotateMatrix = viewTranslateMatrix * glm::mat4(glm::inverse(glm::mat3(viewMatrix)));
-  //glm::mat4 scaleMatrix = glm::scale(glm::mat4(1.0f), glm::vec3(explosion->size));
-  //glm::mat4 PVMmatrix = projectionMatrix * viewTranslateRotateMatrix * scaleMatrix;
-
-  //glUniformMatrix4fv(explosionShaderProgram.VmatrixLocation, 1, GL_FALSE, glm::value_ptr(glm::mat4(1.0f))); // viewMatrix = identity matrix
- 
-// end of version 2: only translation in camera space 
+  if (explosions.empty())
+    return;
 
-// version 3: only translation in camera space (simplified variant of version 2)
+  // two triangles of the billboard quad (explosionVertexData is a triangle strip)
+  const int quadCorners[6] = { 0, 1, 2, 2, 1, 3 };
+
+  // center, size, start time, frame duration, texture coordinates
+  std::vector<float> vertices;
+  vertices.reserve(explosions.size() * 6 * EXPLOSION_VERTEX_FLOATS);
+
+  for (size_t i = 0; i < explosions.size(); i++) {
+    const ExplosionObject* explosion = explosions[i];
+
+    for (int c = 0; c < 6; c++) {
+      const float* corner = &explosionVertexData[5 * quadCorners[c]];
+      vertices.push_back(explosion->position.x);
+      vertices.push_back(explosion->position.y);
+      vertices.push_back(explosion->position.z);
+      vertices.push_back(explosion->size);
+      vertices.push_back(explosion->startTime);
+      vertices.push_back(explosion->frameDuration);
+      vertices.push_back(corner[3]);
+      vertices.push_back(corner[4]);
+    }
+  }
 
-  //glm::vec4 positionInCameraSpace = viewMatrix * glm::vec4(explosion->position, 1.0f);
-  //glm::mat4 matrix = glm::mat4(1.0f);
-  //matrix[3] = positionInCameraSpace; // the same as: modelMatrix = glm::translate(modelMatrix, glm::vec3(positionInCameraSpace));
-  //matrix = glm::scale(matrix, glm::vec3(explosion->size));
-  //glm::mat4 PVMmatrix = projectionMatrix * matrix; // view equals to identity matrix
+  // the inverse view rotation (billboard) - its columns are the camera axes in world coordinates
+  glm::vec3 cameraRight(viewMatrix[0][0], viewMatrix[1][0], viewMatrix[2][0]);
+  glm::vec3 cameraUp(viewMatrix[0][1], viewMatrix[1][1], viewMatrix[2][1]);
+  glm::mat4 PVmatrix = projectionMatrix * viewMatrix;
 
-  //glUniformMatrix4fv(explosionShaderProgram.VmatrixLocation, 1, GL_FALSE, glm::value_ptr(glm::mat4(1.0f))); // viewMatrix = identity matrix
+  // state is set once for all explosions
+  glEnable(GL_BLEND);
+  glBlendFunc(GL_ONE, GL_ONE);
 
-// end of version 3: only translation in camera space
+  glUseProgram(explosionShaderProgram.program);
 
-  glUniformMatrix4fv(explosionShaderProgram.PVMmatrixLocation, 1, GL_FALSE, glm::value_ptr(PVMmatrix));  // model-view-projection
-  glUniform1f(explosionShaderProgram.timeLocation, explosion->currentTime - explosion->startTime);
+  glUniformMatrix4fv(explosionShaderProgram.PVmatrixLocation, 1, GL_FALSE, glm::value_ptr(PVmatrix));
+  glUniform3fv(explosionShaderProgram.cameraRightLocation, 1, glm::value_ptr(cameraRight));
+  glUniform3fv(explosionShaderProgram.cameraUpLocation, 1, glm::value_ptr(cameraUp));
+  glUniform1f(explosionShaderProgram.timeLocation, time);
   glUniform1i(explosionShaderProgram.texSamplerLocation, 0);
-  glUniform1f(explosionShaderProgram.frameDurationLocation, explosion->frameDuration);
+
+  // orphan the old buffer so the driver does not wait for the previous frame
+  glBindBuffer(GL_ARRAY_BUFFER, explosionGeometry->vertexBufferObject);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(float) * vertices.size(), NULL, GL_STREAM_DRAW);
+  glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(float) * vertices.size(), &vertices[0]);
 
   glBindVertexArray(explosionGeometry->vertexArrayObject);
   glBindTexture(GL_TEXTURE_2D, explosionGeometry->texture);
-  glDrawArrays(GL_TRIANGLE_STRIP, 0, explosionGeometry->numTriangles);
+  glDrawArrays(GL_TRIANGLES, 0, GLsizei(vertices.size() / EXPLOSION_VERTEX_FLOATS));
 
   glBindVertexArray(0);
   glUseProgram(0);
@@ -652,7 +712,7 @@ void drawExplosion(ExplosionObject* explosion, const glm::mat4 & viewMatrix, con
   return;
 }
 
-void drawBanner(BannerObject* banner, const glm::mat4 & viewMatrix, const glm::mat4 & projectionMatrix) {
+void drawBanner(const BannerObject* banner, const glm::mat4 & viewMatrix, const glm::mat4 & projectionMatrix) {
 
   glEnable(GL_BLEND);
   glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
@@ -715,6 +775,33 @@ void drawSkybox(const glm::mat4 & viewMatrix, const glm::mat4 & projectionMatrix
 
 // ----------------------------------------------------------------------------------------
 // START OF SHADER PROGRAM FUNCTIONS
+// whole text file, empty when it cannot be read
+static std::string readTextFile(const std::string& fileName) {
+  std::ifstream file(fileName.c_str());
+  if (!file) {
+    std::cerr << "readTextFile(): Cannot open file \"" << fileName << "\"." << std::endl;
+    return std::string();
+  }
+  std::stringstream text;
+  text << file.rdbuf();
+  return text.str();
+}
+
+GLuint createShaderWithCommonFile(GLenum shaderType, const std::string& commonFileName, const std::string& fileName) {
+  std::string common = readTextFile(commonFileName);
+  std::string source = readTextFile(fileName);
+  if (common.empty() || source.empty())
+    return 0;
+
+  // after the #version line, #line keeps the line numbers of the compiler errors in the file
+  size_t versionEnd = source.find('\n');
+  if (versionEnd == std::string::npos)
+    versionEnd = source.size();
+  source.insert(versionEnd, "\n" + common + "\n#line 2\n");
+
+  return pgr::createShaderFromSource(shaderType, source);
+}
+
 void cleanupShaderPrograms(void) {
 
   pgr::deleteProgramAndShaders(shaderProgram.program);
@@ -733,7 +820,7 @@ void initializeShaderPrograms(void) {
 
     // push vertex shader and fragment shader
     shaderList.push_back(pgr::createShaderFromFile(GL_VERTEX_SHADER, "lighting.vert"));
-    shaderList.push_back(pgr::createShaderFromFile(GL_FRAGMENT_SHADER, "lighting.frag"));
+    shaderList.push_back(createShaderWithCommonFile(GL_FRAGMENT_SHADER, "fade_fog.frag", "lighting.frag"));
 
     // create the shader program with two shaders
     shaderProgram.program = pgr::createProgram(shaderList);
@@ -742,12 +829,14 @@ void initializeShaderPrograms(void) {
     shaderProgram.posLocation      = glGetAttribLocation(shaderProgram.program, "position");
     shaderProgram.normalLocation   = glGetAttribLocation(shaderProgram.program, "normal");
     shaderProgram.texCoordLocation = glGetAttribLocation(shaderProgram.program, "texCoord");
+    shaderProgram.swayWeightLocation = glGetAttribLocation(shaderProgram.program, "swayWeight");
     // get uniforms locations
     shaderProgram.PVMmatrixLocation    = glGetUniformLocation(shaderProgram.program, "PVMmatrix");
     shaderProgram.VmatrixLocation      = glGetUniformLocation(shaderProgram.program, "Vmatrix");
     shaderProgram.MmatrixLocation      = glGetUniformLocation(shaderProgram.program, "Mmatrix");
     shaderProgram.normalMatrixLocation = glGetUniformLocation(shaderProgram.program, "normalMatrix");
     shaderProgram.timeLocation         = glGetUniformLocation(shaderProgram.program, "time");
+    shaderProgram.windLocation         = glGetUniformLocation(shaderProgram.program, "wind");
     // material
     shaderProgram.ambientLocation      = glGetUniformLocation(shaderProgram.program, "material.ambient");
     shaderProgram.diffuseLocation      = glGetUniformLocation(shaderProgram.program, "material.diffuse");
@@ -771,6 +860,14 @@ void initializeShaderPrograms(void) {
     shaderProgram.fogOnExpLoc = glGetUniformLocation(shaderProgram.program, "fogOnExpToggle");
     shaderProgram.fogOnNearLoc = glGetUniformLocation(shaderProgram.program, "fogNearValue");
     shaderProgram.fogOnDensityLoc = glGetUniformLocation(shaderProgram.program, "fogDensityValue");
+    // impostor cross-fade
+    shaderProgram.fadeLocation = glGetUniformLocation(shaderProgram.program, "fade");
+    // instancing - the instance buffer is always on the texture unit 1, the textures of the materials on 0
+    shaderProgram.instancedLocation = glGetUniformLocation(shaderProgram.program, "instanced");
+    shaderProgram.instancesLocation = glGetUniformLocation(shaderProgram.program, "instances");
+    glUseProgram(shaderProgram.program);
+    glUniform1i(shaderProgram.instancesLocation, 1);
+    glUseProgram(0);
   }
   else {
     // load and compile simple shader (colors only, no lights at all)
@@ -786,6 +883,11 @@ void initializeShaderPrograms(void) {
     shaderProgram.colorLocation = glGetAttribLocation(shaderProgram.program, "color");
     // get uniforms locations
     shaderProgram.PVMmatrixLocation = glGetUniformLocation(shaderProgram.program, "PVMmatrix");
+    shaderProgram.fadeLocation = -1;
+    shaderProgram.swayWeightLocation = -1;
+    shaderProgram.instancedLocation = -1;
+    shaderProgram.instancesLocation = -1;
+    shaderProgram.windLocation = -1;
 
   }
 
@@ -800,15 +902,18 @@ void initializeShaderPrograms(void) {
   // create the program with two shaders
   explosionShaderProgram.program = pgr::createProgram(shaderList);
 
-  // get position and texture coordinates attributes locations
-  explosionShaderProgram.posLocation      = glGetAttribLocation(explosionShaderProgram.program, "position");
-  explosionShaderProgram.texCoordLocation = glGetAttribLocation(explosionShaderProgram.program, "texCoord");
+  // get per-explosion and texture coordinates attributes locations
+  explosionShaderProgram.centerLocation        = glGetAttribLocation(explosionShaderProgram.program, "center");
+  explosionShaderProgram.sizeLocation          = glGetAttribLocation(explosionShaderProgram.program, "size");
+  explosionShaderProgram.startTimeLocation     = glGetAttribLocation(explosionShaderProgram.program, "startTime");
+  explosionShaderProgram.frameDurationLocation = glGetAttribLocation(explosionShaderProgram.program, "frameDuration");
+  explosionShaderProgram.texCoordLocation      = glGetAttribLocation(explosionShaderProgram.program, "texCoord");
   // get uniforms locations
-  explosionShaderProgram.PVMmatrixLocation     = glGetUniformLocation(explosionShaderProgram.program, "PVMmatrix");
-  explosionShaderProgram.VmatrixLocation       = glGetUniformLocation(explosionShaderProgram.program, "Vmatrix");
-  explosionShaderProgram.timeLocation          = glGetUniformLocation(explosionShaderProgram.program, "time");
-  explosionShaderProgram.texSamplerLocation    = glGetUniformLocation(explosionShaderProgram.program, "texSampler");
-  explosionShaderProgram.frameDurationLocation = glGetUniformLocation(explosionShaderProgram.program, "frameDuration");
+  explosionShaderProgram.PVmatrixLocation    = glGetUniformLocation(explosionShaderProgram.program, "PVmatrix");
+  explosionShaderProgram.cameraRightLocation = glGetUniformLocation(explosionShaderProgram.program, "cameraRight");
+  explosionShaderProgram.cameraUpLocation    = glGetUniformLocation(explosionShaderProgram.program, "cameraUp");
+  explosionShaderProgram.timeLocation        = glGetUniformLocation(explosionShaderProgram.program, "time");
+  explosionShaderProgram.texSamplerLocation  = glGetUniformLocation(explosionShaderProgram.program, "texSampler");
 
   // load and compile shader for banner (translation of texture coordinates)
 
@@ -852,14 +957,8 @@ void initializeShaderPrograms(void) {
 
 // ----------------------------------------------------------------------------------------
 // START OF LOADING OBJ FUNCTION
-/** Load mesh using assimp library
- *  Vertex, normals and texture coordinates data are stored without interleaving |VVVVV...|NNNNN...|tttt
- * \param fileName [in] file to open/load
- * \param shader [in] vao will connect loaded data to shader
- * \param geometry
- */
-bool loadSingleMesh(const std::string& fileName, SCommonShaderProgram& shader, std::vector<MeshGeometry*>& geometry) {
-    Assimp::Importer importer;
+// Reads a model with the processing used for all models of the scene, the scene belongs to the importer.
+const aiScene* readMeshScene(Assimp::Importer& importer, const std::string& fileName) {
 
     // Unitize object in size (scale the model to fit into (-1..1)^3)
     importer.SetPropertyInteger(AI_CONFIG_PP_PTV_NORMALIZE, 1);
@@ -872,10 +971,97 @@ bool loadSingleMesh(const std::string& fileName, SCommonShaderProgram& shader, s
         | aiProcess_JoinIdenticalVertices);
 
     // abort if the loader fails
-    if (scn == NULL) {
+    if (scn == NULL)
         std::cerr << "assimp error: " << importer.GetErrorString() << std::endl;
-        return false;
+    return scn;
+}
+
+/** Copy the material colors of a mesh and load its diffuse texture
+ * \param scn [in] loaded scene
+ * \param mesh [in] mesh of the scene
+ * \param fileName [in] file the scene was loaded from, the textures are next to it
+ * \param geometry [out] geometry getting the material and the texture
+ */
+static void loadMeshMaterial(const aiScene* scn, const aiMesh* mesh, const std::string& fileName, MeshGeometry* geometry) {
+    const aiMaterial* mat = scn->mMaterials[mesh->mMaterialIndex];
+    aiColor4D color;
+    aiString name;
+    aiReturn retValue = AI_SUCCESS;
+
+    // Get returns: aiReturn_SUCCESS 0 | aiReturn_FAILURE -1 | aiReturn_OUTOFMEMORY -3
+    mat->Get(AI_MATKEY_NAME, name); // may be "" after the input mesh processing. Must be aiString type!
+
+    if ((retValue = aiGetMaterialColor(mat, AI_MATKEY_COLOR_DIFFUSE, &color)) != AI_SUCCESS)
+        color = aiColor4D(0.0f, 0.0f, 0.0f, 0.0f);
+
+    geometry->diffuse = glm::vec3(color.r, color.g, color.b);
+
+    if ((retValue = aiGetMaterialColor(mat, AI_MATKEY_COLOR_AMBIENT, &color)) != AI_SUCCESS)
+        color = aiColor4D(0.0f, 0.0f, 0.0f, 0.0f);
+    geometry->ambient = glm::vec3(color.r, color.g, color.b);
+
+    if ((retValue = aiGetMaterialColor(mat, AI_MATKEY_COLOR_SPECULAR, &color)) != AI_SUCCESS)
+        color = aiColor4D(0.0f, 0.0f, 0.0f, 0.0f);
+    geometry->specular = glm::vec3(color.r, color.g, color.b);
+
+    ai_real shininess, strength;
+    unsigned int max;	// changed: to unsigned
+
+    max = 1;
+    if ((retValue = aiGetMaterialFloatArray(mat, AI_MATKEY_SHININESS, &shininess, &max)) != AI_SUCCESS)
+        shininess = 1.0f;
+    max = 1;
+    if ((retValue = aiGetMaterialFloatArray(mat, AI_MATKEY_SHININESS_STRENGTH, &strength, &max)) != AI_SUCCESS)
+        strength = 1.0f;
+    geometry->shininess = shininess * strength;
+
+    geometry->texture = 0;
+
+    // load texture image
+    if (mat->GetTextureCount(aiTextureType_DIFFUSE) > 0) {
+        // get texture name 
+        aiString path; // filename
+
+        aiReturn texFound = mat->GetTexture(aiTextureType_DIFFUSE, 0, &path); // TODO : can implement the ambient and specular textures for additional texture mapping
+        std::string textureName = path.data;
+
+        size_t found = fileName.find_last_of("/\\");
+        // insert correct texture file path 
+        if (found != std::string::npos) { // not found
+            //subMesh_p->textureName.insert(0, "/");
+            textureName.insert(0, fileName.substr(0, found + 1));
+        }
+
+        std::cout << "Loading texture file: " << textureName << std::endl;
+        geometry->texture = pgr::createTexture(textureName);
     }
+}
+
+/** Load meshes of a scene read by readMeshScene()
+ *  Vertex, normals and texture coordinates data are stored without interleaving |VVVVV...|NNNNN...|tttt
+ *  Vegetation also gets the wind sway weights after them |VVVVV...|NNNNN...|tttt|wwwww...
+ * \param scn [in] loaded scene
+ * \param fileName [in] file the scene was loaded from, the textures are next to it
+ * \param shader [in] vao will connect loaded data to shader
+ * \param geometry
+ * \param swayAxis [in] up axis of the model (0 = x, 1 = y, 2 = z) used for the sway weights, -1 => no wind sway
+ */
+bool loadSceneMeshes(const aiScene* scn, const std::string& fileName, SCommonShaderProgram& shader, std::vector<MeshGeometry*>& geometry, int swayAxis) {
+
+    // height range of the whole model (all meshes) along the up axis for the sway weights
+    bool useSway = (swayAxis >= 0 && swayAxis <= 2 && shader.swayWeightLocation >= 0);
+    float swayMin = 1.0f;
+    float swayMax = -1.0f;
+    if (useSway) {
+        for (size_t i = 0; i < scn->mNumMeshes; i++) {
+            for (unsigned int idx = 0; idx < scn->mMeshes[i]->mNumVertices; idx++) {
+                float height = (&scn->mMeshes[i]->mVertices[idx].x)[swayAxis];
+                swayMin = std::min(swayMin, height);
+                swayMax = std::max(swayMax, height);
+            }
+        }
+    }
+    const int floatsPerVertex = useSway ? 9 : 8;
 
     // in this phase we know we have one mesh in our loaded scene, we can directly copy its data to OpenGL ...
     for (size_t i = 0; i < scn->mNumMeshes; i++) {
@@ -887,7 +1073,7 @@ bool loadSingleMesh(const std::string& fileName, SCommonShaderProgram& shader, s
         // vertex buffer object, store all vertex positions and normals
         glGenBuffers(1, &((geometry2)->vertexBufferObject));
         glBindBuffer(GL_ARRAY_BUFFER, (geometry2)->vertexBufferObject);
-        glBufferData(GL_ARRAY_BUFFER, 8 * sizeof(float) * mesh->mNumVertices, 0, GL_STATIC_DRAW); // allocate memory for vertices, normals, and texture coordinates
+        glBufferData(GL_ARRAY_BUFFER, floatsPerVertex * sizeof(float) * mesh->mNumVertices, 0, GL_STATIC_DRAW); // allocate memory for vertices, normals, texture coordinates (and sway weights)
         // first store all vertices
         glBufferSubData(GL_ARRAY_BUFFER, 0, 3 * sizeof(float) * mesh->mNumVertices, mesh->mVertices);
         // then store all normals
@@ -911,6 +1097,20 @@ bool loadSingleMesh(const std::string& fileName, SCommonShaderProgram& shader, s
 
         // finally store all texture coordinates
         glBufferSubData(GL_ARRAY_BUFFER, 6 * sizeof(float) * mesh->mNumVertices, 2 * sizeof(float) * mesh->mNumVertices, textureCoords);
+        delete[] textureCoords;
+
+        // sway weights - 0 at the bottom of the model, growing quadratically => stiff trunk, moving top
+        if (useSway) {
+            float* swayWeights = new float[mesh->mNumVertices];
+            float range = std::max(swayMax - swayMin, 1e-6f);
+
+            for (unsigned int idx = 0; idx < mesh->mNumVertices; idx++) {
+                float relativeHeight = ((&mesh->mVertices[idx].x)[swayAxis] - swayMin) / range;
+                swayWeights[idx] = relativeHeight * relativeHeight;
+            }
+            glBufferSubData(GL_ARRAY_BUFFER, 8 * sizeof(float) * mesh->mNumVertices, sizeof(float) * mesh->mNumVertices, swayWeights);
+            delete[] swayWeights;
+        }
 
         // copy all mesh faces into one big array (assimp supports faces with ordinary number of vertices, we use only 3 -> triangles)
         unsigned int* indices = new unsigned int[mesh->mNumFaces * 3];
@@ -928,58 +1128,7 @@ bool loadSingleMesh(const std::string& fileName, SCommonShaderProgram& shader, s
         delete[] indices;
 
         // copy the material info to MeshGeometry structure
-        const aiMaterial* mat = scn->mMaterials[mesh->mMaterialIndex];
-        aiColor4D color;
-        aiString name;
-        aiReturn retValue = AI_SUCCESS;
-
-        // Get returns: aiReturn_SUCCESS 0 | aiReturn_FAILURE -1 | aiReturn_OUTOFMEMORY -3
-        mat->Get(AI_MATKEY_NAME, name); // may be "" after the input mesh processing. Must be aiString type!
-
-        if ((retValue = aiGetMaterialColor(mat, AI_MATKEY_COLOR_DIFFUSE, &color)) != AI_SUCCESS)
-            color = aiColor4D(0.0f, 0.0f, 0.0f, 0.0f);
-
-        (geometry2)->diffuse = glm::vec3(color.r, color.g, color.b);
-
-        if ((retValue = aiGetMaterialColor(mat, AI_MATKEY_COLOR_AMBIENT, &color)) != AI_SUCCESS)
-            color = aiColor4D(0.0f, 0.0f, 0.0f, 0.0f);
-        (geometry2)->ambient = glm::vec3(color.r, color.g, color.b);
-
-        if ((retValue = aiGetMaterialColor(mat, AI_MATKEY_COLOR_SPECULAR, &color)) != AI_SUCCESS)
-            color = aiColor4D(0.0f, 0.0f, 0.0f, 0.0f);
-        (geometry2)->specular = glm::vec3(color.r, color.g, color.b);
-
-        ai_real shininess, strength;
-        unsigned int max;	// changed: to unsigned
-
-        max = 1;
-        if ((retValue = aiGetMaterialFloatArray(mat, AI_MATKEY_SHININESS, &shininess, &max)) != AI_SUCCESS)
-            shininess = 1.0f;
-        max = 1;
-        if ((retValue = aiGetMaterialFloatArray(mat, AI_MATKEY_SHININESS_STRENGTH, &strength, &max)) != AI_SUCCESS)
-            strength = 1.0f;
-        (geometry2)->shininess = shininess * strength;
-
-        (geometry2)->texture = 0;
-
-        // load texture image
-        if (mat->GetTextureCount(aiTextureType_DIFFUSE) > 0) {
-            // get texture name 
-            aiString path; // filename
-
-            aiReturn texFound = mat->GetTexture(aiTextureType_DIFFUSE, 0, &path); // TODO : can implement the ambient and specular textures for additional texture mapping
-            std::string textureName = path.data;
-
-            size_t found = fileName.find_last_of("/\\");
-            // insert correct texture file path 
-            if (found != std::string::npos) { // not found
-                //subMesh_p->textureName.insert(0, "/");
-                textureName.insert(0, fileName.substr(0, found + 1));
-            }
-
-            std::cout << "Loading texture file: " << textureName << std::endl;
-            (geometry2)->texture = pgr::createTexture(textureName);
-        }
+        loadMeshMaterial(scn, mesh, fileName, geometry2);
         CHECK_GL_ERROR();
 
         glGenVertexArrays(1, &((geometry2)->vertexArrayObject));
@@ -999,11 +1148,17 @@ bool loadSingleMesh(const std::string& fileName, SCommonShaderProgram& shader, s
             glDisableVertexAttribArray(shader.colorLocation);
             // following line is problematic on AMD/ATI graphic cards
             // -> if you see black screen (no objects at all) than try to set color manually in vertex shader to see at least something
-            glVertexAttrib3f(shader.colorLocation, color.r, color.g, color.b);
+            glVertexAttrib3f(shader.colorLocation, geometry2->specular.r, geometry2->specular.g, geometry2->specular.b);
         }
 
         glEnableVertexAttribArray(shader.texCoordLocation);
         glVertexAttribPointer(shader.texCoordLocation, 2, GL_FLOAT, GL_FALSE, 0, (void*)(6 * sizeof(float) * mesh->mNumVertices));
+
+        // meshes without the weights use the constant attribute value 0 => no sway
+        if (useSway) {
+            glEnableVertexAttribArray(shader.swayWeightLocation);
+            glVertexAttribPointer(shader.swayWeightLocation, 1, GL_FLOAT, GL_FALSE, 0, (void*)(8 * sizeof(float) * mesh->mNumVertices));
+        }
         CHECK_GL_ERROR();
 
         glBindVertexArray(0);
@@ -1014,6 +1169,42 @@ bool loadSingleMesh(const std::string& fileName, SCommonShaderProgram& shader, s
     return true;
 }
 
+/** Load only the materials and textures of the meshes of a scene read by readMeshScene(), no buffers are created
+ * \param scn [in] loaded scene
+ * \param fileName [in] file the scene was loaded from, the textures are next to it
+ * \param geometry [out] one geometry per mesh, its buffers and vertex array object are 0
+ */
+bool loadSceneMaterials(const aiScene* scn, const std::string& fileName, std::vector<MeshGeometry*>& geometry) {
+    for (size_t i = 0; i < scn->mNumMeshes; i++) {
+        MeshGeometry* geometry2 = new MeshGeometry;
+
+        geometry2->vertexBufferObject = 0;
+        geometry2->elementBufferObject = 0;
+        geometry2->vertexArrayObject = 0;
+        geometry2->numTriangles = 0;
+        loadMeshMaterial(scn, scn->mMeshes[i], fileName, geometry2);
+        geometry.push_back(geometry2);
+    }
+    CHECK_GL_ERROR();
+    return true;
+}
+
+/** Load mesh using assimp library
+ * \param fileName [in] file to open/load
+ * \param shader [in] vao will connect loaded data to shader
+ * \param geometry
+ * \param swayAxis [in] up axis of the model (0 = x, 1 = y, 2 = z) used for the sway weights, -1 => no wind sway
+ */
+bool loadSingleMesh(const std::string& fileName, SCommonShaderProgram& shader, std::vector<MeshGeometry*>& geometry, int swayAxis = -1) {
+    Assimp::Importer importer;
+
+    const aiScene* scn = readMeshScene(importer, fileName);
+    if (scn == NULL)
+        return false;
+
+    return loadSceneMeshes(scn, fileName, shader, geometry, swayAxis);
+}
+
 // END OF LOADING OBJ FUNCTION
 // ----------------------------------------------------------------------------------------
 
@@ -1105,17 +1296,26 @@ void initExplosionGeometry(GLuint shader, MeshGeometry **geometry) {
   glGenVertexArrays(1, &((*geometry)->vertexArrayObject));
   glBindVertexArray((*geometry)->vertexArrayObject);
 
-  glGenBuffers(1, &((*geometry)->vertexBufferObject));\
+  // streaming buffer, filled by drawExplosions() every frame
+  glGenBuffers(1, &((*geometry)->vertexBufferObject));
   glBindBuffer(GL_ARRAY_BUFFER, (*geometry)->vertexBufferObject);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(explosionVertexData), explosionVertexData, GL_STATIC_DRAW);
 
-  glEnableVertexAttribArray(explosionShaderProgram.posLocation);
-  // vertices of triangles - start at the beginning of the array (interlaced array)
-  glVertexAttribPointer(explosionShaderProgram.posLocation, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), 0);
+  const GLsizei stride = EXPLOSION_VERTEX_FLOATS * sizeof(float);
+
+  glEnableVertexAttribArray(explosionShaderProgram.centerLocation);
+  glVertexAttribPointer(explosionShaderProgram.centerLocation, 3, GL_FLOAT, GL_FALSE, stride, 0);
+
+  glEnableVertexAttribArray(explosionShaderProgram.sizeLocation);
+  glVertexAttribPointer(explosionShaderProgram.sizeLocation, 1, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(float)));
+
+  glEnableVertexAttribArray(explosionShaderProgram.startTimeLocation);
+  glVertexAttribPointer(explosionShaderProgram.startTimeLocation, 1, GL_FLOAT, GL_FALSE, stride, (void*)(4 * sizeof(float)));
+
+  glEnableVertexAttribArray(explosionShaderProgram.frameDurationLocation);
+  glVertexAttribPointer(explosionShaderProgram.frameDurationLocation, 1, GL_FLOAT, GL_FALSE, stride, (void*)(5 * sizeof(float)));
 
   glEnableVertexAttribArray(explosionShaderProgram.texCoordLocation);
-  // texture coordinates are placed just after the position of each vertex (interlaced array)
-  glVertexAttribPointer(explosionShaderProgram.texCoordLocation, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
+  glVertexAttribPointer(explosionShaderProgram.texCoordLocation, 2, GL_FLOAT, GL_FALSE, stride, (void*)(6 * sizeof(float)));
 
   glBindVertexArray(0);
 
@@ -1193,11 +1393,23 @@ void initSkyboxGeometry(GLuint shader, MeshGeometry **geometry) {
 // Initialize vertex buffers and vertex arrays for all objects. 
 void initializeModels() {
 
-  if (loadSingleMesh(TERRAIN_MODEL_NAME, shaderProgram, terrainGeometry) != true) {
+  // the terrain model is read once - its materials, the streamed chunks and the heightfield share the scene,
+  // only the chunks upload the vertices
+  Assimp::Importer terrainImporter;
+  const aiScene* terrainScene = readMeshScene(terrainImporter, TERRAIN_MODEL_NAME);
+
+  if (terrainScene == NULL || loadSceneMaterials(terrainScene, TERRAIN_MODEL_NAME, terrainGeometry) != true) {
 		std::cerr << "initializeModels(): Terrain model loading failed." << std::endl;
 	}
+  else if (initializeTerrainChunks(terrainScene, terrainGeometry, TERRAIN_SIZE) != true) {
+    std::cerr << "initializeModels(): Terrain chunks loading failed." << std::endl;
+  }
 	CHECK_GL_ERROR();
 
+  // terrain heights for the placement and movement of the objects
+  if (terrainScene == NULL || initializeHeightfield(terrainScene, TERRAIN_SIZE, HEIGHTFIELD_RESOLUTION) != true)
+    std::cerr << "initializeModels(): Terrain heightfield baking failed." << std::endl;
+
   if (loadSingleMesh(PENGUIN_MODEL_NAME, shaderProgram, penguinGeometry) != true) {
       std::cerr << "initializeModels(): Penguin model loading failed." << std::endl;
   }
@@ -1206,6 +1418,17 @@ void initializeModels() {
   if (loadSingleMesh(SPARROW_MODEL_NAME, shaderProgram, sparrowGeometry) != true) {
       std::cerr << "initializeModels(): Sparrow model loading failed." << std::endl;
   }
+  if (shaderProgram.instancedLocation != -1) {
+    glGenBuffers(1, &sparrowInstanceBuffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, sparrowInstanceBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, 8 * sizeof(float), NULL, GL_STREAM_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    glGenTextures(1, &sparrowInstanceTexture);
+    glBindTexture(GL_TEXTURE_BUFFER, sparrowInstanceTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, sparrowInstanceBuffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+  }
   CHECK_GL_ERROR();
 
   if (loadSingleMesh(CAT_MODEL_NAME, shaderProgram, catGeometry) != true) {
@@ -1213,7 +1436,8 @@ void initializeModels() {
   }
   CHECK_GL_ERROR();
 
-  if (loadSingleMesh(FERN_MODEL_NAME, shaderProgram, fernGeometry) != true) {
+  // ferns and palm trees sway in the wind, the up axis is z for the fern and y for the palm tree
+  if (loadSingleMesh(FERN_MODEL_NAME, shaderProgram, fernGeometry, 2) != true) {
       std::cerr << "initializeModels(): Fern model loading failed." << std::endl;
   }
   CHECK_GL_ERROR();
@@ -1228,11 +1452,20 @@ void initializeModels() {
   }
   CHECK_GL_ERROR();
 
-  if (loadSingleMesh(PALMTREE_MODEL_NAME, shaderProgram, palmTreeGeometry) != true) {
+  if (loadSingleMesh(PALMTREE_MODEL_NAME, shaderProgram, palmTreeGeometry, 1) != true) {
       std::cerr << "initializeModels(): Palm tree model loading failed." << std::endl;
   }
   CHECK_GL_ERROR();
 
+  // distant palm trees are drawn as impostors, the rotation must match drawPalmTree()
+  initializeImpostors();
+  if (useLighting == true && palmTreeGeometry.empty() == false) {
+    glm::mat4 palmTreeAlignMatrix = glm::rotate(glm::mat4(1.0f), glm::radians(90.0f), glm::vec3(1, 0, 0));
+    if (bakeImpostorAtlas(palmTreeGeometry, palmTreeAlignMatrix, palmTreeImpostor) != true)
+      std::cerr << "initializeModels(): Palm tree impostor baking failed." << std::endl;
+  }
+  CHECK_GL_ERROR();
+
   if (loadSingleMesh(CAMPFIRE_MODEL_NAME, shaderProgram, campfireGeometry) != true) {
       std::cerr << "initializeModels(): Campfire model loading failed." << std::endl;
   }
@@ -1244,6 +1477,10 @@ void initializeModels() {
   // fill MeshGeometry structure for explosion object
   initExplosionGeometry(explosionShaderProgram.program, &explosionGeometry);
 
+  // explosions are drawn by the particle system, the billboards above are the fallback
+  if (initializeParticles(explosionGeometry->texture) != true)
+    std::cerr << "initializeModels(): Particle system not available, using explosion billboards." << std::endl;
+
   // fill MeshGeometry structure for banner object
   initBannerGeometry(bannerShaderProgram.program, &bannerGeometry);
 
@@ -1273,20 +1510,29 @@ void cleanupMultipleGeometry(std::vector<MeshGeometry*>& geometry) {
 }
 
 void cleanupModels() {
+  cleanupParticles();
   cleanupSingleGeometry(explosionGeometry);
   cleanupSingleGeometry(bannerGeometry);
   cleanupSingleGeometry(skyboxGeometry);
 
   cleanupSingleGeometry(blockGeometry);
+  // chunks share the textures of the terrain geometry => released first
+  cleanupTerrainChunks();
   cleanupMultipleGeometry(terrainGeometry);
   cleanupMultipleGeometry(penguinGeometry);
   cleanupMultipleGeometry(sparrowGeometry);
+  glDeleteTextures(1, &sparrowInstanceTexture);
+  glDeleteBuffers(1, &sparrowInstanceBuffer);
+  sparrowInstanceTexture = 0;
+  sparrowInstanceBuffer = 0;
   cleanupMultipleGeometry(catGeometry);
   cleanupMultipleGeometry(rockGeometry);
   cleanupMultipleGeometry(fernGeometry);
   cleanupMultipleGeometry(stoneGeometry);
   cleanupMultipleGeometry(targetGeometry);
   cleanupMultipleGeometry(palmTreeGeometry);
+  cleanupImpostorAtlas(palmTreeImpostor);
+  cleanupImpostors();
   cleanupMultipleGeometry(campfireGeometry);
 }
 
@@ -11,6 +11,7 @@
 #define __RENDER_H
 
 #include "data.h"
+#include "objects.h"
 
 // defines geometry of object in the scene (space ship, ufo, etc.)
 // geometry is shared among all instances of the same object type
@@ -28,93 +29,6 @@ typedef struct _MeshGeometry {
 
 } MeshGeometry;
 
-// parameters of individual objects in the scene (e.g. position, size, speed, etc.)
-typedef struct _Object {
-  glm::vec3 position;
-  glm::vec3 direction;
-  float     speed;
-  float     size;
-
-  bool destroyed;
-
-  float startTime;
-  float currentTime;
-
-} Object;
-
-typedef struct TerrainObject : public Object {
-
-} TerrainObject;
-
-typedef struct PenguinObject : public Object {
-
-	float viewAngle; // in degrees
-
-} PenguinObject;
-
-typedef struct SparrowObject : public Object {
-
-	float rotationSpeed;
-	float currentAngle;
-
-} SparrowObject;
-
-typedef struct CatObject : public Object { 
-
-} CatObject;
-
-typedef struct RockObject : public Object { 
-
-} RockObject;
-
-typedef struct FernObject : public Object {
-
-} FernObject;
-
-typedef struct StoneObject : public Object { 
-
-} StoneObject;
-
-typedef struct TargetObject : public Object {
-	glm::vec3 initPosition;
-	float rotationSpeed;
-
-} TargetObject;
-
-typedef struct PalmTreeObject : public Object { 
-
-} PalmTreeObject;
-
-typedef struct CampfireObject : public Object {
-
-} CampfireObject;
-
-typedef struct BlockObject : public Object {
-
-} BlockObject;
-
-typedef struct MissileObject : public Object {
-
-} MissileObject;
-
-typedef struct UfoObject : public Object {
-
-  float     rotationSpeed;
-  glm::vec3 initPosition;
-
-} UfoObject;
-
-typedef struct ExplosionObject : public Object {
-
-  int    textureFrames;
-  float  frameDuration;
-
-} ExplosionObject;
-
-typedef struct BannerObject : public Object {
-
-} BannerObject;
-
 typedef struct _commonShaderProgram {
   // identifier for the shader program
   GLuint program;          // = 0;
@@ -123,6 +37,7 @@ typedef struct _commonShaderProgram {
   GLint colorLocation;     // = -1;
   GLint normalLocation;    // = -1;
   GLint texCoordLocation;  // = -1;
+  GLint swayWeightLocation; // = -1; wind sway weight of the vegetation
   // uniforms locations
   GLint PVMmatrixLocation;    // = -1;
   GLint VmatrixLocation;      // = -1;  view/camera matrix
@@ -130,6 +45,7 @@ typedef struct _commonShaderProgram {
   GLint normalMatrixLocation; // = -1;  inverse transposed Mmatrix
 
   GLint timeLocation;         // = -1; elapsed time in seconds
+  GLint windLocation;         // = -1; wind direction * strength (world coordinates)
 
   //pointlight
   GLint pointLightLoc;
@@ -144,6 +60,13 @@ typedef struct _commonShaderProgram {
   GLint fogOnNearLoc;
   GLint fogOnDensityLoc;
 
+  // cross-fade with impostors
+  GLint fadeLocation;       // = -1;
+
+  // instanced drawing
+  GLint instancedLocation;  // = -1;
+  GLint instancesLocation;  // = -1; texture buffer with the instance transforms (unit 1)
+
   // material 
   GLint diffuseLocation;    // = -1;
   GLint ambientLocation;    // = -1;
@@ -158,24 +81,30 @@ typedef struct _commonShaderProgram {
 } SCommonShaderProgram;
 
 
-glm::vec3 checkBounds(const glm::vec3 & position, float objectSize = 1.0f);
+/// Compiles a shader from a file with the code of commonFileName inserted after its #version line (0 on failure).
+GLuint createShaderWithCommonFile(GLenum shaderType, const std::string& commonFileName, const std::string& fileName);
+
+void setTransformUniforms(const glm::mat4 & modelMatrix, const glm::mat4 & viewMatrix, const glm::mat4 & projectionMatrix);
+void setMaterialUniforms(const glm::vec3 & ambient, const glm::vec3 & diffuse, const glm::vec3 & specular, float shininess, GLuint texture);
 //WIP
 
-void drawTerrain(TerrainObject* terrain, const glm::mat4 & viewMatrix, const glm::mat4 & projectionMatrix);
-void drawPenguin(PenguinObject* penguin, const glm::mat4 & viewMatrix, const glm::mat4 & projectionMatrix);
-void drawSparrow(SparrowObject* sparrow, const glm::mat4 & viewMatrix, const glm::mat4 & projectionMatrix);
-void drawCat(CatObject* cat, const glm::mat4 & viewMatrix, const glm::mat4 & projectionMatrix);
-void drawRock(RockObject* rock, const glm::mat4 & viewMatrix, const glm::mat4 & projectionMatrix);
-void drawFern(FernObject* fern, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix);
-void drawStone(StoneObject* stone, const glm::mat4 & viewMatrix, const glm::mat4 & projectionMatrix);
-void drawTarget(TargetObject* target, const glm::mat4 & viewMatrix, const glm::mat4 & projectionMatrix);
-void drawPalmTree(PalmTreeObject* palmTree, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix);
-void drawCampfire(CampfireObject* campfire, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix);
-void drawBlock(BlockObject* block, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix);
-
-void drawMissile(MissileObject* missile, const glm::mat4 & viewMatrix, const glm::mat4 & projectionMatrix);
-void drawExplosion(ExplosionObject* explosion, const glm::mat4 & viewMatrix, const glm::mat4 & projectionMatrix);
-void drawBanner(BannerObject* banner, const glm::mat4 & viewMatrix, const glm::mat4 & projectionMatrix);
+void drawTerrain(const TerrainObject* terrain, const glm::mat4 & viewMatrix, const glm::mat4 & projectionMatrix);
+void drawPenguin(const PenguinObject* penguin, const glm::mat4 & viewMatrix, const glm::mat4 & projectionMatrix);
+void drawSparrow(const SparrowObject* sparrow, const glm::mat4 & viewMatrix, const glm::mat4 & projectionMatrix);
+void drawSparrows(const std::vector<SparrowObject>& sparrows, const glm::mat4 & viewMatrix, const glm::mat4 & projectionMatrix);
+void drawCat(const CatObject* cat, const glm::mat4 & viewMatrix, const glm::mat4 & projectionMatrix);
+void drawRock(const RockObject* rock, const glm::mat4 & viewMatrix, const glm::mat4 & projectionMatrix);
+void drawFern(const FernObject* fern, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix);
+void drawStone(const StoneObject* stone, const glm::mat4 & viewMatrix, const glm::mat4 & projectionMatrix);
+void drawTarget(const TargetObject* target, const glm::mat4 & viewMatrix, const glm::mat4 & projectionMatrix);
+void drawPalmTree(const PalmTreeObject* palmTree, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix, float fade = 1.0f);
+void drawPalmTrees(const std::vector<const PalmTreeObject*>& palmTrees, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix);
+void drawCampfire(const CampfireObject* campfire, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix);
+void drawBlock(const BlockObject* block, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix);
+
+void drawMissile(const MissileObject* missile, const glm::mat4 & viewMatrix, const glm::mat4 & projectionMatrix);
+void drawExplosions(const std::vector<const ExplosionObject*>& explosions, const glm::mat4 & viewMatrix, const glm::mat4 & projectionMatrix, float time);
+void drawBanner(const BannerObject* banner, const glm::mat4 & viewMatrix, const glm::mat4 & projectionMatrix);
 void drawSkybox(const glm::mat4 & viewMatrix, const glm::mat4 & projectionMatrix);
 
 void initializeShaderPrograms();
@@ -0,0 +1,272 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    replay.cpp
+ * \author  Sean Phay
+ * \date    2023
+ * \brief   Recording and replay of the input events, seeded random numbers of the simulation.
+ */
+//----------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "replay.h"
+
+// file starts with magic, version and seed (3 x 4 bytes), then come the events
+const char REPLAY_MAGIC[4] = { 'F', 'R', 'P', 'L' };
+const unsigned int REPLAY_VERSION = 3;  // 2: 32-bit pick ids instead of the stencil values, 3: time within the step
+const unsigned int REPLAY_VERSION_MIN = 2;  // version 2 has zeros in place of the times - the same run
+const int REPLAY_EVENT_BYTES = 12;
+
+std::mt19937 simulationEngine;
+std::mt19937 decorationEngine;
+
+std::ofstream recordFile;
+
+std::vector<InputEvent> replayEvents;
+size_t replayPosition = 0;
+unsigned int replayLength = 0;
+std::atomic<bool> replaying(false);  // read by the window thread as well
+
+// live event with the wall clock time it arrived at
+typedef struct _QueuedInputEvent {
+  InputEvent event;
+  std::chrono::steady_clock::time_point time;
+} QueuedInputEvent;
+
+// live events waiting for the next simulation step - a ring with one writer and one reader,
+// the counters only grow, the slot of a counter value is value % INPUT_QUEUE_CAPACITY
+const size_t INPUT_QUEUE_CAPACITY = 256;
+QueuedInputEvent inputQueue[INPUT_QUEUE_CAPACITY];
+std::atomic<size_t> inputQueueWritten(0);  // changed by the window thread only
+std::atomic<size_t> inputQueueRead(0);     // changed by the simulation thread only
+
+// the step closed by closeInputStep(), used by the simulation thread only
+size_t inputStepWritten = 0;
+std::chrono::steady_clock::time_point inputStepStart;
+std::chrono::steady_clock::time_point inputStepEnd;
+
+// ----------------------------------------------------------------------------------------
+// START OF HELPER FUNCTIONS
+
+void writeUnsigned(unsigned char* bytes, unsigned int value, int count) {
+  for (int i = 0; i < count; i++)
+    bytes[i] = (unsigned char)(value >> (8 * i));
+}
+
+unsigned int readUnsigned(const unsigned char* bytes, int count) {
+  unsigned int value = 0;
+  for (int i = 0; i < count; i++)
+    value |= (unsigned int)bytes[i] << (8 * i);
+  return value;
+}
+
+// END OF HELPER FUNCTIONS
+// ----------------------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------------------
+// START OF RANDOM FUNCTIONS
+
+void seedSimulationRandom(unsigned int seed) {
+  simulationEngine.seed(seed);
+  decorationEngine.seed(seed ^ 0x9e3779b9u);
+}
+
+float simulationRandom() {
+  // made by hand - std::uniform_real_distribution differs between the standard libraries
+  return (simulationEngine() >> 8) * (1.0f / 16777215.0f);
+}
+
+float decorationRandom() {
+  return (decorationEngine() >> 8) * (1.0f / 16777215.0f);
+}
+
+// END OF RANDOM FUNCTIONS
+// ----------------------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------------------
+// START OF RECORDING FUNCTIONS
+
+bool startRecording(const std::string& fileName, unsigned int seed) {
+  recordFile.open(fileName.c_str(), std::ios::binary | std::ios::trunc);
+  if (!recordFile) {
+    std::cerr << "startRecording(): Cannot create file \"" << fileName << "\"." << std::endl;
+    return false;
+  }
+
+  unsigned char header[12];
+  for (int i = 0; i < 4; i++)
+    header[i] = (unsigned char)REPLAY_MAGIC[i];
+  writeUnsigned(header + 4, REPLAY_VERSION, 4);
+  writeUnsigned(header + 8, seed, 4);
+  recordFile.write((const char*)header, sizeof(header));
+
+  return true;
+}
+
+void recordInputEvent(const InputEvent& event) {
+  if (!recordFile.is_open())
+    return;
+
+  unsigned char bytes[REPLAY_EVENT_BYTES];
+  writeUnsigned(bytes + 0, event.tick, 4);
+  bytes[4] = event.type;
+  bytes[5] = event.time;
+  writeUnsigned(bytes + 6, event.key, 2);
+  writeUnsigned(bytes + 8, (unsigned short)event.x, 2);
+  writeUnsigned(bytes + 10, (unsigned short)event.y, 2);
+  recordFile.write((const char*)bytes, sizeof(bytes));
+}
+
+void stopRecording(unsigned int tick) {
+  if (!recordFile.is_open())
+    return;
+
+  InputEvent event = {};
+  event.tick = tick;
+  event.type = INPUT_END;
+  recordInputEvent(event);
+  recordFile.close();
+}
+
+bool isRecording() {
+  return recordFile.is_open();
+}
+
+// END OF RECORDING FUNCTIONS
+// ----------------------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------------------
+// START OF REPLAY FUNCTIONS
+
+bool startReplay(const std::string& fileName, unsigned int& seed) {
+  std::ifstream file(fileName.c_str(), std::ios::binary);
+  if (!file) {
+    std::cerr << "startReplay(): Cannot open file \"" << fileName << "\"." << std::endl;
+    return false;
+  }
+
+  unsigned char header[12];
+  if (!file.read((char*)header, sizeof(header)) ||
+      std::string((const char*)header, 4) != std::string(REPLAY_MAGIC, 4) ||
+      readUnsigned(header + 4, 4) < REPLAY_VERSION_MIN || readUnsigned(header + 4, 4) > REPLAY_VERSION) {
+    std::cerr << "startReplay(): \"" << fileName << "\" is not a recording of this version." << std::endl;
+    return false;
+  }
+  seed = readUnsigned(header + 8, 4);
+
+  replayEvents.clear();
+  replayPosition = 0;
+  replayLength = 0;
+
+  unsigned char bytes[REPLAY_EVENT_BYTES];
+  bool ended = false;
+  while (!ended && file.read((char*)bytes, sizeof(bytes))) {
+    InputEvent event;
+    event.tick = readUnsigned(bytes + 0, 4);
+    event.type = bytes[4];
+    event.time = bytes[5];
+    event.key = (unsigned short)readUnsigned(bytes + 6, 2);
+    event.x = (short)readUnsigned(bytes + 8, 2);
+    event.y = (short)readUnsigned(bytes + 10, 2);
+
+    if (event.type >= INPUT_TYPES_COUNT) {
+      std::cerr << "startReplay(): Unknown event in \"" << fileName << "\"." << std::endl;
+      replayEvents.clear();
+      return false;
+    }
+
+    if (event.type == INPUT_END) {
+      replayLength = event.tick;
+      ended = true;
+    }
+    else
+      replayEvents.push_back(event);
+  }
+
+  // recording of a crashed run - replay what was written
+  if (!ended) {
+    std::cerr << "startReplay(): \"" << fileName << "\" is truncated." << std::endl;
+    replayLength = replayEvents.empty() ? 0 : replayEvents.back().tick + 1;
+  }
+
+  replaying = true;
+  return true;
+}
+
+bool nextReplayEvent(unsigned int tick, InputEvent& event) {
+  if (!replaying || replayPosition >= replayEvents.size() || replayEvents[replayPosition].tick > tick)
+    return false;
+
+  event = replayEvents[replayPosition++];
+  return true;
+}
+
+bool replayFinished(unsigned int tick) {
+  return replaying && tick >= replayLength;
+}
+
+bool isReplaying() {
+  return replaying;
+}
+
+void stopReplay() {
+  replayEvents.clear();
+  replayPosition = 0;
+  replaying = false;
+}
+
+void queueInputEvent(int type, int key, int x, int y) {
+  const size_t written = inputQueueWritten.load(std::memory_order_relaxed);
+  if (written - inputQueueRead.load(std::memory_order_acquire) >= INPUT_QUEUE_CAPACITY) {
+    std::cerr << "queueInputEvent(): The input queue is full, the event is dropped." << std::endl;
+    return;
+  }
+
+  QueuedInputEvent& queued = inputQueue[written % INPUT_QUEUE_CAPACITY];
+  queued.event.tick = 0;
+  queued.event.type = (unsigned char)type;
+  queued.event.time = 0;
+  queued.event.key = (unsigned short)key;
+  queued.event.x = (short)x;
+  queued.event.y = (short)y;
+  queued.time = std::chrono::steady_clock::now();
+
+  // the slot is filled before the reader can see it
+  inputQueueWritten.store(written + 1, std::memory_order_release);
+}
+
+void closeInputStep() {
+  // the counter first - every event it covers was stamped before the end of the step
+  inputStepWritten = inputQueueWritten.load(std::memory_order_acquire);
+
+  const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  inputStepStart = (inputStepEnd == std::chrono::steady_clock::time_point()) ? now : inputStepEnd;
+  inputStepEnd = now;
+}
+
+bool nextQueuedInputEvent(InputEvent& event) {
+  const size_t read = inputQueueRead.load(std::memory_order_relaxed);
+  if (read == inputStepWritten)
+    return false;
+
+  const QueuedInputEvent& queued = inputQueue[read % INPUT_QUEUE_CAPACITY];
+  event = queued.event;
+
+  // arrival within the step, the events queued while the previous step was closed count from its start
+  const double step = std::chrono::duration<double>(inputStepEnd - inputStepStart).count();
+  const double arrival = std::chrono::duration<double>(queued.time - inputStepStart).count();
+  const double fraction = step > 0.0 ? arrival / step : 0.0;
+  event.time = (unsigned char)std::min(std::max(fraction * INPUT_STEP_FRACTION, 0.0), INPUT_STEP_FRACTION - 1.0);
+
+  // the slot can be written again
+  inputQueueRead.store(read + 1, std::memory_order_release);
+  return true;
+}
+
+// END OF REPLAY FUNCTIONS
+// ----------------------------------------------------------------------------------------
@@ -0,0 +1,130 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    replay.h
+ * \author  Sean Phay
+ * \date    2023
+ * \brief   Recording and replay of the input events, seeded random numbers of the simulation.
+ */
+//----------------------------------------------------------------------------------------
+
+#ifndef __REPLAY_H
+#define __REPLAY_H
+
+#include <string>
+
+// types of the recorded events
+enum {
+  INPUT_KEY_DOWN,       // key = ASCII code
+  INPUT_KEY_UP,
+  INPUT_SPECIAL_DOWN,   // key = GLUT_KEY_* code
+  INPUT_SPECIAL_UP,
+  INPUT_CAMERA_TILT,    // y = pixels the mouse moved up in the first person view
+  INPUT_PICK,           // key, x = low and high 16 bits of the id of the clicked object (PICK_ID)
+  INPUT_MENU,           // key = menu (one of INPUT_MENU_*), x = menu item
+  INPUT_END,            // last event of the recording, tick = length of the run
+  INPUT_TYPES_COUNT
+};
+
+// resolution of InputEvent::time - the arrival within the step is time / INPUT_STEP_FRACTION
+const float INPUT_STEP_FRACTION = 256.0f;
+
+// menus of the application
+enum { INPUT_MENU_MAIN, INPUT_MENU_CAMERA, INPUT_MENU_FOG, INPUT_MENU_LIGHT };
+
+// one input event - stored as 12 bytes (little endian) in the file
+typedef struct _InputEvent {
+  unsigned int   tick;  // simulation step the event arrived in
+  unsigned char  type;  // one of the INPUT_* values
+  unsigned char  time;  // arrival within the step, 0 ... 255 = start ... end (INPUT_STEP_FRACTION)
+  unsigned short key;
+  short          x;
+  short          y;
+} InputEvent;
+
+//**************************************************************************************************
+/// Seeds the random generator used by the simulation (teleport, random positions, ...).
+/**
+ The generator gives the same sequence with every compiler and standard library, so a replay
+ started with the recorded seed makes exactly the same decisions as the recorded run.
+*/
+void seedSimulationRandom(unsigned int seed);
+
+/// Uniform random value in range 0.0f ... 1.0f.
+float simulationRandom();
+
+/// Uniform random value in range 0.0f ... 1.0f for the scenery the game does not depend on (the flock).
+/**
+ A separate generator seeded by seedSimulationRandom(), drawing from it does not move the
+ sequence of simulationRandom(), so the recordings made without the flock still replay the same.
+*/
+float decorationRandom();
+
+//**************************************************************************************************
+/// Opens the file the input events are written to.
+/**
+ \param[in]  fileName    Output file, overwritten.
+ \param[in]  seed        Seed of the simulation random generator stored in the header.
+ \return                 True if the file was created.
+*/
+bool startRecording(const std::string& fileName, unsigned int seed);
+
+/// Appends one event to the recording with its tick and time (does nothing when not recording).
+void recordInputEvent(const InputEvent& event);
+
+/// Writes the INPUT_END event and closes the file.
+void stopRecording(unsigned int tick);
+
+/// True while the input is being recorded.
+bool isRecording();
+
+//**************************************************************************************************
+/// Loads a recording to be replayed.
+/**
+ \param[in]  fileName    Recorded file.
+ \param[out] seed        Seed of the simulation random generator of the recorded run.
+ \return                 True if the file is a valid recording.
+*/
+bool startReplay(const std::string& fileName, unsigned int& seed);
+
+//**************************************************************************************************
+/// Takes the next recorded event which arrived before the end of a given tick.
+/**
+ Call it repeatedly at the start of a simulation step until it returns false.
+
+ \param[in]  tick        Last finished simulation step.
+ \param[out] event       The event.
+ \return                 False when there is no more event for this tick.
+*/
+bool nextReplayEvent(unsigned int tick, InputEvent& event);
+
+/// True once the replay reached the INPUT_END event.
+bool replayFinished(unsigned int tick);
+
+/// True while a recording is being replayed (the live input is ignored).
+bool isReplaying();
+
+/// Releases the loaded recording.
+void stopReplay();
+
+//**************************************************************************************************
+/// Hands a live input event from the window thread to the simulation thread.
+/**
+ The event is stamped with the wall clock time and put into a lock-free ring buffer (one writer,
+ the window thread, and one reader, the simulation thread). When the ring is full, the event is
+ dropped. The simulation takes the events at the start of its next step, records them with the
+ tick they are applied in and applies them, exactly like the events of a replay.
+*/
+void queueInputEvent(int type, int key = 0, int x = 0, int y = 0);
+
+/// Ends the live input of a step - the events queued until now are taken by nextQueuedInputEvent().
+/**
+ The wall clock time between the previous call and this one is the step the events are placed in,
+ the time of every taken event is its arrival within this interval. Call it from the simulation
+ thread once per step, before taking the events.
+*/
+void closeInputStep();
+
+/// Takes the oldest event queued before closeInputStep() (the tick is not set). False if there is none.
+bool nextQueuedInputEvent(InputEvent& event);
+
+#endif // __REPLAY_H
@@ -0,0 +1,313 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    scatter.cpp
+ * \author  Sean Phay
+ * \date    2023
+ * \brief   Procedural placement of the scenery (Poisson-disk sampling).
+ */
+//----------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <random>
+#include <thread>
+#include "scatter.h"
+
+// ----------------------------------------------------------------------------------------
+// START OF HELPER STRUCTURES
+
+// number of candidates tested around each active sample (Bridson's k)
+const int SCATTER_CANDIDATES = 30;
+// upper limit of tiles along one side of the area
+const int SCATTER_MAX_TILES = 16;
+
+// random generator of one tile - floats are made by hand so that the placement
+// is the same with every standard library (distributions are implementation defined)
+struct TileRandom {
+  std::mt19937 engine;
+
+  TileRandom(unsigned int seed, unsigned int layer, unsigned int tile) {
+    std::seed_seq sequence = { seed, layer, tile };
+    engine.seed(sequence);
+  }
+
+  // uniform value in range 0.0f ... 1.0f
+  float uniform() {
+    return (engine() >> 8) * (1.0f / 16777216.0f);
+  }
+
+  // uniform integer in range 0 ... count-1
+  size_t index(size_t count) {
+    return size_t(engine()) % count;
+  }
+};
+
+// coarse grid of the already occupied circles (x, y, radius) - previous layers and reserved places
+struct OccupancyGrid {
+  glm::vec2 origin;
+  float     cellSize;
+  int       cols;
+  int       rows;
+  float     maxRadius;
+  std::vector<std::vector<glm::vec3> > cells;
+
+  void init(const glm::vec2& areaMin, const glm::vec2& areaMax, float largestRadius) {
+    maxRadius = largestRadius;
+    cellSize = std::max(2.0f * largestRadius, 1e-3f);
+    origin = areaMin;
+    cols = std::max(1, int(std::ceil((areaMax.x - areaMin.x) / cellSize)));
+    rows = std::max(1, int(std::ceil((areaMax.y - areaMin.y) / cellSize)));
+    cells.assign(cols * rows, std::vector<glm::vec3>());
+  }
+
+  void insert(const glm::vec3& circle) {
+    int cx = glm::clamp(int((circle.x - origin.x) / cellSize), 0, cols - 1);
+    int cy = glm::clamp(int((circle.y - origin.y) / cellSize), 0, rows - 1);
+    cells[cy * cols + cx].push_back(circle);
+  }
+
+  // true if the circle (position, radius) does not overlap any stored circle
+  bool isFree(const glm::vec2& position, float radius) const {
+    float reach = radius + maxRadius;
+    int x0 = glm::clamp(int((position.x - reach - origin.x) / cellSize), 0, cols - 1);
+    int x1 = glm::clamp(int((position.x + reach - origin.x) / cellSize), 0, cols - 1);
+    int y0 = glm::clamp(int((position.y - reach - origin.y) / cellSize), 0, rows - 1);
+    int y1 = glm::clamp(int((position.y + reach - origin.y) / cellSize), 0, rows - 1);
+
+    for (int y = y0; y <= y1; y++) {
+      for (int x = x0; x <= x1; x++) {
+        const std::vector<glm::vec3>& cell = cells[y * cols + x];
+        for (size_t i = 0; i < cell.size(); i++) {
+          glm::vec2 delta = position - glm::vec2(cell[i].x, cell[i].y);
+          float minimum = radius + cell[i].z;
+          if (glm::dot(delta, delta) < minimum * minimum)
+            return false;
+        }
+      }
+    }
+    return true;
+  }
+};
+
+// background grid of one layer - the cell is small enough to hold at most one sample
+struct SampleGrid {
+  glm::vec2 origin;
+  float     cellSize;
+  int       cols;
+  int       rows;
+  std::vector<glm::vec2>     samples;
+  std::vector<unsigned char> used;
+
+  int cellX(float x) const { return glm::clamp(int((x - origin.x) / cellSize), 0, cols - 1); }
+  int cellY(float y) const { return glm::clamp(int((y - origin.y) / cellSize), 0, rows - 1); }
+
+  void insert(const glm::vec2& sample) {
+    int index = cellY(sample.y) * cols + cellX(sample.x);
+    samples[index] = sample;
+    used[index] = 1;
+  }
+
+  // true if there is no sample closer than minDistance
+  bool isFree(const glm::vec2& position, float minDistance) const {
+    int cx = cellX(position.x);
+    int cy = cellY(position.y);
+
+    for (int y = std::max(cy - 2, 0); y <= std::min(cy + 2, rows - 1); y++) {
+      for (int x = std::max(cx - 2, 0); x <= std::min(cx + 2, cols - 1); x++) {
+        int index = y * cols + x;
+        if (used[index] == 0)
+          continue;
+        glm::vec2 delta = position - samples[index];
+        if (glm::dot(delta, delta) < minDistance * minDistance)
+          return false;
+      }
+    }
+    return true;
+  }
+};
+
+// runs job(0) ... job(count-1) on all available cores
+void runParallel(int count, const std::function<void(int)>& job) {
+  int threadCount = std::min(count, std::max(1, int(std::thread::hardware_concurrency())));
+
+  if (threadCount <= 1) {
+    for (int i = 0; i < count; i++)
+      job(i);
+    return;
+  }
+
+  std::atomic<int> next(0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < threadCount; t++) {
+    threads.push_back(std::thread([&]() {
+      for (int i = next++; i < count; i = next++)
+        job(i);
+    }));
+  }
+  for (size_t t = 0; t < threads.size(); t++)
+    threads[t].join();
+}
+
+// END OF HELPER STRUCTURES
+// ----------------------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------------------
+// START OF SCATTERING FUNCTIONS
+
+// Bridson's algorithm restricted to one tile of the layer
+void scatterTile(
+    const ScatterLayer&  layer,
+    const glm::vec2&     tileMin,
+    const glm::vec2&     tileMax,
+    SampleGrid&          grid,
+    const OccupancyGrid& occupancy,
+    TileRandom&          random,
+    std::vector<glm::vec2>& result
+) {
+  const float r = layer.minDistance;
+  std::vector<glm::vec2> active;
+
+  // candidate is valid when it lies in the tile, keeps the Poisson-disk distance and is not covered
+  auto accept = [&](const glm::vec2& candidate) {
+    if (candidate.x < tileMin.x || candidate.x >= tileMax.x || candidate.y < tileMin.y || candidate.y >= tileMax.y)
+      return false;
+    return grid.isFree(candidate, r) && occupancy.isFree(candidate, layer.exclusionRadius);
+  };
+
+  // the first sample - try a few random places, the tile may be partly covered by other layers
+  for (int attempt = 0; attempt < SCATTER_CANDIDATES; attempt++) {
+    glm::vec2 candidate(
+      tileMin.x + random.uniform() * (tileMax.x - tileMin.x),
+      tileMin.y + random.uniform() * (tileMax.y - tileMin.y)
+    );
+    if (accept(candidate)) {
+      grid.insert(candidate);
+      active.push_back(candidate);
+      result.push_back(candidate);
+      break;
+    }
+  }
+
+  while (!active.empty()) {
+    size_t index = random.index(active.size());
+    glm::vec2 sample = active[index];
+    bool found = false;
+
+    // candidates are generated in the annulus r ... 2r around the active sample
+    for (int k = 0; k < SCATTER_CANDIDATES; k++) {
+      float angle = 6.2831853f * random.uniform();
+      float distance = r * (1.0f + random.uniform());
+      glm::vec2 candidate = sample + distance * glm::vec2(std::cos(angle), std::sin(angle));
+
+      if (accept(candidate)) {
+        grid.insert(candidate);
+        active.push_back(candidate);
+        result.push_back(candidate);
+        found = true;
+        break;
+      }
+    }
+
+    if (found == false) {
+      active[index] = active.back();
+      active.pop_back();
+    }
+  }
+}
+
+std::vector<ScatterPoint> scatterScenery(
+    const ScatterLayer            layers[],
+    const int                     layerCount,
+    const glm::vec2&              areaMin,
+    const glm::vec2&              areaMax,
+    const std::vector<glm::vec3>& reserved,
+    unsigned int                  seed
+) {
+  std::vector<ScatterPoint> result;
+  const glm::vec2 areaSize = areaMax - areaMin;
+
+  if (areaSize.x <= 0.0f || areaSize.y <= 0.0f)
+    return result;
+
+  // everything which must be avoided by the later layers
+  float largestRadius = 0.0f;
+  for (int l = 0; l < layerCount; l++)
+    largestRadius = std::max(largestRadius, layers[l].exclusionRadius);
+  for (size_t i = 0; i < reserved.size(); i++)
+    largestRadius = std::max(largestRadius, reserved[i].z);
+
+  OccupancyGrid occupancy;
+  occupancy.init(areaMin, areaMax, largestRadius);
+  for (size_t i = 0; i < reserved.size(); i++)
+    occupancy.insert(reserved[i]);
+
+  for (int l = 0; l < layerCount; l++) {
+    const ScatterLayer& layer = layers[l];
+
+    if (layer.minDistance <= 0.0f || layer.density <= 0.0f)
+      continue;
+
+    // tiles are at least 3*minDistance wide => the grid lookups (two cells around the candidate)
+    // of two non-neighbouring tiles never touch the same cell
+    int tilesX = glm::clamp(int(areaSize.x / (3.0f * layer.minDistance)), 1, SCATTER_MAX_TILES);
+    int tilesY = glm::clamp(int(areaSize.y / (3.0f * layer.minDistance)), 1, SCATTER_MAX_TILES);
+    glm::vec2 tileSize(areaSize.x / tilesX, areaSize.y / tilesY);
+
+    SampleGrid grid;
+    grid.origin = areaMin;
+    grid.cellSize = layer.minDistance / 1.41421356f;
+    grid.cols = int(std::ceil(areaSize.x / grid.cellSize));
+    grid.rows = int(std::ceil(areaSize.y / grid.cellSize));
+    grid.samples.assign(grid.cols * grid.rows, glm::vec2(0.0f));
+    grid.used.assign(grid.cols * grid.rows, 0);
+
+    std::vector<std::vector<glm::vec2> > tileSamples(tilesX * tilesY);
+
+    // four passes (2x2 checkerboard) => tiles running concurrently are never neighbours
+    for (int pass = 0; pass < 4; pass++) {
+      std::vector<int> passTiles;
+      for (int ty = pass / 2; ty < tilesY; ty += 2)
+        for (int tx = pass % 2; tx < tilesX; tx += 2)
+          passTiles.push_back(ty * tilesX + tx);
+
+      runParallel(int(passTiles.size()), [&](int i) {
+        int tile = passTiles[i];
+        glm::vec2 tileMin = areaMin + glm::vec2(float(tile % tilesX) * tileSize.x, float(tile / tilesX) * tileSize.y);
+        glm::vec2 tileMax = tileMin + tileSize;
+        TileRandom random(seed, (unsigned int)l, (unsigned int)tile);
+
+        scatterTile(layer, tileMin, tileMax, grid, occupancy, random, tileSamples[tile]);
+      });
+    }
+
+    // merge tiles in their order - independent of the thread scheduling
+    std::vector<glm::vec2> samples;
+    for (size_t t = 0; t < tileSamples.size(); t++)
+      samples.insert(samples.end(), tileSamples[t].begin(), tileSamples[t].end());
+
+    // thin the layer down to the required density (removing samples keeps the blue-noise property)
+    size_t maxCount = size_t(layer.density * areaSize.x * areaSize.y);
+    if (samples.size() > maxCount) {
+      TileRandom random(seed, (unsigned int)l, 0xFFFFFFFFu);
+      for (size_t i = samples.size() - 1; i > 0; i--)
+        std::swap(samples[i], samples[random.index(i + 1)]);
+      samples.resize(maxCount);
+    }
+
+    for (size_t i = 0; i < samples.size(); i++) {
+      ScatterPoint point;
+      point.position = samples[i];
+      point.type = layer.type;
+      result.push_back(point);
+
+      occupancy.insert(glm::vec3(samples[i], layer.exclusionRadius));
+    }
+  }
+
+  return result;
+}
+
+// END OF SCATTERING FUNCTIONS
+// ----------------------------------------------------------------------------------------
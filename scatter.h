@@ -0,0 +1,59 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    scatter.h
+ * \author  Sean Phay
+ * \date    2023
+ * \brief   Procedural placement of the scenery (Poisson-disk sampling).
+ */
+//----------------------------------------------------------------------------------------
+
+#ifndef __SCATTER_H
+#define __SCATTER_H
+
+#include <vector>
+#include <glm/glm.hpp>
+
+// types of the scenery objects which can be scattered over the terrain
+enum { SCATTER_PALM_TREE, SCATTER_FERN, SCATTER_STONE, SCATTER_ROCK, SCATTER_TYPES_COUNT };
+
+// parameters of one scattered object type (one layer of the placement)
+typedef struct _ScatterLayer {
+  int   type;             // one of the SCATTER_* values
+  float minDistance;      // minimal distance between two objects of this layer (Poisson-disk radius)
+  float exclusionRadius;  // footprint of the object, kept free of objects from the other layers
+  float density;          // maximal number of objects per unit of area
+} ScatterLayer;
+
+// one generated object
+typedef struct _ScatterPoint {
+  glm::vec2 position;     // position on the terrain (x, y)
+  int       type;         // layer type the point belongs to
+} ScatterPoint;
+
+//**************************************************************************************************
+/// Scatters scenery objects over a rectangular area using blue-noise (Poisson-disk) sampling.
+/**
+ Layers are processed in the given order, so the objects of the first layers win the space
+ over the later ones. Each layer is sampled tile by tile, tiles are generated on several threads
+ in four passes so that two tiles processed at the same time are never neighbours.
+ Every tile uses its own random generator derived from \a seed, therefore the result depends only
+ on the parameters and not on the number of threads or on their scheduling.
+
+ \param[in]  layers        Array of the layer descriptions.
+ \param[in]  layerCount    Number of the layers.
+ \param[in]  areaMin       Lower left corner of the area.
+ \param[in]  areaMax       Upper right corner of the area.
+ \param[in]  reserved      Circles (x, y, radius) which must be kept free (hand placed objects).
+ \param[in]  seed          Seed of the placement.
+ \return                   Generated points of all layers.
+*/
+std::vector<ScatterPoint> scatterScenery(
+    const ScatterLayer            layers[],
+    const int                     layerCount,
+    const glm::vec2&              areaMin,
+    const glm::vec2&              areaMax,
+    const std::vector<glm::vec3>& reserved,
+    unsigned int                  seed
+);
+
+#endif // __SCATTER_H
@@ -0,0 +1,135 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    simulation.cpp
+ * \author  Sean Phay
+ * \date    2023
+ * \brief   Update of the moving objects of the scene - no OpenGL state.
+ */
+//----------------------------------------------------------------------------------------
+
+#include "simulation.h"
+#include "collision.h"
+#include "jobs.h"
+#include "data.h"
+
+// moves one missile, flags it destroyed when it flew too far
+void moveMissile(MissileObject* missile, float elapsedTime) {
+
+	// update missile
+	float timeDelta = elapsedTime - missile->currentTime;
+
+	missile->currentTime = elapsedTime;
+	missile->position += timeDelta * missile->speed * missile->direction;
+
+	// check the new position and wrap it if it is necessary
+	missile->position = checkBounds(missile->position, missile->size);
+
+	if ((missile->currentTime - missile->startTime)*missile->speed > MISSILE_MAX_DISTANCE)
+		missile->destroyed = true;
+}
+
+// advances one explosion, flags it destroyed after its last frame
+void advanceExplosion(ExplosionObject* explosion, float elapsedTime) {
+
+	// update explosion
+	explosion->currentTime = elapsedTime;
+
+	if (explosion->currentTime > explosion->startTime + explosion->textureFrames*explosion->frameDuration)
+		explosion->destroyed = true;
+}
+
+// deletes the destroyed objects - always in the order of the list, whichever thread flagged them
+template <typename ObjectType>
+void removeDestroyedObjects(GameObjectsList& objects) {
+
+	GameObjectsList::iterator it = objects.begin();
+	while (it != objects.end()) {
+		ObjectType* object = (ObjectType*)(*it);
+
+		if (object->destroyed == true) {
+			delete object;
+			it = objects.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+}
+
+void updateMissiles(GameObjectsList& missiles, float elapsedTime) {
+
+	for (GameObjectsList::iterator it = missiles.begin(); it != missiles.end(); ++it)
+		moveMissile((MissileObject*)(*it), elapsedTime);
+
+	removeDestroyedObjects<MissileObject>(missiles);
+}
+
+void updateExplosions(GameObjectsList& explosions, float elapsedTime) {
+
+	for (GameObjectsList::iterator it = explosions.begin(); it != explosions.end(); ++it)
+		advanceExplosion((ExplosionObject*)(*it), elapsedTime);
+
+	removeDestroyedObjects<ExplosionObject>(explosions);
+}
+
+// ----------------------------------------------------------------------------------------
+// START OF PARALLEL UPDATE
+
+void updateMissilesParallel(GameObjectsList& missiles, float elapsedTime) {
+
+	// the chunks index the objects, the list itself is not touched by the jobs
+	std::vector<void*> objects(missiles.begin(), missiles.end());
+
+	parallelFor(objects.size(), SIMULATION_CHUNK_SIZE, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++)
+			moveMissile((MissileObject*)objects[i], elapsedTime);
+	});
+
+	removeDestroyedObjects<MissileObject>(missiles);
+}
+
+void updateExplosionsParallel(GameObjectsList& explosions, float elapsedTime) {
+
+	std::vector<void*> objects(explosions.begin(), explosions.end());
+
+	parallelFor(objects.size(), SIMULATION_CHUNK_SIZE, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++)
+			advanceExplosion((ExplosionObject*)objects[i], elapsedTime);
+	});
+
+	removeDestroyedObjects<ExplosionObject>(explosions);
+}
+
+void collideMissilesParallel(GameObjectsList& missiles, const std::vector<Object>& targets, std::vector<glm::vec3>& hits) {
+
+	std::vector<void*> objects(missiles.begin(), missiles.end());
+
+	// every chunk collects its own hits, merged in the chunk order below
+	const size_t chunkCount = (objects.size() + SIMULATION_CHUNK_SIZE - 1) / SIMULATION_CHUNK_SIZE;
+	std::vector<std::vector<glm::vec3> > chunkHits(chunkCount);
+
+	parallelFor(objects.size(), SIMULATION_CHUNK_SIZE, [&](size_t begin, size_t end) {
+		std::vector<glm::vec3>& chunk = chunkHits[begin / SIMULATION_CHUNK_SIZE];
+
+		for (size_t i = begin; i < end; i++) {
+			MissileObject* missile = (MissileObject*)objects[i];
+			if (missile->destroyed)
+				continue;
+
+			for (size_t t = 0; t < targets.size(); t++) {
+				if (spheresIntersection(missile->position, missile->size, targets[t].position, targets[t].size)) {
+					missile->destroyed = true;
+					chunk.push_back(missile->position);
+					break;
+				}
+			}
+		}
+	});
+
+	hits.clear();
+	for (size_t c = 0; c < chunkCount; c++)
+		hits.insert(hits.end(), chunkHits[c].begin(), chunkHits[c].end());
+}
+
+// END OF PARALLEL UPDATE
+// ----------------------------------------------------------------------------------------
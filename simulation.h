@@ -0,0 +1,53 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    simulation.h
+ * \author  Sean Phay
+ * \date    2023
+ * \brief   Update of the moving objects of the scene - no OpenGL state.
+ */
+//----------------------------------------------------------------------------------------
+
+#ifndef __SIMULATION_H
+#define __SIMULATION_H
+
+#include <vector>
+#include "objects.h"
+
+//**************************************************************************************************
+/// Moves the missiles and removes those which flew further than MISSILE_MAX_DISTANCE.
+/**
+ \param[in,out] missiles     List of MissileObject, destroyed missiles are deleted.
+ \param[in]     elapsedTime  Current simulation time (seconds).
+*/
+void updateMissiles(GameObjectsList& missiles, float elapsedTime);
+
+//**************************************************************************************************
+/// Advances the explosion billboards and removes those which played all their frames.
+/**
+ \param[in,out] explosions   List of ExplosionObject, finished explosions are deleted.
+ \param[in]     elapsedTime  Current simulation time (seconds).
+*/
+void updateExplosions(GameObjectsList& explosions, float elapsedTime);
+
+//**************************************************************************************************
+/// updateMissiles() with the missiles split into chunks updated on all cores.
+/**
+ The jobs only move the missiles and flag them, the destroyed ones are deleted afterwards on the
+ calling thread in the order of the list - the result is the same as of updateMissiles().
+*/
+void updateMissilesParallel(GameObjectsList& missiles, float elapsedTime);
+
+/// updateExplosions() with the explosions split into chunks updated on all cores.
+void updateExplosionsParallel(GameObjectsList& explosions, float elapsedTime);
+
+//**************************************************************************************************
+/// Tests the missiles against static targets in parallel, a missile is destroyed by the first hit.
+/**
+ \param[in,out] missiles   List of MissileObject, the hitting ones are flagged destroyed
+                           (deleted by the next update).
+ \param[in]     targets    Bounding spheres of the targets (position, size = radius).
+ \param[out]    hits       Positions of the hits in the order of the missiles, e.g. for the explosions.
+*/
+void collideMissilesParallel(GameObjectsList& missiles, const std::vector<Object>& targets, std::vector<glm::vec3>& hits);
+
+#endif // __SIMULATION_H
@@ -0,0 +1,126 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    snapshot.h
+ * \author  Sean Phay
+ * \date    2023
+ * \brief   State of the scene handed from the simulation thread to the rendering (triple buffer).
+ */
+//----------------------------------------------------------------------------------------
+
+#ifndef __SNAPSHOT_H
+#define __SNAPSHOT_H
+
+#include <atomic>
+#include <vector>
+#include "objects.h"
+#include "entities.h"
+#include "flock.h"
+
+//**************************************************************************************************
+/// Three copies of a value passed from one writing to one reading thread without locks.
+/**
+ The writer fills writeBuffer() and publishes it, the reader takes the newest published copy
+ by update() and keeps using readBuffer() until the next update(). Neither side ever waits:
+ the writer always has a free copy, copies the reader did not take in time are overwritten.
+*/
+template <typename T>
+struct TripleBuffer {
+
+  TripleBuffer() : buffers(), writeIndex(0), middle(1), readIndex(2) {}
+
+  /// Copy owned by the writer.
+  T& writeBuffer() { return buffers[writeIndex]; }
+
+  /// Hands the written copy to the reader, the writer continues with the previous middle copy.
+  void publish() {
+    writeIndex = middle.exchange(writeIndex | FRESH, std::memory_order_acq_rel) & INDEX;
+  }
+
+  /// Takes the newest published copy. Returns false if nothing was published since the last call.
+  bool update() {
+    if ((middle.load(std::memory_order_acquire) & FRESH) == 0)
+      return false;
+    readIndex = middle.exchange(readIndex, std::memory_order_acq_rel) & INDEX;
+    return true;
+  }
+
+  /// Copy owned by the reader.
+  const T& readBuffer() const { return buffers[readIndex]; }
+
+private:
+  static const unsigned int INDEX = 3;  // index of the copy in the low bits of middle
+  static const unsigned int FRESH = 4;  // middle copy was published and not taken yet
+
+  T                         buffers[3];
+  unsigned int              writeIndex;  // used by the writer only
+  std::atomic<unsigned int> middle;      // copy in between, swapped by both sides
+  unsigned int              readIndex;   // used by the reader only
+};
+
+// everything the drawing reads - one simulation step, copied by value
+typedef struct _RenderSnapshot {
+  unsigned int tick;
+  float        elapsedTime;
+  size_t       particleCount;  // queuedParticleCount() - the particles spawned up to this step
+
+  int   cameraState;
+  float cameraElevationAngle;
+  bool  gameOver;
+
+  int   pointEnable;
+  bool  fogLinear;
+  bool  fogExp;
+  float fogNear;
+  float fogDensity;
+  float impostorDistance;
+  float impostorFade;
+
+  TerrainObject  terrain;
+  PenguinObject  penguin;
+  CatObject      cat;
+  RockObject     rock;
+  StoneObject    stone;
+  FernObject     ferns[4];
+  CampfireObject campfire;
+  BlockObject    block;
+  bool           hasBanner;
+  BannerObject   banner;
+
+  // generated scenery - copied only when sceneryVersion changes
+  unsigned int                sceneryVersion;
+  std::vector<PalmTreeObject> palmTrees;
+  std::vector<FernObject>     scatteredFerns;
+  std::vector<StoneObject>    scatteredStones;
+  std::vector<RockObject>     scatteredRocks;
+
+  std::vector<SparrowObject>   sparrows;
+  std::vector<TargetObject>    targets;
+  std::vector<MissileObject>   missiles;
+  std::vector<ExplosionObject> explosions;
+} RenderSnapshot;
+
+/// Copies the objects of a list into a vector (the memory of the vector is reused).
+template <typename ObjectType>
+void copyObjectList(const GameObjectsList& objects, std::vector<ObjectType>& copies) {
+  copies.resize(objects.size());
+  size_t i = 0;
+  for (GameObjectsList::const_iterator it = objects.begin(); it != objects.end(); ++it, ++i)
+    copies[i] = *(const ObjectType*)(*it);
+}
+
+/// Copies the entities of a store into a vector of objects (the memory of the vector is reused).
+template <typename ObjectType>
+void copyEntities(const EntityStore& entities, std::vector<ObjectType>& copies) {
+  copies.resize(entityCount(entities));
+  for (size_t i = 0; i < copies.size(); i++)
+    getEntityObject(entities, i, copies[i]);
+}
+
+/// Copies the birds of a flock into a vector of sparrows (the memory of the vector is reused).
+inline void copyFlock(const Flock& flock, std::vector<SparrowObject>& copies) {
+  copies.resize(flockSize(flock));
+  for (size_t i = 0; i < copies.size(); i++)
+    getFlockSparrow(flock, i, copies[i]);
+}
+
+#endif // __SNAPSHOT_H
@@ -7,6 +7,7 @@
 */
 //----------------------------------------------------------------------------------------
 
+#include <algorithm>
 #include "spline.h"
 
 //**************************************************************************************************
@@ -95,22 +96,7 @@ glm::vec3 evaluateCurveSegment(
     const glm::vec3& P3,
     const float t
 ) {
-  glm::vec3 result(0.0, 0.0, 0.0);
-
-  // evaluate point on a curve segment (defined by the control points P0...P3)
-  // for the given value of parameter t
-
-  const float t2 = t*t;
-  const float t3 = t*t2;
-
-  result = P0 * (-      t3 + 2.0f*t2 - t       )
-      + P1 * (  3.0f*t3 - 5.0f*t2     + 2.0f)
-      + P2 * (- 3.0f*t3 + 4.0f*t2 + t       )
-      + P3 * (       t3 -      t2           );
-
-  result *= 0.5f;
-
-  return result;
+  return evaluateCurveSegmentBasis<CatmullRomBasis>(P0, P1, P2, P3, t).position;
 }
 
 //**************************************************************************************************
@@ -130,21 +116,7 @@ glm::vec3 evaluateCurveSegment_1stDerivative(
     const glm::vec3& P3,
     const float t
 ) {
-  glm::vec3 result(1.0, 0.0, 0.0);
-
-  // evaluate first derivative for a point on a curve segment (defined by the control points P0...P3)
-  // for the given value of parameter t
-
-  const float t2 = t*t;
-
-  result = P0 * (- 3.0f*t2 +  4.0f*t - 1.0f)
-      + P1 * (  9.0f*t2 - 10.0f*t       )
-      + P2 * (- 9.0f*t2 +  8.0f*t + 1.0f)
-      + P3 * (  3.0f*t2 -  2.0f*t       );
-
-  result *= 0.5f;
-
-  return result;
+  return evaluateCurveSegmentBasis<CatmullRomBasis>(P0, P1, P2, P3, t).firstDerivative;
 }
 
 //**************************************************************************************************
@@ -162,23 +134,7 @@ glm::vec3 evaluateClosedCurve(
     const size_t    count,
     const float     t
 ) {
-  glm::vec3 result(0.0, 0.0, 0.0);
-
-  // based on the value of parameter t first find corresponding segment and its control points => i
-  // and then call evaluateCurveSegment function with proper parameters to get a point on a closed curve
-
-  float param = cyclic_clamp(t, 0.0f, float(count));
-  size_t index = size_t(param);
-
-  result = evaluateCurveSegment(
-      points[(index-1+count)%count],
-      points[(index        )%count],
-      points[(index+1      )%count],
-      points[(index+2      )%count],
-      param-floor(param)
-      );
-
-  return result;
+  return evaluateClosedCurveBasis<CatmullRomBasis>(points, count, t).position;
 }
 
 //**************************************************************************************************
@@ -196,24 +152,226 @@ glm::vec3 evaluateClosedCurve_1stDerivative(
     const size_t    count,
     const float     t
 ) {
-  glm::vec3 result(1.0, 0.0, 0.0);
+  return evaluateClosedCurveBasis<CatmullRomBasis>(points, count, t).firstDerivative;
+}
 
-  // based on the value of parameter t first find corresponding curve segment and its control points => i
-  // and then call evaluateCurveSegment_1stDerivative function with proper parameters
-  // to get a derivative for the given point on a closed curve
+// position and derivatives of one segment of the path from its stored cubic
+CurveSample evaluateSplinePathSegment(const SplinePath& path, const size_t segment, const float t) {
+  const size_t n = path.segments;
+  const float* cubic = &path.coefficients[segment];
+  CurveSample sample;
+
+  for (int axis = 0; axis < 3; axis++) {
+    const float a = cubic[(axis*4  )*n];
+    const float b = cubic[(axis*4+1)*n];
+    const float c = cubic[(axis*4+2)*n];
+    const float d = cubic[(axis*4+3)*n];
+    sample.position[axis] = ((a*t + b)*t + c)*t + d;
+    sample.firstDerivative[axis] = (3.0f*a*t + 2.0f*b)*t + c;
+    sample.secondDerivative[axis] = 6.0f*a*t + 2.0f*b;
+  }
+  return sample;
+}
 
-  float param = cyclic_clamp(t, 0.0f, float(count));
-  size_t index = size_t(param);
+// segment and its parameter at a distance along the path
+CurveSample evaluateSplinePathAt(const SplinePath& path, const float distance) {
+  const float param = splinePathParameter(path, distance);
+  size_t segment = size_t(param);
+  if (segment >= path.segments)
+    segment = path.segments-1;
 
-  result = evaluateCurveSegment_1stDerivative(
-      points[(index-1+count)%count],
-      points[(index        )%count],
-      points[(index+1      )%count],
-      points[(index+2      )%count],
-      param-floor(param)
-      );
+  return evaluateSplinePathSegment(path, segment, param - float(segment));
+}
 
-  return result;
+//**************************************************************************************************
+/// Builds the arc length table of a path whose segment cubics are already stored.
+/**
+  The length of every sample interval is integrated by the Gauss-Legendre quadrature of the first
+  derivative, the table is then inverted to the parameters at evenly spaced distances.
+  Called by \ref buildSplinePath.
+
+  \param[in,out] path                Path with \a segments and \a coefficients set.
+  \param[in]     samplesPerSegment   Table entries per curve segment.
+*/
+void buildSplinePathTable(SplinePath& path, const size_t samplesPerSegment) {
+
+  // 3-point Gauss-Legendre nodes and weights on [-1, 1]
+  const float nodes[3]   = { -0.7745966692f, 0.0f, 0.7745966692f };
+  const float weights[3] = { 5.0f/9.0f, 8.0f/9.0f, 5.0f/9.0f };
+
+  const size_t segments = path.segments;
+  const size_t samples = segments * samplesPerSegment;
+  const float  h = 1.0f / float(samplesPerSegment);
+
+  // curve length at parameters 0, h, 2h, ...
+  std::vector<double> lengths(samples+1, 0.0);
+
+  for (size_t i = 0; i < samples; i++) {
+    const size_t segment = i / samplesPerSegment;
+    const float t0 = float(i % samplesPerSegment) * h;
+    float sum = 0.0f;
+
+    for (int k = 0; k < 3; k++) {
+      float t = t0 + 0.5f * h * (1.0f + nodes[k]);
+      sum += weights[k] * glm::length(evaluateSplinePathSegment(path, segment, t).firstDerivative);
+    }
+    lengths[i+1] = lengths[i] + 0.5 * h * sum;
+  }
+
+  path.length = float(lengths[samples]);
+  path.invLength = 1.0f / path.length;
+  path.invStep = float(samples) * path.invLength;
+
+  // inverse table - parameter of the evenly spaced distances, linear between the samples
+  path.parameters.resize(samples+1);
+  size_t j = 0;
+
+  for (size_t i = 0; i < samples; i++) {
+    const double distance = lengths[samples] * double(i) / double(samples);
+
+    while (j+1 < samples && lengths[j+1] < distance)
+      j++;
+
+    const double interval = lengths[j+1] - lengths[j];
+    const double fraction = interval > 0.0 ? (distance - lengths[j]) / interval : 0.0;
+    path.parameters[i] = float((double(j) + fraction) * h);
+  }
+  path.parameters[samples] = float(segments);
+}
+
+//**************************************************************************************************
+/// Curve parameter (as taken by \ref evaluateClosedCurve) at a distance along the path.
+/**
+  \param[in] path       Built path.
+  \param[in] distance   Distance from the first control point, any value (the path is periodic).
+  \return               Parameter within range [0, number of segments].
+*/
+float splinePathParameter(const SplinePath& path, const float distance) {
+
+  // floor instead of fmod, negative distances end up in the range as well
+  const float wrapped = distance - path.length * std::floor(distance * path.invLength);
+  const size_t last = path.parameters.size() - 2;
+
+  const float s = wrapped * path.invStep;
+  size_t index = size_t(s);
+  if (index > last)
+    index = last;
+
+  const float fraction = s - float(index);
+  return path.parameters[index] + fraction * (path.parameters[index+1] - path.parameters[index]);
+}
+
+//**************************************************************************************************
+/// Evaluates a position on the path at a distance from its start.
+/**
+  \param[in] path       Built path.
+  \param[in] distance   Distance from the first control point, any value (the path is periodic).
+  \return               Position on the curve.
+*/
+glm::vec3 evaluateSplinePath(const SplinePath& path, const float distance) {
+  return evaluateSplinePathAt(path, distance).position;
+}
+
+//**************************************************************************************************
+/// Evaluates the direction of the path at a distance from its start.
+/**
+  \param[in] path       Built path.
+  \param[in] distance   Distance from the first control point, any value (the path is periodic).
+  \return               Unit tangent of the curve.
+*/
+glm::vec3 evaluateSplinePathTangent(const SplinePath& path, const float distance) {
+  return glm::normalize(evaluateSplinePathAt(path, distance).firstDerivative);
+}
+
+// loop of evaluateSplinePathBatch() - the arrays are restrict parameters, GCC does not vectorize
+// the table reads (gathers) through restrict pointers declared inside the function, and the
+// sqrt() needs -fno-math-errno (Release build)
+void evaluateSplinePathRange(
+    const SplinePath&        path,
+    const float* __restrict  parameters,
+    const float* __restrict  coefficients,
+    const float* __restrict  distances,
+    const size_t             count,
+    float* __restrict px, float* __restrict py, float* __restrict pz,
+    float* __restrict tx, float* __restrict ty, float* __restrict tz
+) {
+  const float length = path.length;
+  const float invLength = path.invLength;
+  const float invStep = path.invStep;
+  const int   lastSample = int(path.parameters.size()) - 2;
+  const int   lastSegment = int(path.segments) - 1;
+
+  // coefficient tables of the segments, a*t^3 + b*t^2 + c*t + d per axis
+  const size_t n = path.segments;
+  const float* ax = coefficients +  0*n;
+  const float* bx = coefficients +  1*n;
+  const float* cx = coefficients +  2*n;
+  const float* dx = coefficients +  3*n;
+  const float* ay = coefficients +  4*n;
+  const float* by = coefficients +  5*n;
+  const float* cy = coefficients +  6*n;
+  const float* dy = coefficients +  7*n;
+  const float* az = coefficients +  8*n;
+  const float* bz = coefficients +  9*n;
+  const float* cz = coefficients + 10*n;
+  const float* dz = coefficients + 11*n;
+
+  for (size_t i = 0; i < count; i++) {
+    // distance => table entry => curve parameter, as splinePathParameter() - floor() by the truncation
+    // corrected for the negative values, the compiler does not vectorize std::floor without -fno-trapping-math
+    const float laps = distances[i] * invLength;
+    int lap = int(laps);
+    lap -= int(laps < float(lap));
+    const float wrapped = distances[i] - length * float(lap);
+    const float s = wrapped * invStep;
+    const int   sample = std::min(int(s), lastSample);
+    const float fraction = s - float(sample);
+    const float param = parameters[sample] + fraction * (parameters[sample+1] - parameters[sample]);
+
+    const int   segment = std::min(int(param), lastSegment);
+    const float t = param - float(segment);
+    const float t2 = t*t;
+
+    px[i] = ax[segment]*t2*t + bx[segment]*t2 + cx[segment]*t + dx[segment];
+    py[i] = ay[segment]*t2*t + by[segment]*t2 + cy[segment]*t + dy[segment];
+    pz[i] = az[segment]*t2*t + bz[segment]*t2 + cz[segment]*t + dz[segment];
+
+    const float x = 3.0f*ax[segment]*t2 + 2.0f*bx[segment]*t + cx[segment];
+    const float y = 3.0f*ay[segment]*t2 + 2.0f*by[segment]*t + cy[segment];
+    const float z = 3.0f*az[segment]*t2 + 2.0f*bz[segment]*t + cz[segment];
+    const float invNorm = 1.0f / std::sqrt(x*x + y*y + z*z);
+
+    tx[i] = x * invNorm;
+    ty[i] = y * invNorm;
+    tz[i] = z * invNorm;
+  }
+}
+
+//**************************************************************************************************
+/// Evaluates positions and unit tangents of the path for an array of distances.
+/**
+  One pass per agent computes the powers of the segment parameter once for both the position and
+  the tangent (from the cubic coefficients of the segment). The loop has no branch and reads
+  the tables by index, the compiler turns it into SIMD code with gathers where the target has them
+  (AVX2), so a flock of thousands of agents costs a few microseconds.
+
+  \param[in]  path        Built path.
+  \param[in]  distances   Distances from the first control point, any values (the path is periodic).
+  \param[in]  count       Number of the distances.
+  \param[out] positionsX  X coordinates of the positions (\a count floats), likewise Y and Z.
+  \param[out] tangentsX   X coordinates of the unit tangents (\a count floats), likewise Y and Z.
+*/
+void evaluateSplinePathBatch(
+    const SplinePath& path,
+    const float       distances[],
+    const size_t      count,
+    float positionsX[], float positionsY[], float positionsZ[],
+    float tangentsX[],  float tangentsY[],  float tangentsZ[]
+) {
+  evaluateSplinePathRange(
+      path, path.parameters.data(), path.coefficients.data(), distances, count,
+      positionsX, positionsY, positionsZ, tangentsX, tangentsY, tangentsZ
+      );
 }
 
 //**************************************************************************************************
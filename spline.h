@@ -9,7 +9,10 @@
 #ifndef __SPLINE_H
 #define __SPLINE_H
 
-#include "pgr.h" // glm
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#include <glm/glm.hpp>
 
 //**************************************************************************************************
 /// Checks whether vector is zero-length or not.
@@ -61,6 +64,135 @@ T cyclic_clamp(const T value, const T minBound, const T maxBound) {
   return val+minBound;
 }
 
+//**************************************************************************************************
+/// Bases of the cubic curves - a segment is [t^3 t^2 t 1] * matrix * [P0 P1 P2 P3]^T.
+/**
+ The matrices are constexpr, \ref evaluateCurveSegmentBasis instantiated for a basis folds them
+ into the code (the zero coefficients disappear), the choice of the basis costs nothing at run time.
+ A closed curve of \a count control points has count / \a stride segments, segment i uses the
+ control points from i * \a stride - \a lead on.
+*/
+struct CatmullRomBasis {
+  static constexpr float matrix[4][4] = {
+    { -0.5f,  1.5f, -1.5f,  0.5f },
+    {  1.0f, -2.5f,  2.0f, -0.5f },
+    { -0.5f,  0.0f,  0.5f,  0.0f },
+    {  0.0f,  1.0f,  0.0f,  0.0f }
+  };
+  static constexpr size_t stride = 1;  ///< Interpolates P1 ... P2, the neighbours set the tangents.
+  static constexpr size_t lead   = 1;
+};
+
+/// Uniform cubic B-spline, C2 continuous, does not pass through the control points.
+struct BSplineBasis {
+  static constexpr float matrix[4][4] = {
+    { -1.0f/6.0f,  3.0f/6.0f, -3.0f/6.0f, 1.0f/6.0f },
+    {  3.0f/6.0f, -6.0f/6.0f,  3.0f/6.0f, 0.0f      },
+    { -3.0f/6.0f,  0.0f,       3.0f/6.0f, 0.0f      },
+    {  1.0f/6.0f,  4.0f/6.0f,  1.0f/6.0f, 0.0f      }
+  };
+  static constexpr size_t stride = 1;
+  static constexpr size_t lead   = 1;
+};
+
+/// Cubic Bezier, the segments share the end points (P0 P1 P2 P3=P0' P1' P2' ...).
+struct BezierBasis {
+  static constexpr float matrix[4][4] = {
+    { -1.0f,  3.0f, -3.0f, 1.0f },
+    {  3.0f, -6.0f,  3.0f, 0.0f },
+    { -3.0f,  3.0f,  0.0f, 0.0f },
+    {  1.0f,  0.0f,  0.0f, 0.0f }
+  };
+  static constexpr size_t stride = 3;
+  static constexpr size_t lead   = 0;
+};
+
+/// Cubic Hermite, the control points are positions interleaved with tangents (P0 T0 P1 T1 ...).
+struct HermiteBasis {
+  static constexpr float matrix[4][4] = {
+    {  2.0f,  1.0f, -2.0f,  1.0f },
+    { -3.0f, -2.0f,  3.0f, -1.0f },
+    {  0.0f,  1.0f,  0.0f,  0.0f },
+    {  1.0f,  0.0f,  0.0f,  0.0f }
+  };
+  static constexpr size_t stride = 2;
+  static constexpr size_t lead   = 0;
+};
+
+/// Position and derivatives of a curve at one parameter.
+typedef struct _CurveSample {
+  glm::vec3 position;
+  glm::vec3 firstDerivative;
+  glm::vec3 secondDerivative;
+} CurveSample;
+
+//**************************************************************************************************
+/// Evaluates the position, first and second derivative of a curve segment in one pass.
+/**
+  \param[in] P0       First control point of the curve segment.
+  \param[in] P1       Second control point of the curve segment.
+  \param[in] P2       Third control point of the curve segment.
+  \param[in] P3       Fourth control point of the curve segment.
+  \param[in] t        Curve segment parameter. Must be within range [0, 1].
+  \return             Position and derivatives for parameter \a t.
+*/
+template <class Basis>
+inline CurveSample evaluateCurveSegmentBasis(
+    const glm::vec3& P0,
+    const glm::vec3& P1,
+    const glm::vec3& P2,
+    const glm::vec3& P3,
+    const float t
+) {
+  constexpr const float (&M)[4][4] = Basis::matrix;
+  float w[4], d1[4], d2[4];
+
+  // weights of the control points and their derivatives, columns of the basis
+  for (int j = 0; j < 4; j++) {
+    w[j]  = ((M[0][j]*t + M[1][j])*t + M[2][j])*t + M[3][j];
+    d1[j] = (3.0f*M[0][j]*t + 2.0f*M[1][j])*t + M[2][j];
+    d2[j] = 6.0f*M[0][j]*t + 2.0f*M[1][j];
+  }
+
+  CurveSample sample;
+  sample.position         = w[0]*P0  + w[1]*P1  + w[2]*P2  + w[3]*P3;
+  sample.firstDerivative  = d1[0]*P0 + d1[1]*P1 + d1[2]*P2 + d1[3]*P3;
+  sample.secondDerivative = d2[0]*P0 + d2[1]*P1 + d2[2]*P2 + d2[3]*P3;
+  return sample;
+}
+
+//**************************************************************************************************
+/// Evaluates the position, first and second derivative of a closed curve in one pass.
+/**
+  \param[in] points   Array of curve control points (laid out as described by the basis).
+  \param[in] count    Number of curve control points, a multiple of the stride of the basis.
+  \param[in] t        Parameter, one unit per segment, any value (the curve is periodic).
+  \return             Position and derivatives for parameter \a t.
+*/
+template <class Basis>
+inline CurveSample evaluateClosedCurveBasis(
+    const glm::vec3 points[],
+    const size_t    count,
+    const float     t
+) {
+  const size_t segments = count / Basis::stride;
+  const float  param = cyclic_clamp(t, 0.0f, float(segments));
+
+  size_t index = size_t(param);
+  if (index >= segments)
+    index = segments-1;
+
+  const size_t first = index*Basis::stride + count - Basis::lead;
+
+  return evaluateCurveSegmentBasis<Basis>(
+      points[(first  )%count],
+      points[(first+1)%count],
+      points[(first+2)%count],
+      points[(first+3)%count],
+      param - float(index)
+      );
+}
+
 //**************************************************************************************************
 /// Evaluates a position on Catmull-Rom curve segment.
 /**
@@ -126,6 +258,123 @@ glm::vec3 evaluateClosedCurve_1stDerivative(
     const float     t
 );
 
+//**************************************************************************************************
+/// Arc length table samples per curve segment (default of \ref buildSplinePath).
+const size_t SPLINE_PATH_SAMPLES = 32;
+
+/// Closed cubic curve reparameterized by the distance travelled along it.
+/**
+ The parameter of \ref evaluateClosedCurve does not move at a constant speed, segments with distant
+ control points are passed faster than the short ones. The path keeps the curve parameter for
+ evenly spaced distances, a position or tangent at a distance is one table lookup and one
+ cubic of a segment, without fmod and without the modulo indexing of the control points.
+ The segments are stored as cubics, the path evaluates the same way whatever basis built it.
+*/
+typedef struct _SplinePath {
+  size_t                 segments;    ///< Number of curve segments.
+  float                  length;      ///< Length of one loop of the curve.
+  float                  invLength;
+  float                  invStep;     ///< Table entries per unit of distance.
+  std::vector<float>     parameters;  ///< Curve parameter at distances 0, length/N, ..., length (N+1 entries).
+  std::vector<float>     coefficients;///< Cubic of every segment, [(axis*4 + 3-power)*segments + segment].
+} SplinePath;
+
+//**************************************************************************************************
+/// Builds the arc length table of a path whose segment cubics are already stored.
+/**
+  The length of every sample interval is integrated by the Gauss-Legendre quadrature of the first
+  derivative, the table is then inverted to the parameters at evenly spaced distances.
+  Called by \ref buildSplinePath.
+
+  \param[in,out] path                Path with \a segments and \a coefficients set.
+  \param[in]     samplesPerSegment   Table entries per curve segment.
+*/
+void buildSplinePathTable(SplinePath& path, const size_t samplesPerSegment);
+
+//**************************************************************************************************
+/// Builds the path of a closed curve with a basis (Catmull-Rom unless given).
+/**
+  \param[out] path                Path to be built (the previous content is replaced).
+  \param[in]  points              Array of curve control points (laid out as described by the basis).
+  \param[in]  count               Number of curve control points, a multiple of the stride of the basis.
+  \param[in]  samplesPerSegment   Table entries per curve segment.
+  \pre                            The curve has at least one segment and non-zero length.
+*/
+template <class Basis = CatmullRomBasis>
+void buildSplinePath(
+    SplinePath&     path,
+    const glm::vec3 points[],
+    const size_t    count,
+    const size_t    samplesPerSegment = SPLINE_PATH_SAMPLES
+) {
+  const size_t segments = count / Basis::stride;
+  path.segments = segments;
+  path.coefficients.resize(12*segments);
+
+  // the basis multiplied out once - cubic[k] is the coefficient of t^(3-k)
+  for (size_t i = 0; i < segments; i++) {
+    const size_t first = i*Basis::stride + count - Basis::lead;
+
+    for (int k = 0; k < 4; k++) {
+      glm::vec3 cubic(0.0f);
+      for (int j = 0; j < 4; j++)
+        cubic += Basis::matrix[k][j] * points[(first+j)%count];
+
+      for (int axis = 0; axis < 3; axis++)
+        path.coefficients[(axis*4 + k)*segments + i] = cubic[axis];
+    }
+  }
+
+  buildSplinePathTable(path, samplesPerSegment);
+}
+
+//**************************************************************************************************
+/// Curve parameter (as taken by \ref evaluateClosedCurve) at a distance along the path.
+/**
+  \param[in] path       Built path.
+  \param[in] distance   Distance from the first control point, any value (the path is periodic).
+  \return               Parameter within range [0, number of segments].
+*/
+float splinePathParameter(const SplinePath& path, const float distance);
+//**************************************************************************************************
+/// Evaluates a position on the path at a distance from its start.
+/**
+  \param[in] path       Built path.
+  \param[in] distance   Distance from the first control point, any value (the path is periodic).
+  \return               Position on the curve.
+*/
+glm::vec3 evaluateSplinePath(const SplinePath& path, const float distance);
+//**************************************************************************************************
+/// Evaluates the direction of the path at a distance from its start.
+/**
+  \param[in] path       Built path.
+  \param[in] distance   Distance from the first control point, any value (the path is periodic).
+  \return               Unit tangent of the curve.
+*/
+glm::vec3 evaluateSplinePathTangent(const SplinePath& path, const float distance);
+
+//**************************************************************************************************
+/// Evaluates positions and unit tangents of the path for an array of distances.
+/**
+  One pass per agent computes the powers of the segment parameter once for both the position and
+  the tangent (from the cubic coefficients of the segment). The loop has no branch and reads
+  the tables by index, the compiler turns it into SIMD code with gathers where the target has them
+  (AVX2), so a flock of thousands of agents costs a few microseconds.
+
+  \param[in]  path        Built path.
+  \param[in]  distances   Distances from the first control point, any values (the path is periodic).
+  \param[in]  count       Number of the distances.
+  \param[out] positionsX  X coordinates of the positions (\a count floats), likewise Y and Z.
+  \param[out] tangentsX   X coordinates of the unit tangents (\a count floats), likewise Y and Z.
+*/
+void evaluateSplinePathBatch(
+    const SplinePath& path,
+    const float       distances[],
+    const size_t      count,
+    float positionsX[], float positionsY[], float positionsZ[],
+    float tangentsX[],  float tangentsY[],  float tangentsZ[]
+);
+
 //**************************************************************************************************
 /// Curve validity test points.
 extern glm::vec3 curveTestPoints[];
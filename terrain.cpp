@@ -0,0 +1,409 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    terrain.cpp
+ * \author  Sean Phay
+ * \date    2023
+ * \brief   Terrain split into chunks which are streamed around the penguin.
+ */
+//----------------------------------------------------------------------------------------
+
+#include <cfloat>
+#include <iostream>
+#include <future>
+#include <map>
+#include "pgr.h"
+#include "terrain.h"
+#include "data.h"
+
+extern SCommonShaderProgram shaderProgram;
+extern bool useLighting;
+
+// ----------------------------------------------------------------------------------------
+// START OF TERRAIN DATA
+
+typedef std::pair<int, int> ChunkKey;
+
+// CPU copy of one sub-mesh of the terrain model
+struct TerrainSubMesh {
+  std::vector<glm::vec3>    positions;
+  std::vector<glm::vec3>    normals;
+  std::vector<glm::vec2>    texCoords;
+  std::vector<unsigned int> indices;
+  std::vector<std::vector<unsigned int> > chunkTriangles; // triangles of each source chunk
+};
+
+// chunk data prepared by a worker thread, the main thread only copies it to the GPU
+struct TerrainChunkBuild {
+  int       chunkX;
+  int       chunkY;
+  glm::vec3 boundsMin;
+  glm::vec3 boundsMax;
+  std::vector<std::vector<float> >        vertices; // per sub-mesh, not interleaved |VVV...|NNN...|tt...|
+  std::vector<std::vector<unsigned int> > indices;  // per sub-mesh
+};
+
+struct TerrainState {
+  bool      initialized;
+  float     scale;
+  glm::vec2 sourceMin;    // scaled bounding rectangle of the model
+  glm::vec2 sourceMax;
+  glm::vec2 chunkSize;
+
+  std::vector<TerrainSubMesh> subMeshes;  // read-only after initialization => shared by the workers
+  std::vector<MeshGeometry*>  materials;
+
+  std::map<ChunkKey, TerrainChunk*> chunks;
+  std::map<ChunkKey, std::future<TerrainChunkBuild*> > pending;
+} terrainState;
+
+// END OF TERRAIN DATA
+// ----------------------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------------------
+// START OF CHUNK BUILDING FUNCTIONS
+
+// floor division which works for negative chunk coordinates too
+static int floorDiv(int value, int divisor) {
+  int quotient = value / divisor;
+  if ((value % divisor != 0) && ((value < 0) != (divisor < 0)))
+    quotient--;
+  return quotient;
+}
+
+// Runs on a worker thread => must not touch OpenGL.
+static TerrainChunkBuild* buildTerrainChunk(int chunkX, int chunkY) {
+
+  const int grid = TERRAIN_CHUNK_GRID;
+
+  // world chunk -> chunk of the model + offset of the model copy
+  int tileX = floorDiv(chunkX, grid);
+  int tileY = floorDiv(chunkY, grid);
+  int sourceChunk = (chunkY - tileY * grid) * grid + (chunkX - tileX * grid);
+
+  glm::vec2 period = terrainState.sourceMax - terrainState.sourceMin;
+  glm::vec3 offset(tileX * period.x, tileY * period.y, 0.0f);
+
+  TerrainChunkBuild* build = new TerrainChunkBuild;
+  build->chunkX = chunkX;
+  build->chunkY = chunkY;
+  build->boundsMin = glm::vec3(FLT_MAX);
+  build->boundsMax = glm::vec3(-FLT_MAX);
+  build->vertices.resize(terrainState.subMeshes.size());
+  build->indices.resize(terrainState.subMeshes.size());
+
+  for (size_t m = 0; m < terrainState.subMeshes.size(); m++) {
+    const TerrainSubMesh& mesh = terrainState.subMeshes[m];
+    const std::vector<unsigned int>& triangles = mesh.chunkTriangles[sourceChunk];
+
+    std::vector<int> remap(mesh.positions.size(), -1);
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> normals;
+    std::vector<glm::vec2> texCoords;
+    std::vector<unsigned int>& indices = build->indices[m];
+
+    for (size_t t = 0; t < triangles.size(); t++) {
+      for (int corner = 0; corner < 3; corner++) {
+        unsigned int source = mesh.indices[3 * triangles[t] + corner];
+
+        if (remap[source] < 0) {
+          glm::vec3 position = terrainState.scale * mesh.positions[source] + offset;
+
+          remap[source] = int(positions.size());
+          positions.push_back(position);
+          normals.push_back(mesh.normals[source]);
+          texCoords.push_back(mesh.texCoords[source]);
+
+          build->boundsMin = glm::min(build->boundsMin, position);
+          build->boundsMax = glm::max(build->boundsMax, position);
+        }
+        indices.push_back((unsigned int)remap[source]);
+      }
+    }
+
+    // same layout as loadSingleMesh() => the same vertex attribute setup
+    std::vector<float>& vertices = build->vertices[m];
+    vertices.reserve(8 * positions.size());
+    for (size_t i = 0; i < positions.size(); i++) {
+      vertices.push_back(positions[i].x); vertices.push_back(positions[i].y); vertices.push_back(positions[i].z);
+    }
+    for (size_t i = 0; i < normals.size(); i++) {
+      vertices.push_back(normals[i].x); vertices.push_back(normals[i].y); vertices.push_back(normals[i].z);
+    }
+    for (size_t i = 0; i < texCoords.size(); i++) {
+      vertices.push_back(texCoords[i].x); vertices.push_back(texCoords[i].y);
+    }
+  }
+
+  return build;
+}
+
+// Requests the missing chunks around the focus chunk, the closest rings first,
+// until TERRAIN_CHUNK_MAX_BUILDS builds are running.
+static void requestTerrainChunks(int focusX, int focusY) {
+
+  for (int ring = 0; ring <= TERRAIN_CHUNK_LOAD_RADIUS; ring++) {
+    for (int y = focusY - ring; y <= focusY + ring; y++) {
+      for (int x = focusX - ring; x <= focusX + ring; x++) {
+        if (std::max(abs(x - focusX), abs(y - focusY)) != ring)
+          continue;
+        if (terrainState.pending.size() >= TERRAIN_CHUNK_MAX_BUILDS)
+          return;
+
+        ChunkKey key(x, y);
+        if (terrainState.chunks.count(key) == 0 && terrainState.pending.count(key) == 0)
+          terrainState.pending[key] = std::async(std::launch::async, buildTerrainChunk, x, y);
+      }
+    }
+  }
+}
+
+// Copies the prepared chunk to the GPU, called from the thread owning the GL context.
+static TerrainChunk* uploadTerrainChunk(const TerrainChunkBuild* build) {
+
+  TerrainChunk* chunk = new TerrainChunk;
+  chunk->chunkX = build->chunkX;
+  chunk->chunkY = build->chunkY;
+  chunk->boundsMin = build->boundsMin;
+  chunk->boundsMax = build->boundsMax;
+
+  for (size_t m = 0; m < build->vertices.size(); m++) {
+    if (build->indices[m].empty())
+      continue;
+
+    const MeshGeometry* material = terrainState.materials[m];
+    size_t numVertices = build->vertices[m].size() / 8;
+
+    MeshGeometry* geometry = new MeshGeometry;
+
+    // material and texture are shared with the loaded terrain geometry
+    geometry->ambient = material->ambient;
+    geometry->diffuse = material->diffuse;
+    geometry->specular = material->specular;
+    geometry->shininess = material->shininess;
+    geometry->texture = material->texture;
+
+    glGenBuffers(1, &(geometry->vertexBufferObject));
+    glBindBuffer(GL_ARRAY_BUFFER, geometry->vertexBufferObject);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * build->vertices[m].size(), &build->vertices[m][0], GL_STATIC_DRAW);
+
+    glGenBuffers(1, &(geometry->elementBufferObject));
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, geometry->elementBufferObject);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * build->indices[m].size(), &build->indices[m][0], GL_STATIC_DRAW);
+
+    glGenVertexArrays(1, &(geometry->vertexArrayObject));
+    glBindVertexArray(geometry->vertexArrayObject);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, geometry->elementBufferObject);
+    glBindBuffer(GL_ARRAY_BUFFER, geometry->vertexBufferObject);
+
+    glEnableVertexAttribArray(shaderProgram.posLocation);
+    glVertexAttribPointer(shaderProgram.posLocation, 3, GL_FLOAT, GL_FALSE, 0, 0);
+
+    if (useLighting == true) {
+      glEnableVertexAttribArray(shaderProgram.normalLocation);
+      glVertexAttribPointer(shaderProgram.normalLocation, 3, GL_FLOAT, GL_FALSE, 0, (void*)(3 * sizeof(float) * numVertices));
+    }
+    else {
+      glDisableVertexAttribArray(shaderProgram.colorLocation);
+      glVertexAttrib3f(shaderProgram.colorLocation, material->diffuse.r, material->diffuse.g, material->diffuse.b);
+    }
+
+    glEnableVertexAttribArray(shaderProgram.texCoordLocation);
+    glVertexAttribPointer(shaderProgram.texCoordLocation, 2, GL_FLOAT, GL_FALSE, 0, (void*)(6 * sizeof(float) * numVertices));
+
+    glBindVertexArray(0);
+    CHECK_GL_ERROR();
+
+    geometry->numTriangles = (unsigned int)(build->indices[m].size() / 3);
+    chunk->geometry.push_back(geometry);
+  }
+
+  return chunk;
+}
+
+static void destroyTerrainChunk(TerrainChunk* chunk) {
+
+  for (size_t i = 0; i < chunk->geometry.size(); i++) {
+    glDeleteVertexArrays(1, &(chunk->geometry[i]->vertexArrayObject));
+    glDeleteBuffers(1, &(chunk->geometry[i]->elementBufferObject));
+    glDeleteBuffers(1, &(chunk->geometry[i]->vertexBufferObject));
+    // texture belongs to the terrain geometry
+    delete chunk->geometry[i];
+  }
+  delete chunk;
+}
+
+// END OF CHUNK BUILDING FUNCTIONS
+// ----------------------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------------------
+// START OF TERRAIN INTERFACE FUNCTIONS
+
+bool initializeTerrainChunks(const aiScene* scn, const std::vector<MeshGeometry*>& materials, float size) {
+
+  if (scn->mNumMeshes != materials.size()) {
+    std::cerr << "initializeTerrainChunks(): terrain materials do not match the model" << std::endl;
+    return false;
+  }
+
+  terrainState.scale = size;
+  terrainState.materials = materials;
+  terrainState.subMeshes.resize(scn->mNumMeshes);
+  terrainState.sourceMin = glm::vec2(FLT_MAX);
+  terrainState.sourceMax = glm::vec2(-FLT_MAX);
+
+  for (size_t i = 0; i < scn->mNumMeshes; i++) {
+    const aiMesh* mesh = scn->mMeshes[i];
+    TerrainSubMesh& subMesh = terrainState.subMeshes[i];
+
+    for (unsigned int v = 0; v < mesh->mNumVertices; v++) {
+      glm::vec3 position(mesh->mVertices[v].x, mesh->mVertices[v].y, mesh->mVertices[v].z);
+      subMesh.positions.push_back(position);
+      subMesh.normals.push_back(glm::vec3(mesh->mNormals[v].x, mesh->mNormals[v].y, mesh->mNormals[v].z));
+      if (mesh->HasTextureCoords(0))
+        subMesh.texCoords.push_back(glm::vec2(mesh->mTextureCoords[0][v].x, mesh->mTextureCoords[0][v].y));
+      else
+        subMesh.texCoords.push_back(glm::vec2(0.0f));
+
+      terrainState.sourceMin.x = std::min(terrainState.sourceMin.x, size * position.x);
+      terrainState.sourceMin.y = std::min(terrainState.sourceMin.y, size * position.y);
+      terrainState.sourceMax.x = std::max(terrainState.sourceMax.x, size * position.x);
+      terrainState.sourceMax.y = std::max(terrainState.sourceMax.y, size * position.y);
+    }
+
+    for (unsigned int f = 0; f < mesh->mNumFaces; f++) {
+      subMesh.indices.push_back(mesh->mFaces[f].mIndices[0]);
+      subMesh.indices.push_back(mesh->mFaces[f].mIndices[1]);
+      subMesh.indices.push_back(mesh->mFaces[f].mIndices[2]);
+    }
+  }
+
+  const int grid = TERRAIN_CHUNK_GRID;
+  terrainState.chunkSize = (terrainState.sourceMax - terrainState.sourceMin) / float(grid);
+
+  // sort the triangles into the chunks according to their centroids
+  for (size_t i = 0; i < terrainState.subMeshes.size(); i++) {
+    TerrainSubMesh& subMesh = terrainState.subMeshes[i];
+    subMesh.chunkTriangles.assign(grid * grid, std::vector<unsigned int>());
+
+    for (size_t t = 0; t < subMesh.indices.size() / 3; t++) {
+      glm::vec3 centroid = (subMesh.positions[subMesh.indices[3 * t + 0]]
+                          + subMesh.positions[subMesh.indices[3 * t + 1]]
+                          + subMesh.positions[subMesh.indices[3 * t + 2]]) * (size / 3.0f);
+
+      int x = glm::clamp(int((centroid.x - terrainState.sourceMin.x) / terrainState.chunkSize.x), 0, grid - 1);
+      int y = glm::clamp(int((centroid.y - terrainState.sourceMin.y) / terrainState.chunkSize.y), 0, grid - 1);
+      subMesh.chunkTriangles[y * grid + x].push_back((unsigned int)t);
+    }
+  }
+
+  terrainState.initialized = true;
+
+  // chunks of the model itself are built by the workers like the streamed ones, but waited for
+  // and uploaded right away => no terrain popping at the start
+  for (int y = 0; y < grid; y++)
+    for (int x = 0; x < grid; x++)
+      terrainState.pending[ChunkKey(x, y)] = std::async(std::launch::async, buildTerrainChunk, x, y);
+
+  for (std::map<ChunkKey, std::future<TerrainChunkBuild*> >::iterator it = terrainState.pending.begin(); it != terrainState.pending.end(); ++it) {
+    TerrainChunkBuild* build = it->second.get();
+    terrainState.chunks[it->first] = uploadTerrainChunk(build);
+    delete build;
+  }
+  terrainState.pending.clear();
+
+  return true;
+}
+
+void updateTerrainChunks(const glm::vec3& focus) {
+
+  if (terrainState.initialized == false)
+    return;
+
+  int focusX = int(floor((focus.x - terrainState.sourceMin.x) / terrainState.chunkSize.x));
+  int focusY = int(floor((focus.y - terrainState.sourceMin.y) / terrainState.chunkSize.y));
+
+  // request missing chunks
+  requestTerrainChunks(focusX, focusY);
+
+  // upload finished chunks
+  int uploads = 0;
+  std::map<ChunkKey, std::future<TerrainChunkBuild*> >::iterator it = terrainState.pending.begin();
+  while (it != terrainState.pending.end() && uploads < TERRAIN_CHUNK_UPLOADS_PER_UPDATE) {
+    if (it->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+      ++it;
+      continue;
+    }
+
+    TerrainChunkBuild* build = it->second.get();
+    if (std::max(abs(build->chunkX - focusX), abs(build->chunkY - focusY)) <= TERRAIN_CHUNK_UNLOAD_RADIUS) {
+      terrainState.chunks[it->first] = uploadTerrainChunk(build);
+      uploads++;
+    }
+    delete build;
+    it = terrainState.pending.erase(it);
+  }
+
+  // release chunks far from the focus
+  std::map<ChunkKey, TerrainChunk*>::iterator chunkIt = terrainState.chunks.begin();
+  while (chunkIt != terrainState.chunks.end()) {
+    TerrainChunk* chunk = chunkIt->second;
+
+    if (std::max(abs(chunk->chunkX - focusX), abs(chunk->chunkY - focusY)) > TERRAIN_CHUNK_UNLOAD_RADIUS) {
+      destroyTerrainChunk(chunk);
+      chunkIt = terrainState.chunks.erase(chunkIt);
+    }
+    else {
+      ++chunkIt;
+    }
+  }
+}
+
+void getVisibleTerrainChunks(const glm::mat4& PVmatrix, std::vector<const TerrainChunk*>& visible) {
+
+  // frustum planes extracted from the matrix rows (Gribb & Hartmann)
+  glm::vec4 rows[4];
+  for (int i = 0; i < 4; i++)
+    rows[i] = glm::vec4(PVmatrix[0][i], PVmatrix[1][i], PVmatrix[2][i], PVmatrix[3][i]);
+
+  const glm::vec4 planes[6] = {
+    rows[3] + rows[0], rows[3] - rows[0],
+    rows[3] + rows[1], rows[3] - rows[1],
+    rows[3] + rows[2], rows[3] - rows[2]
+  };
+
+  for (std::map<ChunkKey, TerrainChunk*>::const_iterator it = terrainState.chunks.begin(); it != terrainState.chunks.end(); ++it) {
+    const TerrainChunk* chunk = it->second;
+    bool inside = true;
+
+    for (int p = 0; p < 6 && inside; p++) {
+      // the box corner lying furthest along the plane normal
+      glm::vec3 corner(
+        planes[p].x >= 0.0f ? chunk->boundsMax.x : chunk->boundsMin.x,
+        planes[p].y >= 0.0f ? chunk->boundsMax.y : chunk->boundsMin.y,
+        planes[p].z >= 0.0f ? chunk->boundsMax.z : chunk->boundsMin.z
+      );
+      if (glm::dot(glm::vec3(planes[p]), corner) + planes[p].w < 0.0f)
+        inside = false;
+    }
+
+    if (inside)
+      visible.push_back(chunk);
+  }
+}
+
+void cleanupTerrainChunks() {
+
+  for (std::map<ChunkKey, std::future<TerrainChunkBuild*> >::iterator it = terrainState.pending.begin(); it != terrainState.pending.end(); ++it)
+    delete it->second.get();
+  terrainState.pending.clear();
+
+  for (std::map<ChunkKey, TerrainChunk*>::iterator it = terrainState.chunks.begin(); it != terrainState.chunks.end(); ++it)
+    destroyTerrainChunk(it->second);
+  terrainState.chunks.clear();
+
+  terrainState.initialized = false;
+}
+
+// END OF TERRAIN INTERFACE FUNCTIONS
+// ----------------------------------------------------------------------------------------
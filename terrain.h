@@ -0,0 +1,65 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    terrain.h
+ * \author  Sean Phay
+ * \date    2023
+ * \brief   Terrain split into chunks which are streamed around the penguin.
+ */
+//----------------------------------------------------------------------------------------
+
+#ifndef __TERRAIN_H
+#define __TERRAIN_H
+
+#include <string>
+#include <vector>
+#include "render.h"
+
+struct aiScene;
+
+// one square piece of the terrain with its own buffers
+typedef struct _TerrainChunk {
+  int       chunkX;                      // chunk coordinates in the chunk grid of the world
+  int       chunkY;
+  glm::vec3 boundsMin;                   // axis aligned bounding box (world coordinates)
+  glm::vec3 boundsMax;
+  std::vector<MeshGeometry*> geometry;   // one geometry per terrain sub-mesh (material)
+} TerrainChunk;
+
+//**************************************************************************************************
+/// Splits the terrain model into TERRAIN_CHUNK_GRID x TERRAIN_CHUNK_GRID pieces.
+/**
+ A CPU copy of the model is kept for the chunk builds. The chunks of the model itself are built
+ on worker threads and uploaded before the function returns, so the terrain is complete in the
+ first frame, the chunks around them are streamed by updateTerrainChunks().
+ The world is made of copies of the model placed next to each other, so it has no border.
+
+ \param[in]  scn         Terrain model loaded by readMeshScene().
+ \param[in]  materials   Geometry loaded by loadSceneMaterials(), used for materials and textures of the chunks.
+ \param[in]  size        Scale of the terrain (TERRAIN_SIZE).
+ \return                 True if the terrain was loaded.
+*/
+bool initializeTerrainChunks(const aiScene* scn, const std::vector<MeshGeometry*>& materials, float size);
+
+//**************************************************************************************************
+/// Streams the chunks around a given position.
+/**
+ Chunks within TERRAIN_CHUNK_LOAD_RADIUS are requested and built on worker threads, finished chunks
+ are uploaded to the GPU (at most TERRAIN_CHUNK_UPLOADS_PER_UPDATE per call) and chunks further than
+ TERRAIN_CHUNK_UNLOAD_RADIUS are released. Must be called from the thread owning the GL context.
+
+ \param[in]  focus       Position the chunks are loaded around (penguin position).
+*/
+void updateTerrainChunks(const glm::vec3& focus);
+
+//**************************************************************************************************
+/// Collects the loaded chunks which intersect the view frustum.
+/**
+ \param[in]  PVmatrix    Projection * View matrix of the camera.
+ \param[out] visible     Chunks to be drawn.
+*/
+void getVisibleTerrainChunks(const glm::mat4& PVmatrix, std::vector<const TerrainChunk*>& visible);
+
+/// Releases all chunks and waits for the running builds.
+void cleanupTerrainChunks();
+
+#endif // __TERRAIN_H
@@ -0,0 +1,32 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    transform.cpp
+ * \author  Sean Phay
+ * \date    2023
+ * \brief   Matrices passed to the shaders for one drawn object.
+ */
+//----------------------------------------------------------------------------------------
+
+#include "transform.h"
+
+void computeTransformMatrices(
+    const glm::mat4&   modelMatrix,
+    const glm::mat4&   viewMatrix,
+    const glm::mat4&   projectionMatrix,
+    TransformMatrices& matrices
+) {
+  matrices.PVM = projectionMatrix * viewMatrix * modelMatrix;
+
+  // just take 3x3 rotation part of the modelMatrix
+  // we presume the last row contains 0,0,0,1
+  const glm::mat4 modelRotationMatrix = glm::mat4(
+    modelMatrix[0],
+    modelMatrix[1],
+    modelMatrix[2],
+    glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)
+  );
+  matrices.normalMatrix = glm::transpose(glm::inverse(modelRotationMatrix));
+
+  //or an alternative single-line method: 
+  //glm::mat4 normalMatrix = glm::transpose(glm::inverse(glm::mat4(glm::mat3(modelRotationMatrix))));
+}
@@ -0,0 +1,36 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file    transform.h
+ * \author  Sean Phay
+ * \date    2023
+ * \brief   Matrices passed to the shaders for one drawn object.
+ */
+//----------------------------------------------------------------------------------------
+
+#ifndef __TRANSFORM_H
+#define __TRANSFORM_H
+
+#include <glm/glm.hpp>
+
+// matrices computed on the CPU for every drawn object
+typedef struct _TransformMatrices {
+  glm::mat4 PVM;            // projection * view * model
+  glm::mat4 normalMatrix;   // inverse transpose of the model rotation (non-rigid transforms)
+} TransformMatrices;
+
+//**************************************************************************************************
+/// Computes the matrices uploaded by setTransformUniforms().
+/**
+ \param[in]  modelMatrix       Model transformation of the object.
+ \param[in]  viewMatrix        View transformation of the camera.
+ \param[in]  projectionMatrix  Projection of the camera.
+ \param[out] matrices          Computed matrices.
+*/
+void computeTransformMatrices(
+    const glm::mat4&   modelMatrix,
+    const glm::mat4&   viewMatrix,
+    const glm::mat4&   projectionMatrix,
+    TransformMatrices& matrices
+);
+
+#endif // __TRANSFORM_H